@@ -0,0 +1,223 @@
+/**
+ * Decodes a DataSaverSPI flash dump into the standard flight CSV.
+ *
+ * Build (from the repository root):
+ *     g++ -std=c++11 -O2 -Iinclude data/decode_flight_log.cpp -o decode_flight_log
+ *
+ * Usage:
+ *     decode_flight_log dump.bin [-o flight.csv] [-t timestampName] [-s startOffset]
+ *                       [-m column=sensorName ...] [--series prefix]
+ *
+ *     -o         CSV to write (default: dump name with .csv)
+ *     -t         Name byte of TimestampRecord_t (default 0x7F)
+ *     -s         Offset of the log in the dump, i.e. DATA_START_ADDRESS for a full chip read
+ *     -m         Fill a CSV column (accelx ... temp) from a sensor name, or "none" to write 0
+ *     --series   Also write each sensor to <prefix>_<name>.csv as time,value
+ */
+
+#include "FlightLogDecoder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char* const COLUMN_NAMES[COLUMN_COUNT] = {"accelx", "accely", "accelz", "gyrox",
+                                                        "gyroy",  "gyroz",  "magx",   "magy",
+                                                        "magz",   "altitude", "pressure", "temp"};
+
+// The dump, memory-mapped where possible so it's never copied
+class DumpFile {
+public:
+    DumpFile() : data_(nullptr), size_(0), mapped_(false) {}
+
+    ~DumpFile() {
+#ifndef _WIN32
+        if (mapped_) {
+            munmap(const_cast<uint8_t*>(data_), size_);
+        }
+#endif
+    }
+
+    bool open(const char* path) {
+#ifndef _WIN32
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* map = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                madvise(map, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+                data_ = static_cast<const uint8_t*>(map);
+                size_ = static_cast<std::size_t>(info.st_size);
+                mapped_ = true;
+            }
+        }
+        close(fd);
+        if (mapped_) {
+            return true;
+        }
+#endif
+        std::FILE* file = std::fopen(path, "rb");
+        if (!file) {
+            return false;
+        }
+        uint8_t chunk[65536];
+        std::size_t n;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            buffer_.insert(buffer_.end(), chunk, chunk + n);
+        }
+        std::fclose(file);
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return true;
+    }
+
+    const uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_;
+    std::size_t size_;
+    bool mapped_;
+    std::vector<uint8_t> buffer_;
+};
+
+static void usage() {
+    std::fprintf(stderr,
+                 "usage: decode_flight_log dump.bin [-o flight.csv] [-t timestampName] [-s startOffset]\n"
+                 "                         [-m column=sensorName ...] [--series prefix]\n");
+}
+
+static bool parseMapping(const char* arg, FlightLogCsvMap& map) {
+    const char* equals = std::strchr(arg, '=');
+    if (!equals) {
+        return false;
+    }
+    const std::string column(arg, equals);
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        if (column == COLUMN_NAMES[c]) {
+            const int name = std::strcmp(equals + 1, "none") == 0
+                                 ? FlightLogCsvMap::UNMAPPED
+                                 : static_cast<int>(std::strtol(equals + 1, nullptr, 0));
+            map.map(static_cast<FlightLogColumn>(c), name);
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    const char* input = nullptr;
+    std::string output;
+    std::string seriesPrefix;
+    uint8_t timestampName = 0x7F;
+    std::size_t start = 0;
+    FlightLogCsvMap map;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "-t") == 0 && hasValue) {
+            timestampName = static_cast<uint8_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if (std::strcmp(argv[i], "-s") == 0 && hasValue) {
+            start = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if (std::strcmp(argv[i], "-m") == 0 && hasValue) {
+            if (!parseMapping(argv[++i], map)) {
+                std::fprintf(stderr, "bad mapping: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--series") == 0 && hasValue) {
+            seriesPrefix = argv[++i];
+        } else if (argv[i][0] != '-' && !input) {
+            input = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!input) {
+        usage();
+        return 1;
+    }
+    if (output.empty()) {
+        output = input;
+        const std::size_t dot = output.find_last_of('.');
+        const std::size_t slash = output.find_last_of("/\\");
+        if (dot != std::string::npos && (slash == std::string::npos || slash < dot)) {
+            output.erase(dot);
+        }
+        output += ".csv";
+    }
+
+    const std::chrono::steady_clock::time_point began = std::chrono::steady_clock::now();
+    DumpFile dump;
+    if (!dump.open(input)) {
+        std::fprintf(stderr, "can't read %s\n", input);
+        return 1;
+    }
+    if (start > dump.size()) {
+        std::fprintf(stderr, "start offset %lu is past the end of the dump\n", static_cast<unsigned long>(start));
+        return 1;
+    }
+
+    FlightLogDecoder decoder(timestampName);
+    const std::size_t decoded = decoder.decode(dump.data() + start, dump.size() - start);
+    const std::chrono::steady_clock::time_point parsed = std::chrono::steady_clock::now();
+
+    std::FILE* out = std::fopen(output.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "can't write %s\n", output.c_str());
+        return 1;
+    }
+    const std::size_t rows = writeFlightLogCsv(decoder, map, out);
+    std::fclose(out);
+
+    if (!seriesPrefix.empty()) {
+        for (int name = 0; name < 256; name++) {
+            const SensorSeries& series = decoder.getSeries(static_cast<uint8_t>(name));
+            if (series.size() == 0) {
+                continue;
+            }
+            const std::string path = seriesPrefix + "_" + std::to_string(name) + ".csv";
+            std::FILE* file = std::fopen(path.c_str(), "w");
+            if (!file) {
+                std::fprintf(stderr, "can't write %s\n", path.c_str());
+                return 1;
+            }
+            writeSensorSeriesCsv(series, file);
+            std::fclose(file);
+        }
+    }
+    const std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+
+    std::printf("%lu bytes decoded%s: %lu timestamp records, %lu data records\n",
+                static_cast<unsigned long>(decoded), decoder.isTruncated() ? " (last record truncated)" : "",
+                static_cast<unsigned long>(decoder.getTimestampRecordCount()),
+                static_cast<unsigned long>(decoder.getDataRecordCount()));
+    for (int name = 0; name < 256; name++) {
+        const SensorSeries& series = decoder.getSeries(static_cast<uint8_t>(name));
+        if (series.size() > 0) {
+            std::printf("  sensor %3d: %lu points, %lu..%lu ms\n", name, static_cast<unsigned long>(series.size()),
+                        static_cast<unsigned long>(series.timestamp_ms.front()),
+                        static_cast<unsigned long>(series.timestamp_ms.back()));
+        }
+    }
+    std::printf("%lu rows written to %s\n", static_cast<unsigned long>(rows), output.c_str());
+    std::printf("decode %.1f ms, total %.1f ms\n",
+                std::chrono::duration<double, std::milli>(parsed - began).count(),
+                std::chrono::duration<double, std::milli>(finished - began).count());
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef ARRAYSPAN_H
+#define ARRAYSPAN_H
+
+#include <cstddef>
+
+/**
+ * @brief A read-only view of contiguous elements (a minimal C++11 stand-in for std::span).
+ *
+ * Views never own their data and are invalidated by the next push to the
+ * array they came from.
+ */
+template <typename T>
+struct ArraySpan {
+    const T* data;
+    std::size_t size;
+
+    ArraySpan() : data(nullptr), size(0) {}
+    ArraySpan(const T* data, std::size_t size) : data(data), size(size) {}
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    const T& operator[](std::size_t index) const { return data[index]; }
+    bool empty() const { return size == 0; }
+};
+
+/**
+ * @brief The live contents of a ring as at most two contiguous segments, oldest to newest.
+ *
+ * first always holds the oldest element. second is empty unless the window
+ * wraps around the end of the storage. Loop over first then second to visit
+ * the window in time order without any per-element modulo.
+ */
+template <typename T>
+struct CircularView {
+    ArraySpan<T> first;
+    ArraySpan<T> second;
+
+    CircularView() {}
+    CircularView(ArraySpan<T> first, ArraySpan<T> second) : first(first), second(second) {}
+
+    std::size_t size() const { return first.size + second.size; }
+    bool empty() const { return size() == 0; }
+
+    /** @brief Element by age, 0 being the oldest. */
+    const T& operator[](std::size_t index) const {
+        return index < first.size ? first[index] : second[index - first.size];
+    }
+
+    /** @brief Copies the window, oldest first, into out (which must hold size() elements). */
+    void copyTo(T* out) const {
+        for (std::size_t i = 0; i < first.size; i++) {
+            out[i] = first[i];
+        }
+        for (std::size_t i = 0; i < second.size; i++) {
+            out[first.size + i] = second[i];
+        }
+    }
+};
+
+#endif  // ARRAYSPAN_H
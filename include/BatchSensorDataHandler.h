@@ -0,0 +1,122 @@
+#ifndef BATCHSENSORDATAHANDLER_H
+#define BATCHSENSORDATAHANDLER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SensorSaveFilter.h"
+#include "data_handling/DataPoint.h"
+#include "data_handling/DataSaver.h"
+
+/**
+ * @brief An IDataSaver that also accepts a block of DataPoints in one call.
+ *
+ * The default saveDataPoints() loops over saveDataPoint(), so any saver can
+ * derive from this and only override the batch path once it has a cheaper one
+ * (e.g. one buffer bounds check and one memcpy per block in DataSaverSPI).
+ */
+class IBatchDataSaver : public IDataSaver {
+public:
+    /**
+     * @brief Saves count DataPoints, oldest first, under the same sensor name.
+     * @return 0 on success, otherwise the first non-zero saveDataPoint() result.
+     */
+    virtual int saveDataPoints(const DataPoint* data, std::size_t count, uint8_t name) {
+        int result = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            const int status = saveDataPoint(data[i], name);
+            if (status != 0 && result == 0) {
+                result = status;
+            }
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief SensorDataHandler with a block entry point for FIFO-based sensors.
+ *
+ * addData(const DataPoint*, size_t) runs the whole block through the save
+ * policy (SensorSaveFilter: interval, optional decimation and deadband) in
+ * one pass. The survivors are then forwarded with a single saveDataPoints()
+ * call (one call per BATCH_SIZE survivors), instead of one interval check and
+ * one virtual call per sample.
+ *
+ * The single-sample addData() is kept so the handler is a drop-in replacement.
+ * When the saver is known at compile time, SensorDataHandlerT avoids the
+ * virtual calls altogether.
+ *
+ * Example:
+ *     BatchSensorDataHandler accelHandler(ACCELEROMETER_X, &dataSaver);
+ *     accelHandler.restrictSaveSpeed(39);              // 1 kHz in, 25 Hz logged
+ *     accelHandler.setDecimationMode(DECIMATE_AVERAGE);
+ *     accelHandler.addData(fifoSamples, fifoCount);
+ */
+class BatchSensorDataHandler : public SensorSaveFilter {
+public:
+    /** @brief Largest number of survivors forwarded in one saveDataPoints() call. */
+    static const std::size_t BATCH_SIZE = 32;
+
+    /**
+     * @param name Sensor name written with every saved DataPoint.
+     * @param ds   Where the kept samples are saved.
+     */
+    BatchSensorDataHandler(uint8_t name, IBatchDataSaver* ds)
+        : dataSaver_(ds), name_(name) {}
+
+    /**
+     * @brief Adds a single sample, exactly like SensorDataHandler::addData().
+     * @return The saver's status, or 0 if the sample was filtered out.
+     */
+    int addData(const DataPoint& data) {
+        DataPoint out;
+        if (!filter(data, out)) {
+            return 0;
+        }
+        const int status = dataSaver_->saveDataPoint(out, name_);
+        recordSaveResult(status, 1);
+        return status;
+    }
+
+    /**
+     * @brief Adds a block of samples, oldest first.
+     * @return 0 on success, otherwise the first non-zero saver status.
+     */
+    int addData(const DataPoint* data, std::size_t count) {
+        DataPoint kept[BATCH_SIZE];
+        std::size_t keptCount = 0;
+        int result = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            if (!filter(data[i], kept[keptCount])) {
+                continue;
+            }
+            keptCount++;
+            if (keptCount == BATCH_SIZE) {
+                result = mergeStatus(result, flush(kept, keptCount));
+                keptCount = 0;
+            }
+        }
+        if (keptCount > 0) {
+            result = mergeStatus(result, flush(kept, keptCount));
+        }
+        return result;
+    }
+
+    uint8_t getName() const { return name_; }
+
+private:
+    IBatchDataSaver* dataSaver_;
+    uint8_t name_;
+
+    int flush(const DataPoint* kept, std::size_t count) {
+        const int status = dataSaver_->saveDataPoints(kept, count, name_);
+        recordSaveResult(status, static_cast<uint32_t>(count));
+        return status;
+    }
+
+    static int mergeStatus(int result, int status) {
+        return result != 0 ? result : status;
+    }
+};
+
+#endif  // BATCHSENSORDATAHANDLER_H
@@ -0,0 +1,57 @@
+#ifndef CIRCULARINDEX_H
+#define CIRCULARINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/**
+ * @brief Picks the narrowest unsigned type that can index a ring of the given capacity.
+ *
+ * The head, size and max size of a ring never exceed Capacity, so a window of
+ * up to 255 elements keeps the 1-byte indices CircularArray has always used,
+ * a window of up to 65535 elements uses 2 bytes, and anything larger uses 4.
+ *
+ * Example:
+ *     CircularIndex<255>::type   -> uint8_t
+ *     CircularIndex<1000>::type  -> uint16_t
+ *     CircularIndex<70000>::type -> uint32_t
+ */
+template <std::size_t Capacity>
+struct CircularIndex {
+    typedef typename std::conditional<
+        (Capacity <= std::numeric_limits<uint8_t>::max()), uint8_t,
+        typename std::conditional<
+            (Capacity <= std::numeric_limits<uint16_t>::max()), uint16_t,
+            uint32_t>::type>::type type;
+};
+
+/**
+ * @brief Compile-time check that an explicitly chosen index type can hold Capacity.
+ */
+template <typename Index, std::size_t Capacity>
+struct CircularIndexFits {
+    static const bool value = std::is_unsigned<Index>::value &&
+        static_cast<unsigned long long>(Capacity) <=
+        static_cast<unsigned long long>(std::numeric_limits<Index>::max());
+};
+
+/**
+ * @brief Largest window, in bytes, that getMedian() may copy onto the stack.
+ *
+ * getMedian() selects the median from a copy of the window. A 4000-element
+ * DataPoint window would put 32 KB on the flight MCU's stack, so Arduino
+ * builds reject larger windows at compile time; pass a buffer to
+ * getMedian(scratch) instead. Native builds have megabytes of stack and no
+ * limit. Define this before including to choose another one.
+ */
+#ifndef CIRCULAR_MEDIAN_STACK_LIMIT
+#ifdef ARDUINO
+#define CIRCULAR_MEDIAN_STACK_LIMIT 1024
+#else
+#define CIRCULAR_MEDIAN_STACK_LIMIT 0x7FFFFFFF
+#endif
+#endif
+
+#endif  // CIRCULARINDEX_H
@@ -0,0 +1,220 @@
+#ifndef DATAPOINTCIRCULARARRAY_H
+#define DATAPOINTCIRCULARARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "ArraySpan.h"
+#include "SizedCircularArray.h"
+#include "data_handling/DataPoint.h"
+
+/**
+ * @brief Structure-of-arrays layout for SizedCircularArray<DataPoint, ...>.
+ *
+ * The generic array stores DataPoints interleaved (timestamp, value,
+ * timestamp, value, ...). Value-only scans such as medians, thresholds and
+ * sums then pull every timestamp through the cache and can't be vectorized.
+ * This specialization keeps timestamp_ms[] and data[] in two separate
+ * contiguous arrays and exposes each one as an ArraySpan. The hot loops can
+ * then run over plain floats.
+ *
+ * The push/getFromHead/getMedian vocabulary is unchanged. getFromHead()
+ * reassembles a DataPoint by value.
+ *
+ * The spans cover the live slots in storage order, not in time order. That is
+ * fine for order-insensitive scans (sum, min/max, threshold counts, medians).
+ */
+template <std::size_t Capacity, typename Index, typename Aggregates>
+class SizedCircularArray<DataPoint, Capacity, Index, Aggregates> : public Aggregates {
+    static_assert(Capacity > 0, "Capacity must be greater than 0");
+    static_assert(CircularIndexFits<Index, Capacity>::value,
+                  "Index type is too narrow for Capacity");
+
+public:
+    typedef DataPoint value_type;
+    typedef Index index_type;
+
+    /**
+     * @brief Constructs an empty array.
+     * @param maxSize The number of elements kept in the window. Must be <= Capacity.
+     */
+    explicit SizedCircularArray(Index maxSize = Capacity)
+        : maxSize_(maxSize), head_(0), size_(0)
+    {
+        assert(maxSize > 0 && maxSize <= Capacity);
+    }
+
+    /**
+     * @brief Pushes a value, overwriting the oldest one once the array is full.
+     */
+    void push(const DataPoint& value) {
+        if (size_ > 0) {
+            head_ = static_cast<Index>((head_ + 1U) % maxSize_);
+        }
+        if (size_ == maxSize_) {
+            const DataPoint evicted(timestamps_[head_], data_[head_]);
+            Aggregates::onPush(value, &evicted, maxSize_);
+        } else {
+            Aggregates::onPush(value, static_cast<const DataPoint*>(nullptr), maxSize_);
+        }
+        timestamps_[head_] = value.timestamp_ms;
+        data_[head_] = value.data;
+        if (size_ < maxSize_) {
+            size_++;
+        }
+        if (Aggregates::needsResync()) {
+            Aggregates::resync(*this);
+        }
+    }
+
+    /**
+     * @brief Pushes a block of DataPoints, oldest first, as if push() were called on each.
+     *
+     * The interleaved input has to be split, so this is two strided loops
+     * rather than block copies. Use the (timestamps, data) overload when the
+     * samples are already in separate arrays.
+     */
+    void pushN(const DataPoint* values, std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (!std::is_same<Aggregates, NoAggregates>::value) {
+            for (std::size_t i = 0; i < count; i++) {
+                push(values[i]);
+            }
+            return;
+        }
+        const circular_detail::BulkWrite plan =
+            circular_detail::planBulkWrite(head_, size_, maxSize_, count);
+        const DataPoint* source = values + plan.skip;
+        for (std::size_t i = 0; i < plan.firstCount; i++) {
+            timestamps_[plan.start + i] = source[i].timestamp_ms;
+            data_[plan.start + i] = source[i].data;
+        }
+        source += plan.firstCount;
+        for (std::size_t i = 0; i < plan.secondCount; i++) {
+            timestamps_[i] = source[i].timestamp_ms;
+            data_[i] = source[i].data;
+        }
+        head_ = static_cast<Index>(plan.newHead);
+        size_ = static_cast<Index>(plan.newSize);
+    }
+
+    /**
+     * @brief Pushes a block of samples held in separate arrays with at most two copies per array.
+     */
+    void pushN(const uint32_t* timestamps, const float* data, std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (!std::is_same<Aggregates, NoAggregates>::value) {
+            for (std::size_t i = 0; i < count; i++) {
+                push(DataPoint(timestamps[i], data[i]));
+            }
+            return;
+        }
+        const circular_detail::BulkWrite plan =
+            circular_detail::planBulkWrite(head_, size_, maxSize_, count);
+        copySegments(timestamps + plan.skip, timestamps_, plan);
+        copySegments(data + plan.skip, data_, plan);
+        head_ = static_cast<Index>(plan.newHead);
+        size_ = static_cast<Index>(plan.newSize);
+    }
+
+    /** @brief The values as at most two contiguous segments, oldest to newest. */
+    CircularView<float> getDataView() const {
+        return makeView(data_);
+    }
+
+    /** @brief The timestamps as at most two contiguous segments, oldest to newest. */
+    CircularView<uint32_t> getTimestampView() const {
+        return makeView(timestamps_);
+    }
+
+    /**
+     * @brief Gets an element relative to the newest one (0 is the newest).
+     */
+    DataPoint getFromHead(Index index) const {
+        const std::size_t slot = (static_cast<std::size_t>(head_) + maxSize_ - index) % maxSize_;
+        return DataPoint(timestamps_[slot], data_[slot]);
+    }
+
+    /**
+     * @brief Gets the median of the window by data (sorted index size/2), or DataPoint() if empty.
+     *
+     * The selection runs over the data array only, and the matching timestamp
+     * is looked up afterwards. The copy is on the stack, limited by
+     * CIRCULAR_MEDIAN_STACK_LIMIT; use getMedian(scratch) for large windows.
+     */
+    DataPoint getMedian() const {
+        static_assert(Capacity * sizeof(float) <= CIRCULAR_MEDIAN_STACK_LIMIT,
+                      "Window too large to copy onto the stack, use getMedian(scratch)");
+        float scratch[Capacity];
+        return getMedian(scratch);
+    }
+
+    /**
+     * @brief getMedian() using a caller-supplied buffer of at least getSize() floats.
+     */
+    DataPoint getMedian(float* scratch) const {
+        if (size_ == 0) {
+            return DataPoint();
+        }
+        std::copy(data_, data_ + size_, scratch);
+        float* middle = scratch + size_ / 2;
+        std::nth_element(scratch, middle, scratch + size_);
+        const float median = *middle;
+        std::size_t slot = 0;
+        while (slot + 1 < size_ && data_[slot] != median) {
+            slot++;
+        }
+        return DataPoint(timestamps_[slot], median);
+    }
+
+    /** @brief Contiguous view of the live values (storage order). */
+    ArraySpan<float> getDataSpan() const {
+        return ArraySpan<float>(data_, size_);
+    }
+
+    /** @brief Contiguous view of the live timestamps (storage order, parallel to getDataSpan()). */
+    ArraySpan<uint32_t> getTimestampSpan() const {
+        return ArraySpan<uint32_t>(timestamps_, size_);
+    }
+
+    Index getHead() const { return head_; }
+    Index getMaxSize() const { return maxSize_; }
+    Index getSize() const { return size_; }
+    bool isFull() const { return size_ == maxSize_; }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+        Aggregates::onClear();
+    }
+
+private:
+    uint32_t timestamps_[Capacity];
+    float data_[Capacity];
+    Index maxSize_;
+    Index head_;
+    Index size_;
+
+    template <typename U>
+    static void copySegments(const U* source, U* destination, const circular_detail::BulkWrite& plan) {
+        std::copy(source, source + plan.firstCount, destination + plan.start);
+        std::copy(source + plan.firstCount, source + plan.firstCount + plan.secondCount, destination);
+    }
+
+    template <typename U>
+    CircularView<U> makeView(const U* storage) const {
+        const circular_detail::Segments segments =
+            circular_detail::liveSegments(head_, size_, maxSize_);
+        return CircularView<U>(ArraySpan<U>(storage + segments.firstStart, segments.firstSize),
+                               ArraySpan<U>(storage, segments.secondSize));
+    }
+};
+
+#endif  // DATAPOINTCIRCULARARRAY_H
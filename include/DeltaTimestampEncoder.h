@@ -0,0 +1,121 @@
+#ifndef DELTATIMESTAMPENCODER_H
+#define DELTATIMESTAMPENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief LEB128-style unsigned varints: 7 bits per byte, low group first.
+ *
+ * Values below 128 take one byte; a uint32_t never takes more than five.
+ */
+namespace varint {
+
+static const std::size_t MAX_SIZE = 5;
+
+/** @brief Writes value into out (at least MAX_SIZE bytes). Returns bytes written. */
+inline std::size_t encode(uint32_t value, uint8_t* out) {
+    std::size_t n = 0;
+    while (value >= 0x80U) {
+        out[n++] = static_cast<uint8_t>(value | 0x80U);
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+/**
+ * @brief Reads a varint.
+ * @return Bytes consumed, or 0 if the input ended early or the varint is longer than MAX_SIZE.
+ */
+inline std::size_t decode(const uint8_t* in, std::size_t available, uint32_t& value) {
+    value = 0;
+    for (std::size_t n = 0; n < available && n < MAX_SIZE; n++) {
+        value |= static_cast<uint32_t>(in[n] & 0x7FU) << (7 * n);
+        if ((in[n] & 0x80U) == 0) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+}  // namespace varint
+
+/**
+ * @brief Writes log timestamps as small deltas instead of full TimestampRecord_ts.
+ *
+ * DataSaverSPI writes a 5-byte TimestampRecord_t {name, uint32_t} every
+ * time its timestamp interval elapses. At a steady rate the delta from the
+ * previous timestamp is tiny, so this encoder emits one of three records:
+ *
+ *   1 byte            0x80 | delta         delta < 127 ms (the usual case)
+ *   1 + 1..5 bytes    deltaName, varint    any forward delta
+ *   5 bytes           absoluteName, uint32 first timestamp, after resync(), or time going backwards
+ *
+ * The 1-byte form uses the top bit of the name byte, so sensor names must
+ * stay below 0x80 in this mode. It stops at 126 ms so it never writes 0xFF,
+ * which a reader takes for erased flash. The two record names are
+ * configurable so they can be kept clear of the sensor enum. An absolute
+ * record is written at every resync(). Call it at the start of each flash
+ * page so a reader can start decoding from any page.
+ *
+ * Multi-byte fields are little-endian, like the structs DataSaverSPI writes
+ * on the MCU.
+ */
+class DeltaTimestampEncoder {
+public:
+    static const uint8_t SHORT_DELTA_FLAG = 0x80;
+    /** @brief Largest delta of the 1-byte form; 0x7F would make the byte 0xFF (erased). */
+    static const uint32_t SHORT_DELTA_MAX = 0x7E;
+    /** @brief Longest record encodeTimestamp() can write. */
+    static const std::size_t MAX_RECORD_SIZE = 1 + varint::MAX_SIZE;
+
+    /**
+     * @param absoluteName Name byte of the full 32-bit timestamp record.
+     * @param deltaName    Name byte of the varint delta record.
+     */
+    DeltaTimestampEncoder(uint8_t absoluteName = 0x7F, uint8_t deltaName = 0x7E)
+        : absoluteName_(absoluteName), deltaName_(deltaName), lastTimestamp_ms_(0), synced_(false) {}
+
+    /**
+     * @brief Writes the record for timestamp_ms into out (at least MAX_RECORD_SIZE bytes).
+     * @return Bytes written.
+     */
+    std::size_t encodeTimestamp(uint32_t timestamp_ms, uint8_t* out) {
+        const uint32_t delta = timestamp_ms - lastTimestamp_ms_;
+        const bool forward = timestamp_ms >= lastTimestamp_ms_;
+        const bool absolute = !synced_ || !forward;
+        lastTimestamp_ms_ = timestamp_ms;
+        synced_ = true;
+
+        if (absolute) {
+            out[0] = absoluteName_;
+            out[1] = static_cast<uint8_t>(timestamp_ms);
+            out[2] = static_cast<uint8_t>(timestamp_ms >> 8);
+            out[3] = static_cast<uint8_t>(timestamp_ms >> 16);
+            out[4] = static_cast<uint8_t>(timestamp_ms >> 24);
+            return 5;
+        }
+        if (delta <= SHORT_DELTA_MAX) {
+            out[0] = static_cast<uint8_t>(SHORT_DELTA_FLAG | delta);
+            return 1;
+        }
+        out[0] = deltaName_;
+        return 1 + varint::encode(delta, out + 1);
+    }
+
+    /** @brief Makes the next timestamp an absolute record (e.g. at a page boundary). */
+    void resync() { synced_ = false; }
+
+    uint32_t getLastTimestamp() const { return lastTimestamp_ms_; }
+    uint8_t getAbsoluteName() const { return absoluteName_; }
+    uint8_t getDeltaName() const { return deltaName_; }
+
+private:
+    uint8_t absoluteName_;
+    uint8_t deltaName_;
+    uint32_t lastTimestamp_ms_;
+    bool synced_;
+};
+
+#endif  // DELTATIMESTAMPENCODER_H
@@ -0,0 +1,311 @@
+#ifndef DOUBLEBUFFEREDFLASHWRITER_H
+#define DOUBLEBUFFEREDFLASHWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Log writer that flushes to flash in bounded chunks instead of one blocking burst.
+ *
+ * DataSaverSPI appends records to a BUFFER_SIZE buffer. The saveDataPoint()
+ * call that fills the buffer writes all of it to flash before returning, so
+ * that one call pays the whole page-program latency and stalls the state
+ * machine. This writer has two buffers. write() appends to the active one.
+ * When it fills, the buffers swap and the full one is written out at most
+ * ChunkSize bytes at a time by service(). service() runs at the end of each
+ * write(), or from a background task if setBackgroundService(true) was called.
+ *
+ * ChunkSize therefore bounds the flash work done by any one call. With the
+ * default of one buffer per chunk, the whole buffer is written in one call,
+ * as DataSaverSPI does today. Smaller chunks spread a buffer over more calls.
+ * The buffer being filled must not fill again before the previous one has
+ * drained. If it does, write() returns false and the bytes are counted in
+ * getDroppedBytes(), rather than blocking.
+ *
+ * Chunks are issued as programs cut at the device's page boundaries
+ * (flash.pageSize()), so every program operation stays inside one page. A
+ * program that straddles two pages costs two page-program times. A chunk of
+ * one page size is then exactly one page program per call.
+ *
+ * Erase-ahead: by default the log region is expected to be erased before
+ * flight. With setEraseAhead(n), the writer tracks which sectors are erased.
+ * Each idle() call erases at most one sector, staying up to n sectors ahead
+ * of the write position. Call idle() from the main loop when it has slack, or
+ * from a background task. If a chunk reaches a sector that is not erased yet,
+ * the writer erases it inline and counts it in getInlineErases(). A non-zero
+ * count means idle() is not being called often enough. A failed erase is
+ * counted in getEraseErrors() and the sector stays unerased; a chunk that
+ * needed it is skipped and counted as a write error, rather than programmed
+ * over old data.
+ *
+ * Flash is any type with the Adafruit_SPIFlash calls used here:
+ *     uint32_t writeBuffer(uint32_t address, const uint8_t* data, uint32_t length);
+ *     bool eraseSector(uint32_t sectorNumber);   // SECTOR_SIZE bytes
+ *     uint16_t pageSize();
+ * writeBuffer() is expected to return the number of bytes written.
+ *
+ * @tparam Flash      Flash driver (Adafruit_SPIFlash, or a mock)
+ * @tparam BufferSize Bytes per buffer (two are allocated)
+ */
+template <typename Flash, std::size_t BufferSize = 256>
+class DoubleBufferedFlashWriter {
+    static_assert(BufferSize > 0, "BufferSize must be greater than 0");
+
+public:
+    /** @brief Erase granularity (SFLASH_SECTOR_SIZE in Adafruit_SPIFlash). */
+    static const uint32_t SECTOR_SIZE = 4096;
+
+    /**
+     * @param flash        The flash to write to.
+     * @param startAddress First byte of the log region.
+     * @param endAddress   One past the last byte of the log region.
+     */
+    DoubleBufferedFlashWriter(Flash& flash, uint32_t startAddress, uint32_t endAddress)
+        : flash_(flash), startAddress_(startAddress), endAddress_(endAddress),
+          chunkSize_(BufferSize), backgroundService_(false), pageSize_(0), eraseAheadSectors_(0)
+    {
+        reset();
+    }
+
+    /**
+     * @brief Maximum bytes written to flash per service() call.
+     */
+    void setChunkSize(std::size_t chunkSize) {
+        chunkSize_ = chunkSize == 0 ? 1 : (chunkSize > BufferSize ? BufferSize : chunkSize);
+    }
+
+    /**
+     * @brief If true, write() never touches flash; a background task must call service().
+     */
+    void setBackgroundService(bool background) { backgroundService_ = background; }
+
+    /**
+     * @brief Keep up to sectors sectors erased ahead of the write position (0 turns tracking off).
+     *
+     * With tracking on, every sector after the one holding the write position is
+     * treated as unerased.
+     */
+    void setEraseAhead(uint32_t sectors) {
+        eraseAheadSectors_ = sectors;
+        // The partly written sector at the write position is already erased
+        erasedUntil_ = sectorStart(nextWriteAddress_ + SECTOR_SIZE - 1);
+    }
+
+    /**
+     * @brief Idle-time work: erases the next sector if the erase-ahead window isn't full.
+     * @return true if a sector was erased.
+     */
+    bool idle() {
+        if (eraseAheadSectors_ == 0 || erasedUntil_ >= endAddress_ ||
+            erasedUntil_ >= nextWriteAddress_ + eraseAheadSectors_ * SECTOR_SIZE) {
+            return false;
+        }
+        if (!eraseNextSector()) {
+            return false;
+        }
+        backgroundErases_++;
+        return true;
+    }
+
+    /**
+     * @brief Appends bytes to the log. A record is never split across the two buffers.
+     * @return false if the bytes were dropped (both buffers busy, log region full, or too long).
+     */
+    bool write(const uint8_t* data, std::size_t length) {
+        bool accepted = false;
+        if (length <= BufferSize) {
+            if (fill_[active_] + length > BufferSize) {
+                swapBuffers();
+            }
+            if (fill_[active_] + length <= BufferSize && reserve(length)) {
+                std::memcpy(buffers_[active_] + fill_[active_], data, length);
+                fill_[active_] += length;
+                accepted = true;
+            }
+        }
+        if (!accepted) {
+            droppedBytes_ += length;
+        }
+        if (!backgroundService_) {
+            service();
+        }
+        return accepted;
+    }
+
+    /**
+     * @brief Writes at most one chunk of the buffer being drained.
+     *
+     * The chunk goes out as page-bounded programs. Once something has been
+     * written, the call stops rather than start a partial page program, so
+     * later calls begin on a page boundary.
+     *
+     * @return Bytes written to flash by this call.
+     */
+    std::size_t service() {
+        const int draining = 1 - active_;
+        std::size_t written = 0;
+        while (fill_[draining] > 0) {
+            const std::size_t remaining = fill_[draining] - drained_;
+            const std::size_t budget = chunkSize_ - written;
+            const std::size_t toPageEnd = pageSize() - nextWriteAddress_ % pageSize();
+            const std::size_t program = min3(remaining, budget, toPageEnd);
+            if (program == 0 || (written > 0 && program < remaining && program < toPageEnd)) {
+                break;
+            }
+            programChunk(draining, program);
+            written += program;
+        }
+        return written;
+    }
+
+    /**
+     * @brief Blocks until everything written so far is on flash (e.g. after landing).
+     */
+    void flush() {
+        while (service() > 0) {
+        }
+        if (fill_[active_] > 0) {
+            swapBuffers();
+            while (service() > 0) {
+            }
+        }
+    }
+
+    /** @brief Forgets all buffered data and restarts the log at startAddress. */
+    void reset() {
+        active_ = 0;
+        fill_[0] = 0;
+        fill_[1] = 0;
+        drained_ = 0;
+        nextWriteAddress_ = startAddress_;
+        reservedBytes_ = 0;
+        droppedBytes_ = 0;
+        writeErrors_ = 0;
+        eraseErrors_ = 0;
+        flushes_ = 0;
+        backgroundErases_ = 0;
+        inlineErases_ = 0;
+        setEraseAhead(eraseAheadSectors_);
+    }
+
+    /** @brief Flash address the next drained byte goes to. */
+    uint32_t getNextWriteAddress() const { return nextWriteAddress_; }
+
+    /** @brief Bytes accepted by write() that are not on flash yet. */
+    std::size_t getPendingBytes() const { return fill_[0] + fill_[1] - drained_; }
+
+    uint32_t getDroppedBytes() const { return droppedBytes_; }
+    uint32_t getWriteErrors() const { return writeErrors_; }
+
+    /** @brief eraseSector() calls that failed (erase-ahead only). */
+    uint32_t getEraseErrors() const { return eraseErrors_; }
+
+    /** @brief Number of buffers completely written out. */
+    uint32_t getBufferFlushes() const { return flushes_; }
+
+    /** @brief Sectors erased by idle(). */
+    uint32_t getBackgroundErases() const { return backgroundErases_; }
+
+    /** @brief Sectors that had to be erased inside a write() or service() call. */
+    uint32_t getInlineErases() const { return inlineErases_; }
+
+    /** @brief End of the erased region ahead of the write position (erase-ahead only). */
+    uint32_t getErasedUntil() const { return erasedUntil_; }
+
+    /** @brief True while a full buffer is still being written out. */
+    bool isDraining() const { return fill_[1 - active_] > 0; }
+
+private:
+    Flash& flash_;
+    uint32_t startAddress_;
+    uint32_t endAddress_;
+    std::size_t chunkSize_;
+    bool backgroundService_;
+    uint32_t pageSize_;           // read from the device on first use
+    uint32_t eraseAheadSectors_;
+    uint32_t erasedUntil_;        // [nextWriteAddress_, erasedUntil_) is erased
+    uint32_t backgroundErases_;
+    uint32_t inlineErases_;
+
+    uint8_t buffers_[2][BufferSize];
+    std::size_t fill_[2];
+    int active_;               // buffer that write() appends to
+    std::size_t drained_;      // bytes of the other buffer already on flash
+    uint32_t nextWriteAddress_;
+    uint32_t reservedBytes_;   // bytes handed to a buffer, on flash or not
+    uint32_t droppedBytes_;
+    uint32_t writeErrors_;
+    uint32_t eraseErrors_;
+    uint32_t flushes_;
+
+    // The driver only knows its page size after begin(), so ask lazily
+    uint32_t pageSize() {
+        if (pageSize_ == 0) {
+            pageSize_ = flash_.pageSize();
+            if (pageSize_ == 0) {
+                pageSize_ = 256;
+            }
+        }
+        return pageSize_;
+    }
+
+    static uint32_t sectorStart(uint32_t address) { return address - address % SECTOR_SIZE; }
+
+    // Only moves erasedUntil_ on if the erase succeeded
+    bool eraseNextSector() {
+        const uint32_t sector = sectorStart(erasedUntil_);
+        if (!flash_.eraseSector(sector / SECTOR_SIZE)) {
+            eraseErrors_++;
+            return false;
+        }
+        erasedUntil_ = sector + SECTOR_SIZE;
+        return true;
+    }
+
+    static std::size_t min3(std::size_t a, std::size_t b, std::size_t c) {
+        const std::size_t ab = a < b ? a : b;
+        return ab < c ? ab : c;
+    }
+
+    // Programs length bytes of the draining buffer, erasing first if needed
+    void programChunk(int draining, std::size_t length) {
+        bool erased = true;
+        while (erased && eraseAheadSectors_ > 0 && nextWriteAddress_ + length > erasedUntil_) {
+            erased = eraseNextSector();
+            inlineErases_ += erased ? 1 : 0;
+        }
+        const uint32_t written = erased ? flash_.writeBuffer(nextWriteAddress_, buffers_[draining] + drained_,
+                                                             static_cast<uint32_t>(length))
+                                        : 0;
+        if (written != length) {
+            writeErrors_++;
+        }
+        nextWriteAddress_ += static_cast<uint32_t>(length);
+        drained_ += length;
+        if (drained_ == fill_[draining]) {
+            fill_[draining] = 0;
+            drained_ = 0;
+            flushes_++;
+        }
+    }
+
+    // Hands the active buffer over to be drained, if the other one is free
+    void swapBuffers() {
+        if (fill_[active_] == 0 || isDraining()) {
+            return;
+        }
+        active_ = 1 - active_;
+    }
+
+    // Claims room for length more bytes in the log region, if there is any
+    bool reserve(std::size_t length) {
+        if (startAddress_ + reservedBytes_ + length > endAddress_) {
+            return false;
+        }
+        reservedBytes_ += static_cast<uint32_t>(length);
+        return true;
+    }
+};
+
+#endif  // DOUBLEBUFFEREDFLASHWRITER_H
@@ -0,0 +1,257 @@
+#ifndef FLIGHTLOGDECODER_H
+#define FLIGHTLOGDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief One sensor's decoded samples, as parallel arrays.
+ */
+struct SensorSeries {
+    std::vector<uint32_t> timestamp_ms;
+    std::vector<float> value;
+
+    std::size_t size() const { return value.size(); }
+};
+
+/**
+ * @brief Decodes a DataSaverSPI flash dump into per-sensor arrays (ground side).
+ *
+ * The dump is the stream DataSaverSPI writes from DATA_START_ADDRESS: 5-byte
+ * TimestampRecord_t {timestampName, uint32_t} whenever its timestamp
+ * interval has elapsed, and 5-byte Record_t {name, float} for every data
+ * point, all little-endian. Each data point gets the timestamp of the last
+ * TimestampRecord_t before it.
+ *
+ * Decoding stops at erased flash (a 0xFF name byte) or a record cut off by
+ * the end of the dump. It is two passes over the bytes: one counts each
+ * sensor's records so every array is allocated once, the other fills them.
+ *
+ * Host-side only (uses std::vector); see data/decode_flight_log.cpp.
+ *
+ * Example:
+ *     FlightLogDecoder decoder;
+ *     decoder.decode(dump, dumpSize);
+ *     const SensorSeries& altitude = decoder.getSeries(ALTITUDE);
+ */
+class FlightLogDecoder {
+public:
+    static const std::size_t RECORD_SIZE = 5;
+    static const uint8_t ERASED = 0xFF;
+
+    /**
+     * @param timestampName Name byte of TimestampRecord_t in this dump.
+     */
+    explicit FlightLogDecoder(uint8_t timestampName = 0x7F)
+        : timestampName_(timestampName), series_(256), timestampRecords_(0), dataRecords_(0),
+          decodedBytes_(0), lastTimestamp_ms_(0), truncated_(false) {}
+
+    /**
+     * @brief Decodes a dump, appending to the series decoded so far.
+     * @return Bytes decoded (where decoding stopped).
+     */
+    std::size_t decode(const uint8_t* log, std::size_t length) {
+        // Pass 1: find the end and count each sensor's records
+        std::size_t counts[256] = {0};
+        std::size_t end = 0;
+        while (end + RECORD_SIZE <= length && log[end] != ERASED) {
+            counts[log[end]]++;
+            end += RECORD_SIZE;
+        }
+        truncated_ = end < length && log[end] != ERASED;
+        timestampRecords_ += counts[timestampName_];
+
+        // Pass 2: fill arrays sized up front, through raw pointers
+        uint32_t* timestamps[256];
+        float* values[256];
+        for (std::size_t name = 0; name < 256; name++) {
+            timestamps[name] = nullptr;
+            values[name] = nullptr;
+            if (counts[name] == 0 || name == timestampName_) {
+                continue;
+            }
+            SensorSeries& series = series_[name];
+            const std::size_t previous = series.size();
+            series.timestamp_ms.resize(previous + counts[name]);
+            series.value.resize(previous + counts[name]);
+            timestamps[name] = &series.timestamp_ms[previous];
+            values[name] = &series.value[previous];
+            dataRecords_ += counts[name];
+        }
+        uint32_t timestamp = lastTimestamp_ms_;
+        for (std::size_t offset = 0; offset < end; offset += RECORD_SIZE) {
+            const uint8_t name = log[offset];
+            const uint32_t bits = readUint32(log + offset + 1);
+            if (name == timestampName_) {
+                timestamp = bits;
+                continue;
+            }
+            *timestamps[name]++ = timestamp;
+            std::memcpy(values[name]++, &bits, sizeof(float));
+        }
+        lastTimestamp_ms_ = timestamp;
+        decodedBytes_ += end;
+        return end;
+    }
+
+    /** @brief Everything decoded for a sensor (empty if it never appeared). */
+    const SensorSeries& getSeries(uint8_t name) const { return series_[name]; }
+
+    uint32_t getTimestampRecordCount() const { return static_cast<uint32_t>(timestampRecords_); }
+    uint32_t getDataRecordCount() const { return static_cast<uint32_t>(dataRecords_); }
+    std::size_t getDecodedBytes() const { return decodedBytes_; }
+
+    /** @brief True if the last decode() stopped at a partial record rather than erased flash. */
+    bool isTruncated() const { return truncated_; }
+
+    uint8_t getTimestampName() const { return timestampName_; }
+
+    void clear() {
+        for (std::size_t name = 0; name < series_.size(); name++) {
+            series_[name] = SensorSeries();
+        }
+        timestampRecords_ = 0;
+        dataRecords_ = 0;
+        decodedBytes_ = 0;
+        lastTimestamp_ms_ = 0;
+        truncated_ = false;
+    }
+
+private:
+    uint8_t timestampName_;
+    std::vector<SensorSeries> series_;
+    std::size_t timestampRecords_;
+    std::size_t dataRecords_;
+    std::size_t decodedBytes_;
+    uint32_t lastTimestamp_ms_;
+    bool truncated_;
+
+    static uint32_t readUint32(const uint8_t* in) {
+        return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+               (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+    }
+};
+
+/**
+ * @brief Data columns of the CSV format CSVDataProvider reads, after time.
+ */
+enum FlightLogColumn {
+    COLUMN_ACCEL_X,
+    COLUMN_ACCEL_Y,
+    COLUMN_ACCEL_Z,
+    COLUMN_GYRO_X,
+    COLUMN_GYRO_Y,
+    COLUMN_GYRO_Z,
+    COLUMN_MAG_X,
+    COLUMN_MAG_Y,
+    COLUMN_MAG_Z,
+    COLUMN_ALTITUDE,
+    COLUMN_PRESSURE,
+    COLUMN_TEMP,
+    COLUMN_COUNT,
+};
+
+/**
+ * @brief Which sensor name fills each CSV column.
+ *
+ * By default sensor name n fills column n (accelx = 0 ... temp = 11). Columns
+ * mapped to no sensor are written as 0.
+ */
+struct FlightLogCsvMap {
+    static const int UNMAPPED = -1;
+
+    int sensorOfColumn[COLUMN_COUNT];
+
+    FlightLogCsvMap() {
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            sensorOfColumn[c] = c;
+        }
+    }
+
+    void map(FlightLogColumn column, int sensorName) { sensorOfColumn[column] = sensorName; }
+
+    static const char* header() {
+        return "time,accelx,accely,accelz,gyrox,gyroy,gyroz,magx,magy,magz,altitude,pressure,temp\n";
+    }
+};
+
+/**
+ * @brief Writes decoded series as the standard flight CSV.
+ *
+ * One row per logged timestamp, from the first one at which every mapped
+ * sensor has a value, so CSVDataProvider never sees an empty cell. Each
+ * column holds its sensor's latest value at that time. Values are printed
+ * with 9 significant digits, which round-trips a float exactly.
+ *
+ * @return Rows written.
+ */
+inline std::size_t writeFlightLogCsv(const FlightLogDecoder& decoder, const FlightLogCsvMap& map, std::FILE* out) {
+    const SensorSeries* series[COLUMN_COUNT];
+    std::size_t next[COLUMN_COUNT];
+    float held[COLUMN_COUNT];
+    bool mapped[COLUMN_COUNT];
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        const int name = map.sensorOfColumn[c];
+        mapped[c] = name >= 0 && name < 256 && decoder.getSeries(static_cast<uint8_t>(name)).size() > 0;
+        series[c] = mapped[c] ? &decoder.getSeries(static_cast<uint8_t>(name)) : nullptr;
+        next[c] = 0;
+        held[c] = 0.0f;
+    }
+
+    std::fputs(FlightLogCsvMap::header(), out);
+    std::size_t rows = 0;
+    char line[COLUMN_COUNT * 18 + 16];
+    while (true) {
+        // The earliest timestamp not written yet, over all mapped columns
+        bool any = false;
+        uint32_t t = 0;
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            if (mapped[c] && next[c] < series[c]->size() && (!any || series[c]->timestamp_ms[next[c]] < t)) {
+                t = series[c]->timestamp_ms[next[c]];
+                any = true;
+            }
+        }
+        if (!any) {
+            break;
+        }
+        bool complete = true;
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            if (!mapped[c]) {
+                continue;
+            }
+            while (next[c] < series[c]->size() && series[c]->timestamp_ms[next[c]] == t) {
+                held[c] = series[c]->value[next[c]++];
+            }
+            complete = complete && next[c] > 0;
+        }
+        if (!complete) {
+            continue;
+        }
+        int n = std::snprintf(line, sizeof(line), "%lu", static_cast<unsigned long>(t));
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            n += std::snprintf(line + n, sizeof(line) - n, ",%.9g", static_cast<double>(held[c]));
+        }
+        line[n++] = '\n';
+        std::fwrite(line, 1, static_cast<std::size_t>(n), out);
+        rows++;
+    }
+    return rows;
+}
+
+/**
+ * @brief Writes one sensor's series as "time,value" rows.
+ * @return Rows written.
+ */
+inline std::size_t writeSensorSeriesCsv(const SensorSeries& series, std::FILE* out) {
+    std::fputs("time,value\n", out);
+    for (std::size_t i = 0; i < series.size(); i++) {
+        std::fprintf(out, "%lu,%.9g\n", static_cast<unsigned long>(series.timestamp_ms[i]),
+                     static_cast<double>(series.value[i]));
+    }
+    return series.size();
+}
+
+#endif  // FLIGHTLOGDECODER_H
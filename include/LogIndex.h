@@ -0,0 +1,248 @@
+#ifndef LOGINDEX_H
+#define LOGINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "PageLog.h"
+
+/**
+ * @brief Index records placed at fixed points of a page log, for seeking by timestamp.
+ *
+ * Pulling the seconds around apogee out of a multi-megabyte log otherwise
+ * means decoding it from the start. IndexedLogWriter puts an index record
+ * at the start of the page at every indexEveryBytes boundary of the log
+ * region. It holds the timestamp of the first record after it, the page's
+ * offset in the region, and the set of sensors logged since the previous
+ * index record. The records sit at known addresses, so LogIndexReader can
+ * binary-search them without parsing anything in between.
+ *
+ * Index record (little-endian), the first record of its page:
+ *     uint8_t  name          indexName (default 0x7C)
+ *     uint32_t timestamp_ms
+ *     uint32_t offset        page address - start of the log region
+ *     uint32_t sensorMask    bit n set if sensor name n (< 32) was logged
+ */
+namespace log_index {
+
+static const uint8_t DEFAULT_NAME = 0x7C;
+static const std::size_t RECORD_SIZE = 13;
+
+}  // namespace log_index
+
+struct LogIndexEntry {
+    uint32_t timestamp_ms;
+    uint32_t offset;
+    uint32_t sensorMask;
+
+    /** @brief Writes the record into out (log_index::RECORD_SIZE bytes). */
+    void encode(uint8_t name, uint8_t* out) const {
+        out[0] = name;
+        putUint32(timestamp_ms, out + 1);
+        putUint32(offset, out + 5);
+        putUint32(sensorMask, out + 9);
+    }
+
+    /** @brief Reads a record. Returns false if it doesn't start with name. */
+    bool decode(uint8_t name, const uint8_t* in) {
+        if (in[0] != name) {
+            return false;
+        }
+        timestamp_ms = getUint32(in + 1);
+        offset = getUint32(in + 5);
+        sensorMask = getUint32(in + 9);
+        return true;
+    }
+
+private:
+    static void putUint32(uint32_t value, uint8_t* out) {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+        out[2] = static_cast<uint8_t>(value >> 16);
+        out[3] = static_cast<uint8_t>(value >> 24);
+    }
+
+    static uint32_t getUint32(const uint8_t* in) {
+        return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+               (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+    }
+};
+
+/**
+ * @brief Writes records through a PageLogWriter and adds the index records.
+ *
+ * Example:
+ *     PageLogWriter<Adafruit_SPIFlash> log(flash, DATA_START_ADDRESS, flashSize);
+ *     log.resume(recoverPageLog<256>(flash, DATA_START_ADDRESS, flashSize));
+ *     IndexedLogWriter<Adafruit_SPIFlash> indexed(log, DATA_START_ADDRESS, 4096);
+ *     indexed.write(millis(), record, sizeof(record));   // record[0] is the sensor name
+ *
+ * @tparam Flash    Flash driver of the PageLogWriter
+ * @tparam PageSize Its page size
+ */
+template <typename Flash, std::size_t PageSize = 256>
+class IndexedLogWriter {
+public:
+    /**
+     * @param writer          Log the records go to.
+     * @param startAddress    Start of the log region (the writer's startAddress).
+     * @param indexEveryBytes Distance between index records, rounded down to whole pages.
+     * @param indexName       Name byte of the index record.
+     */
+    IndexedLogWriter(PageLogWriter<Flash, PageSize>& writer, uint32_t startAddress, uint32_t indexEveryBytes,
+                     uint8_t indexName = log_index::DEFAULT_NAME)
+        : writer_(writer), startAddress_(startAddress),
+          interval_(indexEveryBytes < PageSize ? PageSize : indexEveryBytes / PageSize * PageSize),
+          indexName_(indexName), sensorMask_(0), indexRecords_(0) {}
+
+    /**
+     * @brief Writes one record logged at timestamp_ms, preceded by an index record if one is due.
+     * @return PageLogWriter::write()'s result for the record.
+     */
+    bool write(uint32_t timestamp_ms, const uint8_t* record, std::size_t length) {
+        const std::size_t fill = writer_.getPageFill();
+        if (fill == 0 || fill + length > PageSize) {
+            // This record opens a page
+            const uint32_t page = fill == 0 ? writer_.getPageAddress() : writer_.getPageAddress() + PageSize;
+            if ((page - startAddress_) % interval_ == 0) {
+                LogIndexEntry entry;
+                entry.timestamp_ms = timestamp_ms;
+                entry.offset = page - startAddress_;
+                entry.sensorMask = sensorMask_;
+                uint8_t index[log_index::RECORD_SIZE];
+                entry.encode(indexName_, index);
+                // The index may fit where the record doesn't; it must open the page it points at
+                writer_.closePage();
+                if (writer_.write(index, sizeof(index))) {
+                    indexRecords_++;
+                }
+                sensorMask_ = 0;
+            }
+        }
+        if (length > 0 && record[0] < 32) {
+            sensorMask_ |= 1UL << record[0];
+        }
+        return writer_.write(record, length);
+    }
+
+    /** @brief Distance between index records in bytes. */
+    uint32_t getIndexInterval() const { return interval_; }
+
+    uint32_t getIndexRecordCount() const { return indexRecords_; }
+
+private:
+    PageLogWriter<Flash, PageSize>& writer_;
+    uint32_t startAddress_;
+    uint32_t interval_;
+    uint8_t indexName_;
+    uint32_t sensorMask_;
+    uint32_t indexRecords_;
+};
+
+/**
+ * @brief Finds the index record for a timestamp with O(log n) flash reads.
+ *
+ * Index slot k is the page at startAddress + k * indexEveryBytes. A slot whose
+ * page was torn or skipped holds no index record; the search looks at the
+ * next slot instead.
+ *
+ * Timestamps only increase within one session: after a reboot millis()
+ * starts again, so seek within the pages of one session.
+ *
+ * Example (ground tool):
+ *     PageLogRecovery log = recoverPageLog<256>(flash, DATA_START_ADDRESS, flashSize);
+ *     LogIndexReader<Flash> index(flash, DATA_START_ADDRESS, log.lastPageAddress + 256, 4096);
+ *     LogIndexEntry entry;
+ *     if (index.seek(apogee_ms - 5000, entry)) {
+ *         // decode pages from DATA_START_ADDRESS + entry.offset on
+ *     }
+ */
+template <typename Flash, std::size_t PageSize = 256>
+class LogIndexReader {
+public:
+    /**
+     * @param startAddress    Start of the log region.
+     * @param endAddress      End of the written log (e.g. the last page found by recoverPageLog(), plus a page).
+     * @param indexEveryBytes As given to IndexedLogWriter.
+     * @param indexName       As given to IndexedLogWriter.
+     */
+    LogIndexReader(Flash& flash, uint32_t startAddress, uint32_t endAddress, uint32_t indexEveryBytes,
+                   uint8_t indexName = log_index::DEFAULT_NAME)
+        : flash_(flash), startAddress_(startAddress),
+          interval_(indexEveryBytes < PageSize ? PageSize : indexEveryBytes / PageSize * PageSize),
+          slots_(endAddress > startAddress ? (endAddress - startAddress + interval_ - 1) / interval_ : 0),
+          indexName_(indexName), reads_(0) {}
+
+    /** @brief Index slots up to the end of the log. */
+    uint32_t getSlotCount() const { return slots_; }
+
+    /** @brief Reads the index record of slot. Returns false if the slot holds none. */
+    bool readEntry(uint32_t slot, LogIndexEntry& entry) {
+        if (slot >= slots_) {
+            return false;
+        }
+        uint8_t buffer[page_log::HEADER_SIZE + log_index::RECORD_SIZE];
+        flash_.readBuffer(startAddress_ + slot * interval_, buffer, sizeof(buffer));
+        reads_++;
+        uint32_t sequence = 0;
+        return page_log::parseHeader(buffer, sequence) &&
+               entry.decode(indexName_, buffer + page_log::HEADER_SIZE) &&
+               entry.offset == slot * interval_;
+    }
+
+    /**
+     * @brief Finds the last index record at or before timestamp_ms.
+     *
+     * Decoding from entry.offset then reaches timestamp_ms. If timestamp_ms is
+     * before the first record, the first one is returned.
+     *
+     * @return false if the log holds no index record.
+     */
+    bool seek(uint32_t timestamp_ms, LogIndexEntry& entry) {
+        // Every entry in a slot before lo is at or before timestamp_ms, every one from hi on is after it
+        bool found = false;
+        uint32_t lo = 0;
+        uint32_t hi = slots_;
+        while (lo < hi) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            uint32_t slot = mid;
+            LogIndexEntry candidate;
+            if (nextEntry(slot, hi, candidate) && candidate.timestamp_ms <= timestamp_ms) {
+                entry = candidate;
+                found = true;
+                lo = slot + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (found) {
+            return true;
+        }
+        // timestamp_ms precedes every record: start from the first one
+        uint32_t slot = 0;
+        return nextEntry(slot, slots_, entry);
+    }
+
+    /** @brief readBuffer() calls made so far. */
+    uint32_t getReadCount() const { return reads_; }
+
+private:
+    Flash& flash_;
+    uint32_t startAddress_;
+    uint32_t interval_;
+    uint32_t slots_;
+    uint8_t indexName_;
+    uint32_t reads_;
+
+    // First slot from slot on (before limit) holding an index record
+    bool nextEntry(uint32_t& slot, uint32_t limit, LogIndexEntry& entry) {
+        for (; slot < limit; slot++) {
+            if (readEntry(slot, entry)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif  // LOGINDEX_H
@@ -0,0 +1,212 @@
+#ifndef MEDIANCIRCULARARRAY_H
+#define MEDIANCIRCULARARRAY_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "CircularIndex.h"
+
+/**
+ * @brief A CircularArray that keeps its median up to date on every push.
+ *
+ * CircularArray::getMedian() copies and sorts the whole window on every call.
+ * This class has the same push/getFromHead vocabulary, but it also keeps the
+ * window split across two indexed heaps:
+ *  - a max-heap holding the lower floor(n/2) values
+ *  - a min-heap holding the upper ceil(n/2) values
+ *
+ * Each ring slot remembers which heap it lives in and where, so the value that
+ * falls out of the window can be replaced in place. A push costs O(log n) and
+ * getMedian() costs O(1).
+ *
+ * The median matches CircularArray::getMedian(): the element at sorted index
+ * n/2 (the upper median for even sizes), or T() when the array is empty.
+ * T only needs operator<, so DataPoint is ordered by its data field.
+ *
+ * Ring and heap indices use Index, which defaults to the narrowest type that
+ * fits Capacity (see CircularIndex).
+ */
+template <typename T, std::size_t Capacity,
+          typename Index = typename CircularIndex<Capacity>::type>
+class MedianCircularArray {
+    static_assert(Capacity > 0, "Capacity must be greater than 0");
+    static_assert(CircularIndexFits<Index, Capacity>::value,
+                  "Index type is too narrow for Capacity");
+
+public:
+    typedef T value_type;
+    typedef Index index_type;
+
+    /**
+     * @brief Constructs an empty array.
+     * @param maxSize The number of elements kept in the window. Must be <= Capacity.
+     */
+    explicit MedianCircularArray(Index maxSize = Capacity)
+        : maxSize_(maxSize), head_(0), size_(0), lowSize_(0), highSize_(0)
+    {
+        assert(maxSize > 0 && maxSize <= Capacity);
+    }
+
+    /**
+     * @brief Pushes a value, overwriting the oldest one once the array is full.
+     */
+    void push(const T& value) {
+        if (size_ > 0) {
+            head_ = static_cast<Index>((head_ + 1U) % maxSize_);
+        }
+        const Index slot = head_;
+        values_[slot] = value;
+
+        if (size_ == maxSize_) {
+            // The slot still sits in a heap with the evicted value: fix it in place.
+            const bool inLow = inLow_[slot];
+            siftUp(inLow, siftDown(inLow, heapPos_[slot]));
+            // At most one value is now on the wrong side of the split.
+            if (lowSize_ > 0 && values_[high_[0]] < values_[low_[0]]) {
+                const Index lowTop = low_[0];
+                const Index highTop = high_[0];
+                place(true, 0, highTop);
+                place(false, 0, lowTop);
+                siftDown(true, 0);
+                siftDown(false, 0);
+            }
+            return;
+        }
+
+        size_++;
+        if (lowSize_ > 0 && value < values_[low_[0]]) {
+            heapPush(true, slot);
+        } else {
+            heapPush(false, slot);
+        }
+
+        // Keep floor(n/2) values in the lower heap.
+        const Index lowTarget = static_cast<Index>(size_ / 2);
+        while (lowSize_ > lowTarget) {
+            heapPush(false, heapPopTop(true));
+        }
+        while (lowSize_ < lowTarget) {
+            heapPush(true, heapPopTop(false));
+        }
+    }
+
+    /**
+     * @brief Gets an element relative to the newest one (0 is the newest).
+     */
+    T getFromHead(Index index) const {
+        return values_[(static_cast<std::size_t>(head_) + maxSize_ - index) % maxSize_];
+    }
+
+    /**
+     * @brief Gets the median of the window in constant time.
+     * @return The element at sorted index size/2, or T() if the array is empty.
+     */
+    T getMedian() const {
+        if (size_ == 0) {
+            return T();
+        }
+        return values_[high_[0]];
+    }
+
+    Index getHead() const { return head_; }
+    Index getMaxSize() const { return maxSize_; }
+    Index getSize() const { return size_; }
+    bool isFull() const { return size_ == maxSize_; }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+        lowSize_ = 0;
+        highSize_ = 0;
+    }
+
+private:
+    // Both heaps need one spare slot for the transient state inside push().
+    static const std::size_t kHeapCapacity = Capacity / 2 + 2;
+
+    T values_[Capacity];
+    Index low_[kHeapCapacity];    // max-heap of slot indices
+    Index high_[kHeapCapacity];   // min-heap of slot indices
+    Index heapPos_[Capacity];     // position of each slot inside its heap
+    bool inLow_[Capacity];        // which heap each slot is in
+
+    Index maxSize_;
+    Index head_;
+    Index size_;
+    Index lowSize_;
+    Index highSize_;
+
+    Index* heap(bool low) { return low ? low_ : high_; }
+    Index& heapSize(bool low) { return low ? lowSize_ : highSize_; }
+
+    // True when slot a belongs above slot b in the given heap.
+    bool outranks(bool low, Index a, Index b) const {
+        return low ? values_[b] < values_[a] : values_[a] < values_[b];
+    }
+
+    void place(bool low, Index pos, Index slot) {
+        heap(low)[pos] = slot;
+        heapPos_[slot] = pos;
+        inLow_[slot] = low;
+    }
+
+    Index siftUp(bool low, Index pos) {
+        Index* h = heap(low);
+        const Index slot = h[pos];
+        while (pos > 0) {
+            const Index parent = static_cast<Index>((pos - 1) / 2);
+            if (!outranks(low, slot, h[parent])) {
+                break;
+            }
+            place(low, pos, h[parent]);
+            pos = parent;
+        }
+        place(low, pos, slot);
+        return pos;
+    }
+
+    Index siftDown(bool low, Index pos) {
+        Index* h = heap(low);
+        const Index n = heapSize(low);
+        const Index slot = h[pos];
+        for (;;) {
+            const std::size_t left = 2 * static_cast<std::size_t>(pos) + 1;
+            if (left >= n) {
+                break;
+            }
+            std::size_t best = left;
+            if (left + 1 < n && outranks(low, h[left + 1], h[left])) {
+                best = left + 1;
+            }
+            if (!outranks(low, h[best], slot)) {
+                break;
+            }
+            place(low, pos, h[best]);
+            pos = static_cast<Index>(best);
+        }
+        place(low, pos, slot);
+        return pos;
+    }
+
+    void heapPush(bool low, Index slot) {
+        Index& n = heapSize(low);
+        place(low, n, slot);
+        n++;
+        siftUp(low, static_cast<Index>(n - 1));
+    }
+
+    Index heapPopTop(bool low) {
+        Index* h = heap(low);
+        Index& n = heapSize(low);
+        const Index top = h[0];
+        n--;
+        if (n > 0) {
+            place(low, 0, h[n]);
+            siftDown(low, 0);
+        }
+        return top;
+    }
+};
+
+#endif  // MEDIANCIRCULARARRAY_H
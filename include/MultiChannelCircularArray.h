@@ -0,0 +1,178 @@
+#ifndef MULTICHANNELCIRCULARARRAY_H
+#define MULTICHANNELCIRCULARARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "ArraySpan.h"
+#include "CircularIndex.h"
+#include "data_handling/DataPoint.h"
+
+/**
+ * @brief Ring of multi-channel samples: one timestamp plus Channels floats per slot.
+ *
+ * An AccelerationTriplet is three DataPoints that all carry the same
+ * timestamp. Keeping IMU history as three CircularArray<DataPoint> rings
+ * therefore stores that timestamp three times and lets the axes drift apart
+ * if one push is skipped. Here a slot is written by a single push(), so the
+ * channels of a sample always stay together, and the timestamp is stored once.
+ *
+ * LaunchDetector, FastLaunchDetector and VerticalVelocityEstimator can share
+ * one MultiChannelCircularArray<3, N> of accelerometer history and read the
+ * axis (or the squared magnitude) they need from it.
+ *
+ * Channel values of a slot are contiguous, so getSampleFromHead() returns a
+ * pointer to Channels floats with no copy.
+ *
+ * Example:
+ *     MultiChannelCircularArray<3, 100> imu(100);
+ *     imu.push(xDp, yDp, zDp);                 // same layout as AccelerationTriplet
+ *     float acl2 = imu.getMagnitudeSquaredFromHead(0);
+ *     DataPoint z = imu.getChannelFromHead(0, 2);
+ */
+template <std::size_t Channels, std::size_t Capacity,
+          typename Index = typename CircularIndex<Capacity>::type>
+class MultiChannelCircularArray {
+    static_assert(Channels > 0, "Channels must be greater than 0");
+    static_assert(Capacity > 0, "Capacity must be greater than 0");
+    static_assert(CircularIndexFits<Index, Capacity>::value,
+                  "Index type is too narrow for Capacity");
+
+public:
+    typedef Index index_type;
+
+    static const std::size_t kChannels = Channels;
+
+    /**
+     * @brief Constructs an empty array.
+     * @param maxSize The number of samples kept in the window. Must be <= Capacity.
+     */
+    explicit MultiChannelCircularArray(Index maxSize = Capacity)
+        : maxSize_(maxSize), head_(0), size_(0)
+    {
+        assert(maxSize > 0 && maxSize <= Capacity);
+    }
+
+    /**
+     * @brief Pushes one sample, overwriting the oldest once the array is full.
+     * @param values Channels floats, in channel order.
+     */
+    void push(uint32_t timestamp_ms, const float* values) {
+        if (size_ > 0) {
+            head_ = static_cast<Index>((head_ + 1U) % maxSize_);
+        }
+        timestamps_[head_] = timestamp_ms;
+        std::copy(values, values + Channels, data_[head_]);
+        if (size_ < maxSize_) {
+            size_++;
+        }
+    }
+
+    /**
+     * @brief Pushes the three axes of an AccelerationTriplet-style sample.
+     *
+     * Only available for 3-channel arrays. The x timestamp is stored for the
+     * slot; the three DataPoints are expected to come from the same reading.
+     */
+    void push(const DataPoint& x, const DataPoint& y, const DataPoint& z) {
+        static_assert(Channels == 3, "push(x, y, z) needs a 3-channel array");
+        const float values[3] = {x.data, y.data, z.data};
+        push(x.timestamp_ms, values);
+    }
+
+    /** @brief Timestamp of a sample relative to the newest one (0 is the newest). */
+    uint32_t getTimestampFromHead(Index index) const {
+        return timestamps_[slotFromHead(index)];
+    }
+
+    /** @brief One channel of a sample relative to the newest one (0 is the newest). */
+    float getFromHead(Index index, std::size_t channel) const {
+        assert(channel < Channels);
+        return data_[slotFromHead(index)][channel];
+    }
+
+    /** @brief One channel of a sample as a DataPoint, for code written against CircularArray. */
+    DataPoint getChannelFromHead(Index index, std::size_t channel) const {
+        const std::size_t slot = slotFromHead(index);
+        assert(channel < Channels);
+        return DataPoint(timestamps_[slot], data_[slot][channel]);
+    }
+
+    /** @brief All channels of a sample (0 is the newest) as a span into the ring. */
+    ArraySpan<float> getSampleFromHead(Index index) const {
+        return ArraySpan<float>(data_[slotFromHead(index)], Channels);
+    }
+
+    /** @brief Sum of the squares of every channel of a sample (0 is the newest). */
+    float getMagnitudeSquaredFromHead(Index index) const {
+        const float* sample = data_[slotFromHead(index)];
+        float sum = 0.0f;
+        for (std::size_t c = 0; c < Channels; c++) {
+            sum += sample[c] * sample[c];
+        }
+        return sum;
+    }
+
+    /**
+     * @brief Median of one channel over the window (sorted index size/2), or 0 if empty.
+     *
+     * O(n) with a Capacity-sized float copy on the stack, like SizedCircularArray::getMedian(),
+     * limited by CIRCULAR_MEDIAN_STACK_LIMIT. Use getChannelMedian(channel, scratch) for large windows.
+     */
+    float getChannelMedian(std::size_t channel) const {
+        static_assert(Capacity * sizeof(float) <= CIRCULAR_MEDIAN_STACK_LIMIT,
+                      "Window too large to copy onto the stack, use getChannelMedian(channel, scratch)");
+        float scratch[Capacity];
+        return getChannelMedian(channel, scratch);
+    }
+
+    /**
+     * @brief getChannelMedian() using a caller-supplied buffer of at least getSize() floats.
+     */
+    float getChannelMedian(std::size_t channel, float* scratch) const {
+        assert(channel < Channels);
+        if (size_ == 0) {
+            return 0.0f;
+        }
+        for (std::size_t i = 0; i < size_; i++) {
+            scratch[i] = data_[i][channel];
+        }
+        float* middle = scratch + size_ / 2;
+        std::nth_element(scratch, middle, scratch + size_);
+        return *middle;
+    }
+
+    Index getHead() const { return head_; }
+    Index getMaxSize() const { return maxSize_; }
+    Index getSize() const { return size_; }
+    bool isFull() const { return size_ == maxSize_; }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+private:
+    std::size_t slotFromHead(Index index) const {
+        return (static_cast<std::size_t>(head_) + maxSize_ - index) % maxSize_;
+    }
+
+    uint32_t timestamps_[Capacity];
+    float data_[Capacity][Channels];
+    Index maxSize_;
+    Index head_;
+    Index size_;
+};
+
+template <std::size_t Channels, std::size_t Capacity, typename Index>
+const std::size_t MultiChannelCircularArray<Channels, Capacity, Index>::kChannels;
+
+/**
+ * @brief Three-axis accelerometer history, one slot per AccelerationTriplet.
+ */
+template <std::size_t Capacity>
+using AccelerationCircularArray = MultiChannelCircularArray<3, Capacity>;
+
+#endif  // MULTICHANNELCIRCULARARRAY_H
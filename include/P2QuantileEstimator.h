@@ -0,0 +1,196 @@
+#ifndef P2QUANTILEESTIMATOR_H
+#define P2QUANTILEESTIMATOR_H
+
+#include <cmath>
+#include <cstdint>
+
+#include "StateSnapshot.h"
+#include "data_handling/DataPoint.h"
+
+/**
+ * @brief Streaming quantile estimate in constant memory (the P² algorithm).
+ *
+ * Windowed medians need the whole window in RAM, which rules them out for
+ * statistics over a multi-minute pad hold. P² (Jain & Chlamtac, 1985) tracks
+ * one quantile with five markers whose heights are nudged by a parabolic
+ * fit on every sample. Memory and per-sample work are constant no matter how
+ * long the stream runs.
+ *
+ * The first five samples are kept exactly. After that getQuantile() is an
+ * estimate that converges as samples accumulate. It is well suited to smooth
+ * sensor noise distributions (median acceleration, 90th percentile baro noise).
+ *
+ * Example:
+ *     P2QuantileEstimator p90(0.9f);
+ *     p90.push(DataPoint(t, accelMagnitude));
+ *     float noise = p90.getQuantile();
+ */
+class P2QuantileEstimator {
+public:
+    /**
+     * @param quantile The quantile to track, in (0, 1). 0.5 is the median.
+     */
+    explicit P2QuantileEstimator(float quantile)
+        : p_(quantile)
+    {
+        reset();
+    }
+
+    /** @brief Adds a sample (only the data field is used). */
+    void push(const DataPoint& dp) { push(dp.data); }
+
+    /** @brief Adds a sample. */
+    void push(float value) {
+        if (count_ < kMarkers) {
+            // Insertion sort the first five samples straight into the markers
+            int i = static_cast<int>(count_);
+            while (i > 0 && heights_[i - 1] > value) {
+                heights_[i] = heights_[i - 1];
+                i--;
+            }
+            heights_[i] = value;
+            count_++;
+            return;
+        }
+
+        // Find the cell the sample falls in, extending the extremes if needed
+        int cell;
+        if (value < heights_[0]) {
+            heights_[0] = value;
+            cell = 0;
+        } else if (value >= heights_[kMarkers - 1]) {
+            heights_[kMarkers - 1] = value;
+            cell = kMarkers - 2;
+        } else {
+            cell = 0;
+            while (value >= heights_[cell + 1]) {
+                cell++;
+            }
+        }
+
+        for (int i = cell + 1; i < kMarkers; i++) {
+            positions_[i] += 1.0;
+        }
+        for (int i = 0; i < kMarkers; i++) {
+            desired_[i] += increments_[i];
+        }
+        count_++;
+
+        // Move the three middle markers toward their desired positions
+        for (int i = 1; i < kMarkers - 1; i++) {
+            const double offset = desired_[i] - positions_[i];
+            if ((offset >= 1.0 && positions_[i + 1] - positions_[i] > 1.0) ||
+                (offset <= -1.0 && positions_[i - 1] - positions_[i] < -1.0)) {
+                const double step = offset >= 0.0 ? 1.0 : -1.0;
+                float candidate = parabolic(i, step);
+                if (!(heights_[i - 1] < candidate && candidate < heights_[i + 1])) {
+                    candidate = linear(i, step);
+                }
+                heights_[i] = candidate;
+                positions_[i] += step;
+            }
+        }
+    }
+
+    /**
+     * @brief The current quantile estimate, or 0 if no samples were pushed.
+     *
+     * Exact (nearest rank) while fewer than five samples have been seen.
+     */
+    float getQuantile() const {
+        if (count_ == 0) {
+            return 0.0f;
+        }
+        if (count_ < kMarkers) {
+            const uint32_t rank = static_cast<uint32_t>(std::floor(p_ * static_cast<float>(count_ - 1) + 0.5f));
+            return heights_[rank];
+        }
+        return heights_[2];
+    }
+
+    /** @brief Smallest sample seen, or 0 if none. */
+    float getMin() const { return count_ == 0 ? 0.0f : heights_[0]; }
+
+    /** @brief Largest sample seen, or 0 if none. */
+    float getMax() const {
+        if (count_ == 0) {
+            return 0.0f;
+        }
+        return count_ < kMarkers ? heights_[count_ - 1] : heights_[kMarkers - 1];
+    }
+
+    float getTargetQuantile() const { return p_; }
+    uint32_t getCount() const { return count_; }
+
+    /** @brief Appends the estimator state to a snapshot. */
+    bool save(SnapshotWriter& writer) const {
+        return writer.write(p_) && writer.write(count_) && writer.write(heights_) &&
+               writer.write(positions_) && writer.write(desired_);
+    }
+
+    /**
+     * @brief Restores state written by save().
+     *
+     * Fails without changing anything if the snapshot tracked a different quantile.
+     */
+    bool restore(SnapshotReader& reader) {
+        float p = 0.0f;
+        if (!reader.read(p) || p != p_) {
+            return false;
+        }
+        P2QuantileEstimator restored(p_);
+        if (!reader.read(restored.count_) || !reader.read(restored.heights_) ||
+            !reader.read(restored.positions_) || !reader.read(restored.desired_)) {
+            return false;
+        }
+        *this = restored;
+        return true;
+    }
+
+    void reset() {
+        count_ = 0;
+        for (int i = 0; i < kMarkers; i++) {
+            heights_[i] = 0.0f;
+            positions_[i] = static_cast<double>(i + 1);
+        }
+        const double p = p_;
+        desired_[0] = 1.0;
+        desired_[1] = 1.0 + 2.0 * p;
+        desired_[2] = 1.0 + 4.0 * p;
+        desired_[3] = 3.0 + 2.0 * p;
+        desired_[4] = 5.0;
+        increments_[0] = 0.0;
+        increments_[1] = p / 2.0;
+        increments_[2] = p;
+        increments_[3] = (1.0 + p) / 2.0;
+        increments_[4] = 1.0;
+    }
+
+private:
+    static const int kMarkers = 5;
+
+    float p_;
+    uint32_t count_;
+    // Positions are doubles so they stay exact past 2^24 samples (~4.6 h at 1 kHz)
+    float heights_[kMarkers];      // marker heights (q)
+    double positions_[kMarkers];   // actual marker positions (n)
+    double desired_[kMarkers];     // desired marker positions (n')
+    double increments_[kMarkers];  // desired position increment per sample (dn')
+
+    float parabolic(int i, double step) const {
+        const double n0 = positions_[i - 1];
+        const double n1 = positions_[i];
+        const double n2 = positions_[i + 1];
+        return static_cast<float>(heights_[i] + step / (n2 - n0) *
+            ((n1 - n0 + step) * (heights_[i + 1] - heights_[i]) / (n2 - n1) +
+             (n2 - n1 - step) * (heights_[i] - heights_[i - 1]) / (n1 - n0)));
+    }
+
+    float linear(int i, double step) const {
+        const int j = step > 0.0 ? i + 1 : i - 1;
+        return static_cast<float>(heights_[i] +
+            step * (heights_[j] - heights_[i]) / (positions_[j] - positions_[i]));
+    }
+};
+
+#endif  // P2QUANTILEESTIMATOR_H
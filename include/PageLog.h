@@ -0,0 +1,357 @@
+#ifndef PAGELOG_H
+#define PAGELOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Flash log made of self-describing pages, so boot can binary-search for the end.
+ *
+ * DataSaverSPI finds where it left off by scanning the chip from the start,
+ * which gets slower the more has been logged. Here every page starts with a
+ * header carrying a sequence number that grows by one per page. Pages are
+ * written in order, so "page i holds sequence first + i" is true up to the
+ * last written page and false after it, and the end of the log can be found
+ * with O(log n) header reads (see recoverPageLog()).
+ *
+ * Page header (little-endian):
+ *     uint8_t  marker    0xA5
+ *     uint32_t sequence
+ *     uint8_t  crc8      of marker and sequence
+ *     uint8_t  commit    0xFF while the page is open, 0x00 once it is full
+ *     uint8_t  reserved  0xFF
+ *
+ * The commit byte is programmed after the rest of the page (NOR flash can
+ * clear bits without an erase). A page without it was cut off by a power
+ * loss; its data is kept, but the log resumes on the next page. A header
+ * torn by a power loss fails its CRC; that page is skipped.
+ *
+ * Records never straddle a page, so any page can be decoded on its own. The
+ * unused tail of a page stays erased (0xFF), so a record must not start with
+ * a 0xFF byte.
+ */
+namespace page_log {
+
+static const uint8_t MARKER = 0xA5;
+static const std::size_t HEADER_SIZE = 8;
+static const std::size_t COMMIT_OFFSET = 6;
+static const uint8_t COMMITTED = 0x00;
+
+/** @brief CRC-8 (polynomial 0x07). */
+inline uint8_t crc8(const uint8_t* data, std::size_t length) {
+    uint8_t crc = 0;
+    for (std::size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = static_cast<uint8_t>((crc & 0x80U) ? (crc << 1) ^ 0x07U : crc << 1);
+        }
+    }
+    return crc;
+}
+
+/** @brief Writes an open page header into out (HEADER_SIZE bytes). */
+inline void encodeHeader(uint32_t sequence, uint8_t* out) {
+    out[0] = MARKER;
+    out[1] = static_cast<uint8_t>(sequence);
+    out[2] = static_cast<uint8_t>(sequence >> 8);
+    out[3] = static_cast<uint8_t>(sequence >> 16);
+    out[4] = static_cast<uint8_t>(sequence >> 24);
+    out[5] = crc8(out, 5);
+    out[COMMIT_OFFSET] = 0xFF;
+    out[7] = 0xFF;
+}
+
+/**
+ * @brief Reads a page header.
+ * @return false if the marker or CRC doesn't match (erased or torn page).
+ */
+inline bool parseHeader(const uint8_t* in, uint32_t& sequence) {
+    if (in[0] != MARKER || crc8(in, 5) != in[5]) {
+        return false;
+    }
+    sequence = static_cast<uint32_t>(in[1]) | (static_cast<uint32_t>(in[2]) << 8) |
+               (static_cast<uint32_t>(in[3]) << 16) | (static_cast<uint32_t>(in[4]) << 24);
+    return true;
+}
+
+inline bool isCommitted(const uint8_t* header) { return header[COMMIT_OFFSET] == COMMITTED; }
+
+}  // namespace page_log
+
+/**
+ * @brief Where a page log ends, as found by recoverPageLog().
+ */
+struct PageLogRecovery {
+    bool found;                  ///< False if no valid page header was found at the start
+    uint32_t firstPageAddress;   ///< First valid page (after any torn ones at the start)
+    uint32_t firstSequence;      ///< Its sequence number
+    uint32_t lastPageAddress;    ///< Last page of the log
+    uint32_t lastPageUsedBytes;  ///< Bytes of that page up to its last non-0xFF byte, header included (a lower bound)
+    bool lastPageCommitted;      ///< False if power was lost while it was open
+    uint32_t tornPagesSkipped;   ///< Pages after it that aren't erased, skipped on resume
+    uint32_t nextWriteAddress;   ///< Where PageLogWriter::resume() continues
+    uint32_t nextSequence;       ///< Sequence number for the page at nextWriteAddress
+    uint32_t flashReads;         ///< readBuffer() calls made
+};
+
+namespace page_log {
+
+/** @brief Torn pages in a row that recovery looks past. */
+static const uint32_t MAX_TORN_PAGES = 4;
+
+enum PageState {
+    PAGE_BLANK,  ///< Header fully erased
+    PAGE_TORN,   ///< Partly programmed header
+    PAGE_VALID,  ///< Marker and CRC match
+};
+
+template <typename Flash>
+PageState readPageState(Flash& flash, uint32_t address, uint32_t& sequence, PageLogRecovery& result) {
+    uint8_t header[HEADER_SIZE];
+    flash.readBuffer(address, header, HEADER_SIZE);
+    result.flashReads++;
+    if (parseHeader(header, sequence)) {
+        return PAGE_VALID;
+    }
+    for (std::size_t i = 0; i < HEADER_SIZE; i++) {
+        if (header[i] != 0xFF) {
+            return PAGE_TORN;
+        }
+    }
+    return PAGE_BLANK;
+}
+
+// True if page index belongs to the log starting at page first. A torn page
+// does if an intact page of the log follows it (power was lost while opening
+// it and the log resumed after it).
+template <std::size_t PageSize, typename Flash>
+bool isLogPage(Flash& flash, uint32_t startAddress, uint32_t pages, uint32_t first, uint32_t index,
+               PageLogRecovery& result) {
+    for (uint32_t i = index; i < pages && i <= index + MAX_TORN_PAGES; i++) {
+        uint32_t sequence = 0;
+        const PageState state = readPageState(flash, startAddress + i * PageSize, sequence, result);
+        if (state != PAGE_TORN) {
+            return state == PAGE_VALID && sequence == result.firstSequence + (i - first);
+        }
+    }
+    return false;
+}
+
+}  // namespace page_log
+
+/**
+ * @brief Finds the end of a page log with a binary search over page headers.
+ *
+ * Reads about log2(pages) headers plus the last page, instead of every page.
+ * Pages left over from an older log are told apart by their sequence number,
+ * as long as the new log started at a higher one (resume() and
+ * begin(recovery.nextSequence) both guarantee that). Pages whose header was
+ * torn by a power loss are skipped, up to page_log::MAX_TORN_PAGES in a row.
+ *
+ * Records carry no length, so lastPageUsedBytes is found by trimming the
+ * erased tail of the last page. It is a lower bound: a record whose last
+ * bytes are 0xFF (e.g. a NaN float) looks shorter than it is. The records
+ * themselves are all still on the page, and resume() never writes to it.
+ *
+ * Flash needs Adafruit_SPIFlash's
+ *     uint32_t readBuffer(uint32_t address, uint8_t* data, uint32_t length);
+ *
+ * @param startAddress First byte of the log region (page aligned).
+ * @param endAddress   One past the last byte of the log region.
+ */
+template <std::size_t PageSize, typename Flash>
+PageLogRecovery recoverPageLog(Flash& flash, uint32_t startAddress, uint32_t endAddress) {
+    PageLogRecovery result;
+    std::memset(&result, 0, sizeof(result));
+    result.nextWriteAddress = startAddress;
+
+    const uint32_t pages = (endAddress - startAddress) / PageSize;
+    uint32_t first = 0;
+    page_log::PageState state = page_log::PAGE_BLANK;
+    for (; first < pages && first <= page_log::MAX_TORN_PAGES; first++) {
+        state = page_log::readPageState(flash, startAddress + first * PageSize, result.firstSequence, result);
+        if (state != page_log::PAGE_TORN) {
+            break;
+        }
+    }
+    if (state != page_log::PAGE_VALID) {
+        // Empty log, after any pages torn while opening it
+        result.tornPagesSkipped = first;
+        result.nextWriteAddress = startAddress + first * PageSize;
+        return result;
+    }
+    result.found = true;
+    result.firstPageAddress = startAddress + first * PageSize;
+
+    // Page lo is part of the log, page hi (or the end of the region) isn't
+    uint32_t lo = first;
+    uint32_t hi = pages;
+    while (hi - lo > 1) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (page_log::isLogPage<PageSize>(flash, startAddress, pages, first, mid, result)) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    uint8_t page[PageSize];
+    result.lastPageAddress = startAddress + lo * PageSize;
+    flash.readBuffer(result.lastPageAddress, page, PageSize);
+    result.flashReads++;
+    result.lastPageCommitted = page_log::isCommitted(page);
+    uint32_t used = PageSize;
+    while (used > page_log::HEADER_SIZE && page[used - 1] == 0xFF) {
+        used--;
+    }
+    result.lastPageUsedBytes = used;
+
+    // Power lost while opening the next page leaves it partly programmed. A
+    // torn header can still pass its CRC by chance (then its sequence is
+    // wrong), so only a fully erased page is safe to resume on.
+    uint32_t next = lo + 1;
+    uint32_t sequence = 0;
+    while (next < pages && result.tornPagesSkipped < page_log::MAX_TORN_PAGES &&
+           page_log::readPageState(flash, startAddress + next * PageSize, sequence, result) != page_log::PAGE_BLANK) {
+        next++;
+        result.tornPagesSkipped++;
+    }
+    result.nextWriteAddress = startAddress + next * PageSize;
+    result.nextSequence = result.firstSequence + (next - first);
+    return result;
+}
+
+/**
+ * @brief Appends records to a page log (see page_log) on flash.
+ *
+ * write() collects records in a page buffer. The page is programmed when the
+ * next record doesn't fit, then committed. flush() programs what has been
+ * collected so far without committing, e.g. before a risky phase.
+ *
+ * The pages written to must be erased beforehand. Nothing is written until
+ * begin() or resume() says where the log starts: begin(recovery.nextSequence)
+ * for a new log over an old one, so recovery can't mistake the old pages for
+ * part of it.
+ *
+ * Flash needs Adafruit_SPIFlash's
+ *     uint32_t writeBuffer(uint32_t address, const uint8_t* data, uint32_t length);
+ *
+ * @tparam Flash    Flash driver (Adafruit_SPIFlash, or a mock)
+ * @tparam PageSize Bytes per flash page
+ */
+template <typename Flash, std::size_t PageSize = 256>
+class PageLogWriter {
+    static_assert(PageSize > page_log::HEADER_SIZE, "PageSize must be larger than the page header");
+
+public:
+    /** @brief Largest record write() accepts. */
+    static const std::size_t PAYLOAD_SIZE = PageSize - page_log::HEADER_SIZE;
+
+    /**
+     * @param startAddress First byte of the log region (page aligned).
+     * @param endAddress   One past the last byte of the log region.
+     */
+    PageLogWriter(Flash& flash, uint32_t startAddress, uint32_t endAddress)
+        : flash_(flash), startAddress_(startAddress), endAddress_(endAddress), pageAddress_(startAddress),
+          sequence_(0), fill_(0), programmed_(0), droppedBytes_(0), writeErrors_(0), started_(false) {}
+
+    /** @brief Starts a new log at startAddress whose first page has the given sequence number. */
+    void begin(uint32_t firstSequence) { restart(startAddress_, firstSequence); }
+
+    /** @brief Continues the log found at boot, or starts one if none was found. */
+    void resume(const PageLogRecovery& recovery) { restart(recovery.nextWriteAddress, recovery.nextSequence); }
+
+    /**
+     * @brief Appends one record; it is never split across pages.
+     * @return false if the record was dropped (too long, not started, or the log region is full).
+     */
+    bool write(const uint8_t* data, std::size_t length) {
+        if (!started_ || length == 0 || length > PAYLOAD_SIZE) {
+            droppedBytes_ += length;
+            return false;
+        }
+        if (fill_ + length > PageSize) {
+            closePage();
+        }
+        if (fill_ == 0) {
+            if (pageAddress_ + PageSize > endAddress_) {
+                droppedBytes_ += length;
+                return false;
+            }
+            page_log::encodeHeader(sequence_, page_);
+            fill_ = page_log::HEADER_SIZE;
+        }
+        std::memcpy(page_ + fill_, data, length);
+        fill_ += length;
+        return true;
+    }
+
+    /** @brief Programs the records collected so far. The page stays open. */
+    void flush() {
+        if (fill_ > programmed_) {
+            program(pageAddress_ + programmed_, page_ + programmed_, fill_ - programmed_);
+            programmed_ = fill_;
+        }
+    }
+
+    /** @brief Programs and commits the page being filled, so the next record opens a new one. */
+    void closePage() {
+        if (fill_ == 0) {
+            return;
+        }
+        flush();
+        const uint8_t commit = page_log::COMMITTED;
+        program(pageAddress_ + page_log::COMMIT_OFFSET, &commit, 1);
+        pageAddress_ += PageSize;
+        sequence_++;
+        fill_ = 0;
+        programmed_ = 0;
+    }
+
+    /** @brief Flash address of the page being filled. */
+    uint32_t getPageAddress() const { return pageAddress_; }
+
+    /** @brief Sequence number of the page being filled. */
+    uint32_t getSequence() const { return sequence_; }
+
+    /** @brief Bytes used in the page being filled, header included (0 if no page is open). */
+    std::size_t getPageFill() const { return fill_; }
+
+    uint32_t getDroppedBytes() const { return droppedBytes_; }
+    uint32_t getWriteErrors() const { return writeErrors_; }
+
+private:
+    Flash& flash_;
+    uint32_t startAddress_;
+    uint32_t endAddress_;
+    uint32_t pageAddress_;
+    uint32_t sequence_;
+    uint8_t page_[PageSize];
+    std::size_t fill_;        // 0 while no page is open
+    std::size_t programmed_;  // bytes of page_ already on flash
+    uint32_t droppedBytes_;
+    uint32_t writeErrors_;
+    bool started_;            // set by begin() or resume()
+
+    void restart(uint32_t address, uint32_t sequence) {
+        pageAddress_ = address;
+        sequence_ = sequence;
+        fill_ = 0;
+        programmed_ = 0;
+        droppedBytes_ = 0;
+        writeErrors_ = 0;
+        started_ = true;
+    }
+
+    void program(uint32_t address, const uint8_t* data, std::size_t length) {
+        if (flash_.writeBuffer(address, data, static_cast<uint32_t>(length)) != length) {
+            writeErrors_++;
+        }
+    }
+};
+
+template <typename Flash, std::size_t PageSize>
+const std::size_t PageLogWriter<Flash, PageSize>::PAYLOAD_SIZE;
+
+#endif  // PAGELOG_H
@@ -0,0 +1,274 @@
+#ifndef QUANTIZEDRECORD_H
+#define QUANTIZEDRECORD_H
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Per-sensor fixed-point encoding: value = offset + code * scale.
+ *
+ * DataSaverSPI's Record_t spends a 4-byte float on every value, but a
+ * channel like acceleration (+-16 g) or battery voltage needs far fewer
+ * significant bits. A descriptor maps a channel's physical range onto an
+ * unsigned code of 2-16 bits. The worst-case error is scale / 2 inside the
+ * range. Values outside the range are clamped to the nearest end.
+ *
+ * The top code (all ones) is reserved for NaN, so a dropped reading survives
+ * a round trip as NaN and is not mistaken for a real value.
+ *
+ * Example:
+ *     // -160..+160 m/s^2 in 12 bits: ~0.08 m/s^2 steps
+ *     const QuantizationDescriptor accel = QuantizationDescriptor::forRange(-160.0f, 160.0f, 12);
+ *     uint16_t code = accel.encode(ax);
+ *     float back = accel.decode(code);
+ */
+struct QuantizationDescriptor {
+    float scale;   ///< Physical units per code step
+    float offset;  ///< Physical value of code 0
+    uint8_t bits;  ///< Code width, 2-16
+
+    /** @brief Largest code representing a number (the one above it means NaN). */
+    uint16_t maxCode() const { return static_cast<uint16_t>((1UL << bits) - 2U); }
+
+    /** @brief The code reserved for NaN. */
+    uint16_t nanCode() const { return static_cast<uint16_t>((1UL << bits) - 1U); }
+
+    /**
+     * @brief Builds a descriptor covering [min, max] with the given width.
+     */
+    static QuantizationDescriptor forRange(float min, float max, uint8_t bits) {
+        assert(bits >= 2 && bits <= 16 && max > min);
+        QuantizationDescriptor descriptor;
+        descriptor.bits = bits;
+        descriptor.offset = min;
+        descriptor.scale = (max - min) / static_cast<float>((1UL << bits) - 2U);
+        return descriptor;
+    }
+
+    /** @brief Rounds value to the nearest code, clamping to the range. */
+    uint16_t encode(float value) const {
+        if (std::isnan(value)) {
+            return nanCode();
+        }
+        const float steps = (value - offset) / scale + 0.5f;
+        if (!(steps > 0.0f)) {
+            return 0;
+        }
+        const float top = static_cast<float>(maxCode());
+        return steps >= top ? maxCode() : static_cast<uint16_t>(steps);
+    }
+
+    float decode(uint16_t code) const {
+        if (code == nanCode()) {
+            return NAN;
+        }
+        return offset + static_cast<float>(code) * scale;
+    }
+};
+
+/**
+ * @brief Sensor name -> descriptor lookup for up to Capacity sensors.
+ *
+ * Sensors without a descriptor are stored at full precision by the encoders
+ * below, so quantization can be rolled out one channel at a time.
+ */
+template <std::size_t Capacity>
+class QuantizationTable {
+public:
+    QuantizationTable() : size_(0) {}
+
+    /** @brief Adds or replaces the descriptor for name. Returns false when full. */
+    bool set(uint8_t name, const QuantizationDescriptor& descriptor) {
+        for (std::size_t i = 0; i < size_; i++) {
+            if (names_[i] == name) {
+                descriptors_[i] = descriptor;
+                return true;
+            }
+        }
+        if (size_ == Capacity) {
+            return false;
+        }
+        names_[size_] = name;
+        descriptors_[size_] = descriptor;
+        size_++;
+        return true;
+    }
+
+    /** @brief The descriptor for name, or nullptr if the sensor is not quantized. */
+    const QuantizationDescriptor* find(uint8_t name) const {
+        for (std::size_t i = 0; i < size_; i++) {
+            if (names_[i] == name) {
+                return &descriptors_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    std::size_t getSize() const { return size_; }
+
+private:
+    uint8_t names_[Capacity];
+    QuantizationDescriptor descriptors_[Capacity];
+    std::size_t size_;
+};
+
+/**
+ * @brief Compact replacement for Record_t: the sensor name plus a 2-byte code.
+ *
+ * A quantized record is 3 bytes, {name, code (little-endian uint16)}, instead
+ * of Record_t's 5. Unquantized sensors fall back to the 5-byte {name, float}
+ * layout, so the decoder needs the same table as the encoder to know which one
+ * it is reading.
+ */
+namespace quantized_record {
+
+static const std::size_t QUANTIZED_SIZE = 3;
+static const std::size_t FULL_SIZE = 5;
+static const std::size_t MAX_SIZE = FULL_SIZE;
+
+/**
+ * @brief Writes one record into out (at least MAX_SIZE bytes).
+ * @return Bytes written.
+ */
+template <std::size_t Capacity>
+std::size_t encode(const QuantizationTable<Capacity>& table, uint8_t name, float value, uint8_t* out) {
+    out[0] = name;
+    const QuantizationDescriptor* descriptor = table.find(name);
+    if (descriptor == nullptr) {
+        uint32_t bits;
+        static_assert(sizeof(bits) == sizeof(value), "float must be 32 bits");
+        std::memcpy(&bits, &value, sizeof(bits));
+        out[1] = static_cast<uint8_t>(bits);
+        out[2] = static_cast<uint8_t>(bits >> 8);
+        out[3] = static_cast<uint8_t>(bits >> 16);
+        out[4] = static_cast<uint8_t>(bits >> 24);
+        return FULL_SIZE;
+    }
+    const uint16_t code = descriptor->encode(value);
+    out[1] = static_cast<uint8_t>(code);
+    out[2] = static_cast<uint8_t>(code >> 8);
+    return QUANTIZED_SIZE;
+}
+
+/**
+ * @brief Reads one record written by encode().
+ * @return Bytes consumed, or 0 if fewer than that were available.
+ */
+template <std::size_t Capacity>
+std::size_t decode(const QuantizationTable<Capacity>& table, const uint8_t* in, std::size_t available,
+                   uint8_t& name, float& value) {
+    if (available < 1) {
+        return 0;
+    }
+    name = in[0];
+    const QuantizationDescriptor* descriptor = table.find(name);
+    if (descriptor == nullptr) {
+        if (available < FULL_SIZE) {
+            return 0;
+        }
+        const uint32_t bits = static_cast<uint32_t>(in[1]) | (static_cast<uint32_t>(in[2]) << 8) |
+                              (static_cast<uint32_t>(in[3]) << 16) | (static_cast<uint32_t>(in[4]) << 24);
+        std::memcpy(&value, &bits, sizeof(value));
+        return FULL_SIZE;
+    }
+    if (available < QUANTIZED_SIZE) {
+        return 0;
+    }
+    value = descriptor->decode(static_cast<uint16_t>(in[1] | (in[2] << 8)));
+    return QUANTIZED_SIZE;
+}
+
+}  // namespace quantized_record
+
+/**
+ * @brief Packs codes of arbitrary width back to back, LSB first.
+ *
+ * For telemetry frames, where a fixed set of channels is sent together and
+ * the sensor names are implied by position: e.g. three 12-bit accel axes and
+ * an 8-bit temperature fit in 6 bytes instead of 16.
+ */
+class BitPacker {
+public:
+    BitPacker(uint8_t* buffer, std::size_t capacity)
+        : buffer_(buffer), capacity_(capacity), bitOffset_(0), ok_(true) {}
+
+    /** @brief Appends the low bits of code. Returns false (and stops) on overflow. */
+    bool write(uint32_t code, uint8_t bits) {
+        if (!ok_ || bitOffset_ + bits > capacity_ * 8) {
+            ok_ = false;
+            return false;
+        }
+        for (uint8_t i = 0; i < bits; i++) {
+            const std::size_t byte = bitOffset_ >> 3;
+            const uint8_t mask = static_cast<uint8_t>(1U << (bitOffset_ & 7U));
+            if ((code >> i) & 1U) {
+                buffer_[byte] |= mask;
+            } else {
+                buffer_[byte] &= static_cast<uint8_t>(~mask);
+            }
+            bitOffset_++;
+        }
+        return true;
+    }
+
+    /** @brief Quantizes value with descriptor and appends its code. */
+    bool write(const QuantizationDescriptor& descriptor, float value) {
+        return write(descriptor.encode(value), descriptor.bits);
+    }
+
+    /** @brief Bytes used so far (a partial last byte counts). */
+    std::size_t getSize() const { return (bitOffset_ + 7) / 8; }
+    bool ok() const { return ok_; }
+
+private:
+    uint8_t* buffer_;
+    std::size_t capacity_;
+    std::size_t bitOffset_;
+    bool ok_;
+};
+
+/**
+ * @brief Reads codes written by BitPacker, in the same order and widths.
+ */
+class BitUnpacker {
+public:
+    BitUnpacker(const uint8_t* buffer, std::size_t length)
+        : buffer_(buffer), length_(length), bitOffset_(0), ok_(true) {}
+
+    bool read(uint32_t& code, uint8_t bits) {
+        if (!ok_ || bitOffset_ + bits > length_ * 8) {
+            ok_ = false;
+            return false;
+        }
+        code = 0;
+        for (uint8_t i = 0; i < bits; i++) {
+            if ((buffer_[bitOffset_ >> 3] >> (bitOffset_ & 7U)) & 1U) {
+                code |= 1UL << i;
+            }
+            bitOffset_++;
+        }
+        return true;
+    }
+
+    bool read(const QuantizationDescriptor& descriptor, float& value) {
+        uint32_t code = 0;
+        if (!read(code, descriptor.bits)) {
+            return false;
+        }
+        value = descriptor.decode(static_cast<uint16_t>(code));
+        return true;
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    const uint8_t* buffer_;
+    std::size_t length_;
+    std::size_t bitOffset_;
+    bool ok_;
+};
+
+#endif  // QUANTIZEDRECORD_H
@@ -0,0 +1,210 @@
+#ifndef RUNNINGAGGREGATES_H
+#define RUNNINGAGGREGATES_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "SizedCircularArray.h"
+#include "data_handling/DataPoint.h"
+
+/**
+ * @brief Maps an element type to the scalar that the aggregates are taken over.
+ *
+ * Arithmetic types aggregate themselves; DataPoint aggregates its data field
+ * (the same field CircularArray::getMedian() orders by).
+ */
+template <typename T>
+struct AggregateValue {
+    typedef T type;
+    static type get(const T& value) { return value; }
+};
+
+template <>
+struct AggregateValue<DataPoint> {
+    typedef float type;
+    static type get(const DataPoint& value) { return value.data; }
+};
+
+/**
+ * @brief Aggregate policy that keeps window statistics up to date on every push.
+ *
+ * Plug it into SizedCircularArray (or use AggregatingCircularArray) to get
+ * constant-time getters instead of rescanning the window each tick:
+ *  - sum and sum of squares, updated by adding the new value and subtracting the evicted one
+ *  - min and max, from monotonic deques of (value, sequence number)
+ *
+ * The sums are kept in double, relative to a shift taken from the window, so
+ * a large offset such as 101325 Pa does not cancel out the variance. Adding
+ * and subtracting still drifts, and a NaN or Inf never subtracts back out, so
+ * the sums are recomputed from the window once per window length of
+ * evictions and whenever a non-finite value is evicted. That is O(window)
+ * work amortized over as many pushes. Each deque holds at most Capacity
+ * entries.
+ */
+template <typename T, std::size_t Capacity>
+class RunningAggregates {
+public:
+    typedef typename AggregateValue<T>::type value_type;
+
+    RunningAggregates() { onClear(); }
+
+    /** @brief Number of values currently in the window. */
+    std::size_t getCount() const { return count_; }
+
+    double getSum() const { return sum_ + shift_ * static_cast<double>(count_); }
+
+    /** @brief Mean of the window, or 0 if it is empty. */
+    double getMean() const {
+        return count_ == 0 ? 0.0 : shift_ + sum_ / static_cast<double>(count_);
+    }
+
+    /** @brief Population variance of the window, or 0 if it is empty. */
+    double getVariance() const {
+        if (count_ == 0) {
+            return 0.0;
+        }
+        const double n = static_cast<double>(count_);
+        const double variance = (sumSquares_ - sum_ * sum_ / n) / n;
+        return variance > 0.0 ? variance : 0.0;
+    }
+
+    /** @brief Smallest value in the window, or value_type() if it is empty. */
+    value_type getMin() const { return minDeque_.front(); }
+
+    /** @brief Largest value in the window, or value_type() if it is empty. */
+    value_type getMax() const { return maxDeque_.front(); }
+
+    void onPush(const T& element, const T* evicted, std::size_t windowSize) {
+        const value_type value = AggregateValue<T>::get(element);
+        const double asDouble = static_cast<double>(value);
+        if (count_ == 0 && std::isfinite(asDouble)) {
+            shift_ = asDouble;
+        }
+        const double shifted = asDouble - shift_;
+        sum_ += shifted;
+        sumSquares_ += shifted * shifted;
+        if (evicted != nullptr) {
+            const double old = static_cast<double>(AggregateValue<T>::get(*evicted));
+            sum_ -= old - shift_;
+            sumSquares_ -= (old - shift_) * (old - shift_);
+            evictions_++;
+            if (!std::isfinite(old) || evictions_ >= windowSize) {
+                resyncDue_ = true;
+            }
+        } else {
+            count_++;
+        }
+
+        sequence_++;
+        minDeque_.push(value, sequence_, windowSize, false);
+        maxDeque_.push(value, sequence_, windowSize, true);
+    }
+
+    /** @brief True when the sums are due to be recomputed with resync(). */
+    bool needsResync() const { return resyncDue_; }
+
+    /**
+     * @brief Recomputes the sums from the window, which must hold the pushed value already.
+     *
+     * Window is anything with getSize() and getFromHead(), i.e. the array itself.
+     */
+    template <typename Window>
+    void resync(const Window& window) {
+        const std::size_t size = window.getSize();
+        for (std::size_t i = 0; i < size; i++) {
+            const double value = static_cast<double>(AggregateValue<T>::get(window.getFromHead(i)));
+            if (std::isfinite(value)) {
+                shift_ = value;
+                break;
+            }
+        }
+        sum_ = 0.0;
+        sumSquares_ = 0.0;
+        for (std::size_t i = 0; i < size; i++) {
+            const double shifted = static_cast<double>(AggregateValue<T>::get(window.getFromHead(i))) - shift_;
+            sum_ += shifted;
+            sumSquares_ += shifted * shifted;
+        }
+        evictions_ = 0;
+        resyncDue_ = false;
+    }
+
+    void onClear() {
+        sum_ = 0.0;
+        sumSquares_ = 0.0;
+        shift_ = 0.0;
+        evictions_ = 0;
+        resyncDue_ = false;
+        count_ = 0;
+        sequence_ = 0;
+        minDeque_.clear();
+        maxDeque_.clear();
+    }
+
+private:
+    // Ring-backed deque whose front is always the window's min (or max).
+    class MonotonicDeque {
+    public:
+        void clear() {
+            front_ = 0;
+            size_ = 0;
+        }
+
+        value_type front() const {
+            return size_ == 0 ? value_type() : values_[front_];
+        }
+
+        void push(value_type value, uint32_t sequence, std::size_t windowSize, bool keepMax) {
+            // Drop entries that just left the window
+            while (size_ > 0 && sequence - sequences_[front_] >= windowSize) {
+                front_ = (front_ + 1) % Capacity;
+                size_--;
+            }
+            // Drop entries that can never be the extreme again
+            while (size_ > 0) {
+                const value_type back = values_[(front_ + size_ - 1) % Capacity];
+                const bool dominated = keepMax ? !(value < back) : !(back < value);
+                if (!dominated) {
+                    break;
+                }
+                size_--;
+            }
+            const std::size_t slot = (front_ + size_) % Capacity;
+            values_[slot] = value;
+            sequences_[slot] = sequence;
+            size_++;
+        }
+
+    private:
+        value_type values_[Capacity];
+        uint32_t sequences_[Capacity];
+        std::size_t front_;
+        std::size_t size_;
+    };
+
+    double sum_;          // of (value - shift_)
+    double sumSquares_;   // of (value - shift_)^2
+    double shift_;
+    std::size_t evictions_;   // since the last resync
+    bool resyncDue_;
+    std::size_t count_;
+    uint32_t sequence_;
+    MonotonicDeque minDeque_;
+    MonotonicDeque maxDeque_;
+};
+
+/**
+ * @brief SizedCircularArray with RunningAggregates enabled.
+ *
+ * Example:
+ *     AggregatingCircularArray<DataPoint, 100> window(100);
+ *     window.push(DataPoint(t, altitude));
+ *     float mean = window.getMean();
+ */
+template <typename T, std::size_t Capacity>
+using AggregatingCircularArray = SizedCircularArray<T, Capacity,
+                                                    typename CircularIndex<Capacity>::type,
+                                                    RunningAggregates<T, Capacity> >;
+
+#endif  // RUNNINGAGGREGATES_H
@@ -0,0 +1,79 @@
+#ifndef SENSORDATAHANDLERT_H
+#define SENSORDATAHANDLERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SensorSaveFilter.h"
+#include "data_handling/DataPoint.h"
+
+/**
+ * @brief SensorDataHandler with the saver type and sensor name fixed at compile time.
+ *
+ * SensorDataHandler calls the saver through IDataSaver*, so every saved sample
+ * is an indirect call that the compiler can't inline, even though a handler is
+ * always wired to one concrete saver (DataSaverSPI in flight, a mock in tests).
+ * Here the saver is a template parameter, so saveDataPoint() is an ordinary
+ * member call that can be inlined into addData(). The sensor name is a
+ * constant, so it costs no storage.
+ *
+ * Saver only needs `int saveDataPoint(const DataPoint&, uint8_t)`; it doesn't
+ * have to derive from IDataSaver. If saveDataPoint() is virtual in Saver,
+ * declare it final (or make the class final) so the call can be devirtualized.
+ *
+ * The save policy (interval, decimation, deadband) is the same
+ * SensorSaveFilter that BatchSensorDataHandler uses. Keep using
+ * SensorDataHandler or BatchSensorDataHandler where the saver is chosen at
+ * run time.
+ *
+ * Example:
+ *     SensorDataHandlerT<DataSaverSPI, ALTITUDE> altitudeHandler(dataSaver);
+ *     altitudeHandler.restrictSaveSpeed(50);
+ *     altitudeHandler.addData(DataPoint(millis(), altitude));
+ */
+template <typename Saver, uint8_t SensorName>
+class SensorDataHandlerT : public SensorSaveFilter {
+public:
+    static const uint8_t NAME = SensorName;
+
+    explicit SensorDataHandlerT(Saver& saver) : saver_(saver) {}
+
+    /**
+     * @brief Adds a single sample.
+     * @return The saver's status, or 0 if the sample was filtered out.
+     */
+    int addData(const DataPoint& data) {
+        DataPoint out;
+        if (!filter(data, out)) {
+            return 0;
+        }
+        const int status = saver_.saveDataPoint(out, SensorName);
+        recordSaveResult(status, 1);
+        return status;
+    }
+
+    /**
+     * @brief Adds a block of samples, oldest first.
+     * @return 0 on success, otherwise the first non-zero saver status.
+     */
+    int addData(const DataPoint* data, std::size_t count) {
+        int result = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            const int status = addData(data[i]);
+            if (status != 0 && result == 0) {
+                result = status;
+            }
+        }
+        return result;
+    }
+
+    uint8_t getName() const { return SensorName; }
+
+private:
+    Saver& saver_;
+};
+
+template <typename Saver, uint8_t SensorName>
+const uint8_t SensorDataHandlerT<Saver, SensorName>::NAME;
+
+#endif  // SENSORDATAHANDLERT_H
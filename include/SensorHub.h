@@ -0,0 +1,253 @@
+#ifndef SENSORHUB_H
+#define SENSORHUB_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "BatchSensorDataHandler.h"
+#include "SizedCircularArray.h"
+#include "data_handling/DataPoint.h"
+
+/**
+ * @brief How a channel's value is estimated at a master-clock timestamp.
+ */
+enum AlignMode {
+    ALIGN_HOLD,         ///< Latest sample at or before the timestamp (zero-order hold)
+    ALIGN_INTERPOLATE,  ///< Linear interpolation between the samples either side of it
+};
+
+/**
+ * @brief One instant of every channel, aligned to a master-clock timestamp.
+ */
+template <std::size_t Channels>
+struct SensorFrame {
+    uint32_t timestamp_ms;
+    float values[Channels];
+    /// Time since the newest source sample at or before timestamp_ms (0 when interpolated)
+    uint32_t staleness_ms[Channels];
+    /// Bit c is set if channel c had any sample to estimate from
+    uint32_t validMask;
+
+    bool isValid(std::size_t channel) const { return (validMask >> channel) & 1U; }
+};
+
+/**
+ * @brief Aligns samples from sensors running at different rates onto one master clock.
+ *
+ * StateMachine::update(accel, alt) expects both values at the same instant,
+ * but the IMU and baro sample at different rates and with jitter. SensorHub
+ * keeps the last HistoryDepth samples of every channel. Each sample on the
+ * master channel (usually the IMU) becomes a SensorFrame at that timestamp,
+ * and the other channels are held or interpolated onto it.
+ *
+ * An interpolated channel needs a sample after the frame time, so frames are
+ * queued until every ALIGN_INTERPOLATE channel has caught up. QueueDepth must
+ * cover the longest gap between samples of the slowest interpolated channel,
+ * in master samples: a 1 kHz IMU with a 40 Hz baro queues 25 frames, or ~30
+ * with jitter. If the queue fills anyway (e.g. the baro stopped), the oldest
+ * frame is released with the last known value held instead, and its
+ * staleness shows how old that value is.
+ *
+ * HistoryDepth only has to cover what the other channels sample while a
+ * frame waits in the queue; the master's own value is queued with the frame.
+ * A channel whose every kept sample is newer than the frame is marked not
+ * valid rather than guessed.
+ *
+ * The hub is an IBatchDataSaver, so existing handlers can feed it directly:
+ * bind each sensor name to a channel and pass the hub as their saver.
+ *
+ * Example:
+ *     SensorHub<2> hub;                          // channel 0 is the master
+ *     hub.bindSensor(0, ACCELEROMETER_Z, ALIGN_HOLD);
+ *     hub.bindSensor(1, ALTITUDE, ALIGN_INTERPOLATE);
+ *     hub.addSample(0, accelZ);                  // or via a SensorDataHandler
+ *     SensorFrame<2> frame;
+ *     while (hub.getFrame(frame)) {
+ *         stateMachine.update(frame.values[0], frame.values[1]);
+ *     }
+ *
+ * @tparam Channels     Number of channels (at most 32)
+ * @tparam QueueDepth   Master frames that can wait for interpolation
+ * @tparam HistoryDepth Samples kept per channel
+ */
+template <std::size_t Channels, std::size_t QueueDepth = 64, std::size_t HistoryDepth = 8>
+class SensorHub : public IBatchDataSaver {
+    static_assert(Channels > 0 && Channels <= 32, "SensorHub supports 1 to 32 channels");
+    static_assert(QueueDepth >= 1, "QueueDepth must be at least 1");
+    static_assert(HistoryDepth >= 2, "HistoryDepth must be at least 2 to interpolate");
+
+public:
+    static const uint8_t UNBOUND = 0xFF;
+
+    /**
+     * @param masterChannel Channel whose samples define the frame timestamps.
+     */
+    explicit SensorHub(std::size_t masterChannel = 0)
+        : masterChannel_(masterChannel), pendingHead_(0), pendingCount_(0), overruns_(0)
+    {
+        for (std::size_t c = 0; c < Channels; c++) {
+            names_[c] = UNBOUND;
+            modes_[c] = ALIGN_HOLD;
+        }
+    }
+
+    /**
+     * @brief Routes saveDataPoint() calls for sensorName to channel, aligned with mode.
+     */
+    void bindSensor(std::size_t channel, uint8_t sensorName, AlignMode mode) {
+        if (channel >= Channels) {
+            return;
+        }
+        names_[channel] = sensorName;
+        modes_[channel] = mode;
+    }
+
+    void setAlignMode(std::size_t channel, AlignMode mode) {
+        if (channel < Channels) {
+            modes_[channel] = mode;
+        }
+    }
+
+    /**
+     * @brief Adds a sample to a channel.
+     * @return false if the channel doesn't exist or the sample is older than the channel's newest.
+     */
+    bool addSample(std::size_t channel, const DataPoint& sample) {
+        if (channel >= Channels) {
+            return false;
+        }
+        History& history = history_[channel];
+        if (history.getSize() > 0 && sample.timestamp_ms < history.getFromHead(0).timestamp_ms) {
+            return false;
+        }
+        history.push(sample);
+        if (channel == masterChannel_) {
+            if (pendingCount_ == QueueDepth) {
+                // The caller didn't drain getFrame(); lose the oldest frame
+                pendingHead_ = (pendingHead_ + 1) % QueueDepth;
+                pendingCount_--;
+                overruns_++;
+            }
+            pending_[(pendingHead_ + pendingCount_) % QueueDepth] = sample;
+            pendingCount_++;
+        }
+        return true;
+    }
+
+    /**
+     * @brief IDataSaver entry point: routes the point to the channel bound to name.
+     * @return 0 on success, -1 if name is unbound or the sample was rejected.
+     */
+    virtual int saveDataPoint(const DataPoint& data, uint8_t name) override {
+        for (std::size_t c = 0; c < Channels; c++) {
+            if (names_[c] == name) {
+                return addSample(c, data) ? 0 : -1;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Takes the oldest frame that is ready.
+     * @return false if no frame is ready yet.
+     */
+    bool getFrame(SensorFrame<Channels>& frame) {
+        if (pendingCount_ == 0) {
+            return false;
+        }
+        const DataPoint master = pending_[pendingHead_];
+        const uint32_t t = master.timestamp_ms;
+        if (pendingCount_ < QueueDepth && !interpolationReady(t)) {
+            return false;
+        }
+        frame.timestamp_ms = t;
+        frame.validMask = 0;
+        for (std::size_t c = 0; c < Channels; c++) {
+            if (c == masterChannel_) {
+                frame.values[c] = master.data;
+                frame.staleness_ms[c] = 0;
+                frame.validMask |= 1UL << c;
+            } else if (estimate(c, t, frame.values[c], frame.staleness_ms[c])) {
+                frame.validMask |= 1UL << c;
+            }
+        }
+        pendingHead_ = (pendingHead_ + 1) % QueueDepth;
+        pendingCount_--;
+        return true;
+    }
+
+    /** @brief Frames queued on the master clock that haven't been returned yet. */
+    std::size_t getPendingFrames() const { return pendingCount_; }
+
+    /** @brief Frames lost because getFrame() wasn't called often enough. */
+    uint32_t getOverrunCount() const { return overruns_; }
+
+    /** @brief Forgets every sample and queued frame (bindings are kept). */
+    void clear() {
+        for (std::size_t c = 0; c < Channels; c++) {
+            history_[c].clear();
+        }
+        pendingHead_ = 0;
+        pendingCount_ = 0;
+    }
+
+private:
+    typedef SizedCircularArray<DataPoint, HistoryDepth> History;
+
+    History history_[Channels];
+    uint8_t names_[Channels];
+    AlignMode modes_[Channels];
+    std::size_t masterChannel_;
+    DataPoint pending_[QueueDepth];  // master samples waiting to become frames
+    std::size_t pendingHead_;
+    std::size_t pendingCount_;
+    uint32_t overruns_;
+
+    // True once every interpolated channel has a sample at or after t
+    bool interpolationReady(uint32_t t) const {
+        for (std::size_t c = 0; c < Channels; c++) {
+            if (modes_[c] != ALIGN_INTERPOLATE || c == masterChannel_) {
+                continue;
+            }
+            if (history_[c].getSize() == 0 || history_[c].getFromHead(0).timestamp_ms < t) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool estimate(std::size_t channel, uint32_t t, float& value, uint32_t& staleness_ms) const {
+        const History& history = history_[channel];
+        const std::size_t size = history.getSize();
+        value = 0.0f;
+        staleness_ms = 0;
+        if (size == 0) {
+            return false;
+        }
+        // Walk back from the newest sample to the first one at or before t
+        std::size_t i = 0;
+        while (i < size && history.getFromHead(static_cast<typename History::index_type>(i)).timestamp_ms > t) {
+            i++;
+        }
+        if (i == size) {
+            // Every sample is newer than t: nothing to hold, and the history may just be too short
+            return false;
+        }
+        const DataPoint before = history.getFromHead(static_cast<typename History::index_type>(i));
+        if (modes_[channel] == ALIGN_INTERPOLATE && i > 0 && before.timestamp_ms != t) {
+            const DataPoint after = history.getFromHead(static_cast<typename History::index_type>(i - 1));
+            const float fraction = static_cast<float>(t - before.timestamp_ms) /
+                                   static_cast<float>(after.timestamp_ms - before.timestamp_ms);
+            value = before.data + fraction * (after.data - before.data);
+            return true;
+        }
+        value = before.data;
+        staleness_ms = t - before.timestamp_ms;
+        return true;
+    }
+};
+
+template <std::size_t Channels, std::size_t QueueDepth, std::size_t HistoryDepth>
+const uint8_t SensorHub<Channels, QueueDepth, HistoryDepth>::UNBOUND;
+
+#endif  // SENSORHUB_H
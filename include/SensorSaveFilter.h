@@ -0,0 +1,193 @@
+#ifndef SENSORSAVEFILTER_H
+#define SENSORSAVEFILTER_H
+
+#include <cmath>
+#include <cstdint>
+
+#include "data_handling/DataPoint.h"
+
+/**
+ * @brief What happens to the samples that arrive between two saves.
+ */
+enum DecimationMode {
+    DECIMATE_DROP,     ///< Discard them (SensorDataHandler behaviour)
+    DECIMATE_AVERAGE,  ///< Log the boxcar average of every sample since the previous save
+};
+
+/**
+ * @brief Throughput and drop counters of one sensor handler.
+ *
+ * Plain uint32_t fields with no padding, so a snapshot can be copied into a
+ * telemetry packet or a flash record as is. Counters wrap at 2^32 samples
+ * (about 50 days at 1 kHz).
+ */
+struct SensorHandlerStats {
+    uint32_t received;     ///< Samples passed to addData()
+    uint32_t saved;        ///< Points the saver accepted (returned 0)
+    uint32_t rateLimited;  ///< Samples held back by restrictSaveSpeed() (folded into an average in DECIMATE_AVERAGE)
+    uint32_t deadbanded;   ///< Points held back by the deadband
+    uint32_t saverErrors;  ///< Points handed to a save call that returned non-zero
+    uint32_t maxGap_ms;    ///< Largest timestamp step between consecutive received samples
+};
+
+/**
+ * @brief Decides which samples of a sensor stream are saved, and with what value.
+ *
+ * This is the save policy shared by BatchSensorDataHandler (runtime saver)
+ * and SensorDataHandlerT (compile-time saver). The handlers derive from it,
+ * so the configuration calls below are available on both.
+ *
+ * Interval: a point is only saved when its timestamp is more than
+ * saveInterval_ms after the last saved one (SensorDataHandler's rule).
+ *
+ * Decimation: by default the samples between saves are dropped, so a 1 kHz
+ * stream logged at 25 Hz is an aliased snapshot of every 40th sample. With
+ * setDecimationMode(DECIMATE_AVERAGE), every sample is folded into a running
+ * sum, kept in double so large offsets survive long intervals. Each save
+ * then logs the mean of the samples received since the previous save, at the
+ * timestamp of the sample that triggered it. This boxcar is a moving-average
+ * FIR with its first null at the save rate, so tones that would alias onto
+ * the logged rate are strongly attenuated. It is causal, and it lags the raw
+ * stream by half a save interval.
+ *
+ * Deadband: for slow channels (baro on the pad, temperature, battery voltage),
+ * setDeadband() adds a change threshold on top of the interval. A point that
+ * passes the interval is only saved if it differs from the last saved value
+ * by more than delta, or if maxSilence_ms has passed since the last save so
+ * the log still shows the channel is alive. In average mode the threshold is
+ * applied to the average of the interval that just ended. An interval held
+ * back by the deadband starts a fresh average, so a step is logged at its new
+ * level within two intervals however long the channel was quiet.
+ *
+ * Every handler also keeps a SensorHandlerStats, read with getStats(). The
+ * counters are a few increments per sample, which lets a flight log show how
+ * many samples a sensor produced and where they went.
+ */
+class SensorSaveFilter {
+public:
+    SensorSaveFilter()
+        : saveInterval_ms_(0), lastSaveTime_ms_(0), intervalStart_ms_(0),
+          mode_(DECIMATE_DROP), pendingSum_(0.0), pendingCount_(0),
+          deadbandEnabled_(false), deadband_(0.0f), maxSilence_ms_(0),
+          hasSaved_(false), lastSavedValue_(0.0f), lastArrival_ms_(0)
+    {
+        resetStats();
+    }
+
+    /**
+     * @brief Only save a sample if more than interval_ms passed since the last saved one.
+     */
+    void restrictSaveSpeed(uint16_t interval_ms) { saveInterval_ms_ = interval_ms; }
+
+    /**
+     * @brief Chooses how the samples between saves are used. Discards any partial average.
+     */
+    void setDecimationMode(DecimationMode mode) {
+        mode_ = mode;
+        pendingSum_ = 0.0;
+        pendingCount_ = 0;
+    }
+
+    DecimationMode getDecimationMode() const { return mode_; }
+
+    /**
+     * @brief Only save values that moved more than delta since the last saved one.
+     * @param delta         Change (in the sensor's units) needed to save again. 0 saves any change.
+     * @param maxSilence_ms A value is saved anyway once this long has passed since the last save.
+     */
+    void setDeadband(float delta, uint32_t maxSilence_ms) {
+        deadbandEnabled_ = true;
+        deadband_ = delta;
+        maxSilence_ms_ = maxSilence_ms;
+    }
+
+    /** @brief Turns the deadband off; every point that passes the interval is saved. */
+    void clearDeadband() { deadbandEnabled_ = false; }
+
+    /** @brief A copy of the counters, e.g. for telemetry or a periodic log record. */
+    SensorHandlerStats getStats() const { return stats_; }
+
+    /** @brief Zeroes the counters (the save policy state is kept). */
+    void resetStats() {
+        stats_.received = 0;
+        stats_.saved = 0;
+        stats_.rateLimited = 0;
+        stats_.deadbanded = 0;
+        stats_.saverErrors = 0;
+        stats_.maxGap_ms = 0;
+    }
+
+protected:
+    /**
+     * @brief Runs one sample through the interval, decimation and deadband.
+     * @return true if out holds a point to save now.
+     */
+    bool filter(const DataPoint& in, DataPoint& out) {
+        if (stats_.received > 0) {
+            const uint32_t gap_ms = in.timestamp_ms - lastArrival_ms_;
+            if (gap_ms > stats_.maxGap_ms) {
+                stats_.maxGap_ms = gap_ms;
+            }
+        }
+        lastArrival_ms_ = in.timestamp_ms;
+        stats_.received++;
+
+        if (mode_ == DECIMATE_AVERAGE) {
+            pendingSum_ += in.data;
+            pendingCount_++;
+        }
+        if (in.timestamp_ms - intervalStart_ms_ <= saveInterval_ms_) {
+            stats_.rateLimited++;
+            return false;
+        }
+        const uint32_t sinceLastSave_ms = in.timestamp_ms - lastSaveTime_ms_;
+        const float value = mode_ == DECIMATE_AVERAGE
+            ? static_cast<float>(pendingSum_ / static_cast<double>(pendingCount_))
+            : in.data;
+        if (deadbandEnabled_ && hasSaved_ && sinceLastSave_ms < maxSilence_ms_ &&
+            std::fabs(value - lastSavedValue_) <= deadband_) {
+            stats_.deadbanded++;
+            if (mode_ == DECIMATE_AVERAGE) {
+                // Judge the next interval on its own samples
+                intervalStart_ms_ = in.timestamp_ms;
+                pendingSum_ = 0.0;
+                pendingCount_ = 0;
+            }
+            return false;
+        }
+        out = DataPoint(in.timestamp_ms, value);
+        lastSaveTime_ms_ = in.timestamp_ms;
+        intervalStart_ms_ = in.timestamp_ms;
+        lastSavedValue_ = value;
+        hasSaved_ = true;
+        pendingSum_ = 0.0;
+        pendingCount_ = 0;
+        return true;
+    }
+
+    /** @brief Records the saver's status for count points handed to it in one call. */
+    void recordSaveResult(int status, uint32_t count) {
+        if (status == 0) {
+            stats_.saved += count;
+        } else {
+            stats_.saverErrors += count;
+        }
+    }
+
+private:
+    uint16_t saveInterval_ms_;
+    uint32_t lastSaveTime_ms_;
+    uint32_t intervalStart_ms_;   // the last save, or in average mode the last deadbanded interval
+    DecimationMode mode_;
+    double pendingSum_;       // DECIMATE_AVERAGE: sum of the samples since the last save
+    uint32_t pendingCount_;
+    bool deadbandEnabled_;
+    float deadband_;
+    uint32_t maxSilence_ms_;
+    bool hasSaved_;
+    float lastSavedValue_;
+    uint32_t lastArrival_ms_;
+    SensorHandlerStats stats_;
+};
+
+#endif  // SENSORSAVEFILTER_H
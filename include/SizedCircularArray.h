@@ -0,0 +1,228 @@
+#ifndef SIZEDCIRCULARARRAY_H
+#define SIZEDCIRCULARARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <type_traits>
+
+#include "ArraySpan.h"
+#include "CircularIndex.h"
+
+/**
+ * @brief Default aggregate policy for SizedCircularArray: tracks nothing.
+ *
+ * An aggregate policy is a base class of the array that is told about every
+ * push (with the value that fell out of the window, if any) and every clear.
+ * After a push, if needsResync() is true, the array hands itself to resync()
+ * so the policy can rebuild its state from the window.
+ * See RunningAggregates for one that keeps sum/mean/variance/min/max.
+ */
+struct NoAggregates {
+    template <typename T>
+    void onPush(const T& /*value*/, const T* /*evicted*/, std::size_t /*windowSize*/) {}
+    void onClear() {}
+    bool needsResync() const { return false; }
+    template <typename Window>
+    void resync(const Window& /*window*/) {}
+};
+
+namespace circular_detail {
+
+// Where the live window sits in storage: [firstStart, firstStart + firstSize)
+// followed by [0, secondSize). Elements fill [0, size) until the ring wraps.
+struct Segments {
+    std::size_t firstStart;
+    std::size_t firstSize;
+    std::size_t secondSize;
+};
+
+inline Segments liveSegments(std::size_t head, std::size_t size, std::size_t maxSize) {
+    if (size < maxSize) {
+        Segments segments = {0, size, 0};
+        return segments;
+    }
+    const std::size_t oldest = (head + 1) % maxSize;
+    Segments segments = {oldest, maxSize - oldest, oldest};
+    return segments;
+}
+
+// How a block of count > 0 elements lands in the ring: skip the leading
+// elements that would be overwritten anyway, then copy [start, start + firstCount)
+// and [0, secondCount).
+struct BulkWrite {
+    std::size_t skip;
+    std::size_t start;
+    std::size_t firstCount;
+    std::size_t secondCount;
+    std::size_t newHead;
+    std::size_t newSize;
+};
+
+inline BulkWrite planBulkWrite(std::size_t head, std::size_t size,
+                               std::size_t maxSize, std::size_t count) {
+    BulkWrite plan;
+    plan.skip = count > maxSize ? count - maxSize : 0;
+    const std::size_t written = count - plan.skip;
+    // Skipped elements still advance the write position, as they would with push()
+    const std::size_t firstSlot = size == 0 ? 0 : (head + 1) % maxSize;
+    plan.start = (firstSlot + plan.skip) % maxSize;
+    plan.firstCount = written < maxSize - plan.start ? written : maxSize - plan.start;
+    plan.secondCount = written - plan.firstCount;
+    plan.newHead = (plan.start + written - 1) % maxSize;
+    plan.newSize = size + written < maxSize ? size + written : maxSize;
+    return plan;
+}
+
+}  // namespace circular_detail
+
+/**
+ * @brief A CircularArray whose index width is picked from its capacity.
+ *
+ * CircularArray stores its head and size as uint8_t, which caps a window at
+ * MAX_CIRCULAR_ARRAY_CAPACITY (255) elements: 2.5 s of data at 100 Hz, or
+ * 0.25 s at 1 kHz. SizedCircularArray has the same vocabulary, but its
+ * head/size type is a template parameter that defaults to
+ * CircularIndex<Capacity>::type. Windows of up to 255 elements keep the same
+ * footprint as before, and IMU-rate windows only pay for 16-bit indices.
+ *
+ * @tparam T        Element type
+ * @tparam Capacity Number of elements the storage can hold
+ * @tparam Index    Type used for head/size/indexing (defaults to the narrowest that fits)
+ * @tparam Aggregates Opt-in policy updated on every push (defaults to NoAggregates)
+ */
+template <typename T, std::size_t Capacity,
+          typename Index = typename CircularIndex<Capacity>::type,
+          typename Aggregates = NoAggregates>
+class SizedCircularArray : public Aggregates {
+    static_assert(Capacity > 0, "Capacity must be greater than 0");
+    static_assert(CircularIndexFits<Index, Capacity>::value,
+                  "Index type is too narrow for Capacity");
+
+public:
+    typedef T value_type;
+    typedef Index index_type;
+
+    /**
+     * @brief Constructs an empty array.
+     * @param maxSize The number of elements kept in the window. Must be <= Capacity.
+     */
+    explicit SizedCircularArray(Index maxSize = Capacity)
+        : maxSize_(maxSize), head_(0), size_(0)
+    {
+        assert(maxSize > 0 && maxSize <= Capacity);
+    }
+
+    /**
+     * @brief Pushes a value, overwriting the oldest one once the array is full.
+     */
+    void push(const T& value) {
+        if (size_ > 0) {
+            head_ = static_cast<Index>((head_ + 1U) % maxSize_);
+        }
+        // The policy sees the evicted value before it is overwritten
+        Aggregates::onPush(value, size_ == maxSize_ ? &array_[head_] : nullptr, maxSize_);
+        array_[head_] = value;
+        if (size_ < maxSize_) {
+            size_++;
+        }
+        if (Aggregates::needsResync()) {
+            Aggregates::resync(*this);
+        }
+    }
+
+    /**
+     * @brief Pushes a block of values, oldest first, as if push() were called on each.
+     *
+     * Without an aggregate policy this is at most two contiguous copies
+     * (std::copy, which lowers to memmove for trivially copyable T). With a
+     * policy it falls back to per-element push() so the policy sees every value.
+     */
+    void pushN(const T* values, std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (!std::is_same<Aggregates, NoAggregates>::value) {
+            for (std::size_t i = 0; i < count; i++) {
+                push(values[i]);
+            }
+            return;
+        }
+        const circular_detail::BulkWrite plan =
+            circular_detail::planBulkWrite(head_, size_, maxSize_, count);
+        const T* source = values + plan.skip;
+        std::copy(source, source + plan.firstCount, array_ + plan.start);
+        std::copy(source + plan.firstCount, source + plan.firstCount + plan.secondCount, array_);
+        head_ = static_cast<Index>(plan.newHead);
+        size_ = static_cast<Index>(plan.newSize);
+    }
+
+    /**
+     * @brief Zero-copy view of the window as at most two contiguous segments, oldest to newest.
+     */
+    CircularView<T> getView() const {
+        const circular_detail::Segments segments =
+            circular_detail::liveSegments(head_, size_, maxSize_);
+        return CircularView<T>(ArraySpan<T>(array_ + segments.firstStart, segments.firstSize),
+                               ArraySpan<T>(array_, segments.secondSize));
+    }
+
+    /**
+     * @brief Gets an element relative to the newest one (0 is the newest).
+     */
+    T getFromHead(Index index) const {
+        return array_[(static_cast<std::size_t>(head_) + maxSize_ - index) % maxSize_];
+    }
+
+    /**
+     * @brief Gets the median of the window (sorted index size/2), or T() if empty.
+     *
+     * This is O(n) and uses a Capacity-sized copy on the stack, limited by
+     * CIRCULAR_MEDIAN_STACK_LIMIT. For large windows use getMedian(scratch),
+     * or MedianCircularArray if it is queried every tick.
+     */
+    T getMedian() const {
+        static_assert(Capacity * sizeof(T) <= CIRCULAR_MEDIAN_STACK_LIMIT,
+                      "Window too large to copy onto the stack, use getMedian(scratch)");
+        T scratch[Capacity];
+        return getMedian(scratch);
+    }
+
+    /**
+     * @brief getMedian() using a caller-supplied buffer of at least getSize() elements.
+     */
+    T getMedian(T* scratch) const {
+        if (size_ == 0) {
+            return T();
+        }
+        std::copy(array_, array_ + size_, scratch);
+        T* middle = scratch + size_ / 2;
+        std::nth_element(scratch, middle, scratch + size_);
+        return *middle;
+    }
+
+    Index getHead() const { return head_; }
+    Index getMaxSize() const { return maxSize_; }
+    Index getSize() const { return size_; }
+    bool isFull() const { return size_ == maxSize_; }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+        Aggregates::onClear();
+    }
+
+private:
+    T array_[Capacity];
+    Index maxSize_;
+    Index head_;
+    Index size_;
+};
+
+// DataPoint arrays use the structure-of-arrays specialization. It is included
+// here so that every user of SizedCircularArray sees the same layout.
+#include "DataPointCircularArray.h"
+
+#endif  // SIZEDCIRCULARARRAY_H
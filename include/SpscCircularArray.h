@@ -0,0 +1,114 @@
+#ifndef SPSCCIRCULARARRAY_H
+#define SPSCCIRCULARARRAY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring for handing samples across contexts.
+ *
+ * One producer (a sensor ISR or sampling thread) calls push(), and one consumer
+ * (the main loop / state machine) calls pop() or getFromHead(). Neither side
+ * ever blocks or disables interrupts, so a slow flash flush or telemetry tick
+ * on the consumer side no longer delays sampling.
+ *
+ * Unlike CircularArray, a full ring does not overwrite: the producer cannot
+ * touch a slot the consumer may be reading, so push() returns false and the
+ * sample is counted in getDroppedCount().
+ *
+ * The read and write positions are free-running 32-bit counters, so Capacity
+ * must be a power of two for the slot mask to stay correct when they wrap.
+ */
+template <typename T, std::size_t Capacity>
+class SpscCircularArray {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+    static_assert(Capacity <= 0x80000000UL, "Capacity must fit in the 32-bit counters");
+
+public:
+    SpscCircularArray() : writeCount_(0), readCount_(0), dropped_(0) {}
+
+    // ----------------------------- producer side -----------------------------
+
+    /**
+     * @brief Publishes a value to the consumer.
+     * @return true if the value was queued, false if the ring was full (value dropped).
+     */
+    bool push(const T& value) {
+        const uint32_t write = writeCount_.load(std::memory_order_relaxed);
+        const uint32_t read = readCount_.load(std::memory_order_acquire);
+        if (write - read >= Capacity) {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        slots_[write & kMask] = value;
+        writeCount_.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // ----------------------------- consumer side -----------------------------
+
+    /**
+     * @brief Takes the oldest queued value.
+     * @return false if the ring was empty (out is left untouched).
+     */
+    bool pop(T& out) {
+        const uint32_t read = readCount_.load(std::memory_order_relaxed);
+        const uint32_t write = writeCount_.load(std::memory_order_acquire);
+        if (read == write) {
+            return false;
+        }
+        out = slots_[read & kMask];
+        readCount_.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Peeks at a queued value relative to the newest one (0 is the newest).
+     *
+     * Only values that have not been popped yet can be read. Returns T() if
+     * index is past the oldest queued value.
+     */
+    T getFromHead(std::size_t index) const {
+        const uint32_t read = readCount_.load(std::memory_order_relaxed);
+        const uint32_t write = writeCount_.load(std::memory_order_acquire);
+        if (index >= static_cast<std::size_t>(write - read)) {
+            return T();
+        }
+        return slots_[(write - 1U - static_cast<uint32_t>(index)) & kMask];
+    }
+
+    /**
+     * @brief Drops everything currently queued. Consumer side only.
+     */
+    void clear() {
+        readCount_.store(writeCount_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // ------------------------------- either side -----------------------------
+
+    /** @brief Number of queued values (a snapshot; the other side may change it). */
+    std::size_t getSize() const {
+        const uint32_t read = readCount_.load(std::memory_order_acquire);
+        const uint32_t write = writeCount_.load(std::memory_order_acquire);
+        return static_cast<std::size_t>(write - read);
+    }
+
+    std::size_t getMaxSize() const { return Capacity; }
+    bool isEmpty() const { return getSize() == 0; }
+    bool isFull() const { return getSize() >= Capacity; }
+
+    /** @brief Number of values rejected by push() because the ring was full. */
+    uint32_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static const uint32_t kMask = static_cast<uint32_t>(Capacity - 1);
+
+    T slots_[Capacity];
+    std::atomic<uint32_t> writeCount_;  // only written by the producer
+    std::atomic<uint32_t> readCount_;   // only written by the consumer
+    std::atomic<uint32_t> dropped_;     // only written by the producer
+};
+
+#endif  // SPSCCIRCULARARRAY_H
@@ -0,0 +1,207 @@
+#ifndef STATESNAPSHOT_H
+#define STATESNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Compact binary snapshots of estimator state for warm restarts.
+ *
+ * After a brownout the flight computer reboots with empty windows. Writing a
+ * snapshot to flash every few hundred milliseconds lets the next boot restore
+ * them instead of waiting for the windows to refill.
+ *
+ * Layout (little-endian, as stored by the MCU):
+ *     uint32_t magic    'CRSS'
+ *     uint8_t  version
+ *     uint8_t  reserved
+ *     uint16_t length   payload bytes
+ *     uint32_t crc32    of the payload
+ *     payload...
+ *
+ * The buffer is caller-owned (e.g. a flash page that DataSaverSPI writes),
+ * so nothing here allocates. Every write/read reports failure instead of
+ * overrunning. A reader refuses a snapshot with a bad magic, version,
+ * length or CRC.
+ */
+
+/** @brief CRC-32 (IEEE 802.3, reflected). Bitwise, so no lookup table in flash. */
+inline uint32_t snapshotCrc32(const uint8_t* data, std::size_t length) {
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (std::size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+class SnapshotWriter {
+public:
+    static const uint32_t MAGIC = 0x53535243UL;  // "CRSS"
+    static const uint8_t VERSION = 1;
+    static const std::size_t HEADER_SIZE = 12;
+
+    SnapshotWriter(uint8_t* buffer, std::size_t capacity)
+        : buffer_(buffer), capacity_(capacity), offset_(HEADER_SIZE), ok_(capacity >= HEADER_SIZE) {}
+
+    /** @brief Appends a trivially copyable value. */
+    template <typename U>
+    bool write(const U& value) {
+        static_assert(std::is_trivially_copyable<U>::value, "Snapshot values must be trivially copyable");
+        return writeBytes(&value, sizeof(U));
+    }
+
+    bool writeBytes(const void* data, std::size_t length) {
+        if (!ok_ || length > capacity_ - offset_ || offset_ + length - HEADER_SIZE > 0xFFFF) {
+            ok_ = false;
+            return false;
+        }
+        std::memcpy(buffer_ + offset_, data, length);
+        offset_ += length;
+        return true;
+    }
+
+    /**
+     * @brief Seals the snapshot by writing the header.
+     * @return Total bytes to persist (header + payload), or 0 if anything overflowed.
+     */
+    std::size_t finish() {
+        if (!ok_) {
+            return 0;
+        }
+        const uint16_t length = static_cast<uint16_t>(offset_ - HEADER_SIZE);
+        const uint32_t crc = snapshotCrc32(buffer_ + HEADER_SIZE, length);
+        const uint32_t magic = MAGIC;
+        const uint8_t version = VERSION;
+        const uint8_t reserved = 0;
+        std::memcpy(buffer_, &magic, 4);
+        std::memcpy(buffer_ + 4, &version, 1);
+        std::memcpy(buffer_ + 5, &reserved, 1);
+        std::memcpy(buffer_ + 6, &length, 2);
+        std::memcpy(buffer_ + 8, &crc, 4);
+        return offset_;
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    uint8_t* buffer_;
+    std::size_t capacity_;
+    std::size_t offset_;
+    bool ok_;
+};
+
+class SnapshotReader {
+public:
+    /**
+     * @param buffer Bytes read back from storage.
+     * @param length Number of valid bytes in buffer (may be more than the snapshot).
+     */
+    SnapshotReader(const uint8_t* buffer, std::size_t length)
+        : buffer_(buffer), end_(0), offset_(SnapshotWriter::HEADER_SIZE), ok_(false)
+    {
+        if (length < SnapshotWriter::HEADER_SIZE) {
+            return;
+        }
+        uint32_t magic = 0;
+        uint8_t version = 0;
+        uint16_t payloadLength = 0;
+        uint32_t crc = 0;
+        std::memcpy(&magic, buffer, 4);
+        std::memcpy(&version, buffer + 4, 1);
+        std::memcpy(&payloadLength, buffer + 6, 2);
+        std::memcpy(&crc, buffer + 8, 4);
+        if (magic != SnapshotWriter::MAGIC || version != SnapshotWriter::VERSION ||
+            payloadLength > length - SnapshotWriter::HEADER_SIZE) {
+            return;
+        }
+        if (snapshotCrc32(buffer + SnapshotWriter::HEADER_SIZE, payloadLength) != crc) {
+            return;
+        }
+        end_ = SnapshotWriter::HEADER_SIZE + payloadLength;
+        ok_ = true;
+    }
+
+    /** @brief Reads a trivially copyable value written with SnapshotWriter::write(). */
+    template <typename U>
+    bool read(U& value) {
+        static_assert(std::is_trivially_copyable<U>::value, "Snapshot values must be trivially copyable");
+        return readBytes(&value, sizeof(U));
+    }
+
+    bool readBytes(void* data, std::size_t length) {
+        if (!ok_ || length > end_ - offset_) {
+            ok_ = false;
+            return false;
+        }
+        std::memcpy(data, buffer_ + offset_, length);
+        offset_ += length;
+        return true;
+    }
+
+    /** @brief False if the header/CRC was invalid or a read ran past the payload. */
+    bool ok() const { return ok_; }
+
+    /** @brief True once every payload byte has been consumed. */
+    bool atEnd() const { return offset_ == end_; }
+
+    /** @brief Payload bytes not read yet (0 once the reader has failed). */
+    std::size_t getRemaining() const { return ok_ ? end_ - offset_ : 0; }
+
+private:
+    const uint8_t* buffer_;
+    std::size_t end_;
+    std::size_t offset_;
+    bool ok_;
+};
+
+/**
+ * @brief Saves a ring's window (oldest first) into a snapshot.
+ *
+ * Works with any array exposing getMaxSize(), getSize() and getFromHead():
+ * SizedCircularArray, MedianCircularArray and TimeWindowedArray.
+ */
+template <typename Array>
+bool saveCircularArray(SnapshotWriter& writer, const Array& array) {
+    const uint32_t maxSize = static_cast<uint32_t>(array.getMaxSize());
+    const uint32_t size = static_cast<uint32_t>(array.getSize());
+    bool ok = writer.write(maxSize) && writer.write(size);
+    for (uint32_t i = size; ok && i > 0; i--) {
+        ok = writer.write(array.getFromHead(static_cast<typename Array::index_type>(i - 1)));
+    }
+    return ok;
+}
+
+/**
+ * @brief Restores a window saved with saveCircularArray().
+ *
+ * Values are pushed back oldest first, so any derived state (running
+ * aggregates, median heaps) is rebuilt exactly. Fails without touching the
+ * array if the saved window size does not match or the snapshot ends before
+ * the saved values do. The CRC was checked when the reader was opened.
+ */
+template <typename Array>
+bool restoreCircularArray(SnapshotReader& reader, Array& array) {
+    uint32_t maxSize = 0;
+    uint32_t size = 0;
+    if (!reader.read(maxSize) || !reader.read(size) ||
+        maxSize != static_cast<uint32_t>(array.getMaxSize()) || size > maxSize ||
+        size > reader.getRemaining() / sizeof(typename Array::value_type)) {
+        return false;
+    }
+    array.clear();
+    for (uint32_t i = 0; i < size; i++) {
+        typename Array::value_type value;
+        if (!reader.read(value)) {
+            return false;
+        }
+        array.push(value);
+    }
+    return true;
+}
+
+#endif  // STATESNAPSHOT_H
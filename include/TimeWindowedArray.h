@@ -0,0 +1,152 @@
+#ifndef TIMEWINDOWEDARRAY_H
+#define TIMEWINDOWEDARRAY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "CircularIndex.h"
+#include "data_handling/DataPoint.h"
+
+/**
+ * @brief A DataPoint ring that evicts by age instead of by element count.
+ *
+ * LaunchDetector's window is count-based but its logic is time-based, so
+ * today a sample that arrives too fast is rejected (LP_DATA_TOO_FAST) and a
+ * gap clears the whole window (LP_WINDOW_DATA_STALE). This array instead
+ * keeps every DataPoint younger than window_ms relative to the newest one.
+ * Jittery or bursty sensors only push older samples out; they never throw the
+ * window away.
+ *
+ * Capacity bounds memory. If a burst arrives faster than Capacity samples per
+ * window_ms, the oldest samples are dropped early and counted in
+ * getOverflowCount(). Use coversWindow() to ask whether enough time is in
+ * the window to trust it.
+ *
+ * Example:
+ *     TimeWindowedArray<256> window(1000);  // last 1 s of data
+ *     static DataPoint scratch[256];
+ *     window.push(DataPoint(now, acl2));
+ *     if (window.coversWindow(900) && window.getMedian(scratch).data > threshold) { ... }
+ */
+template <std::size_t Capacity>
+class TimeWindowedArray {
+    static_assert(Capacity > 0, "Capacity must be greater than 0");
+
+public:
+    typedef DataPoint value_type;
+    typedef typename CircularIndex<Capacity>::type index_type;
+
+    /**
+     * @param window_ms Samples older than this (relative to the newest sample) are evicted.
+     */
+    explicit TimeWindowedArray(uint32_t window_ms)
+        : window_ms_(window_ms), oldest_(0), size_(0), overflowCount_(0) {}
+
+    /**
+     * @brief Adds a sample and evicts everything that has aged out of the window.
+     * @return false (and ignores the sample) if it is older than the newest sample.
+     */
+    bool push(const DataPoint& dp) {
+        if (size_ > 0 && dp.timestamp_ms < newest().timestamp_ms) {
+            return false;
+        }
+        if (size_ == Capacity) {
+            dropOldest();
+            overflowCount_++;
+        }
+        array_[(static_cast<std::size_t>(oldest_) + size_) % Capacity] = dp;
+        size_++;
+        while (size_ > 1 && dp.timestamp_ms - array_[oldest_].timestamp_ms >= window_ms_) {
+            dropOldest();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Gets an element relative to the newest one (0 is the newest).
+     */
+    DataPoint getFromHead(index_type index) const {
+        return array_[(static_cast<std::size_t>(oldest_) + size_ - 1 - index) % Capacity];
+    }
+
+    /** @brief The oldest sample still in the window, or DataPoint() if empty. */
+    DataPoint getOldest() const {
+        return size_ == 0 ? DataPoint() : array_[oldest_];
+    }
+
+    /** @brief Time between the oldest and newest samples in the window. */
+    uint32_t getSpan_ms() const {
+        return size_ == 0 ? 0 : newest().timestamp_ms - array_[oldest_].timestamp_ms;
+    }
+
+    /**
+     * @brief True once the window holds at least minSpan_ms of data.
+     *
+     * Replaces CircularArray::isFull() as the "window is populated" check.
+     */
+    bool coversWindow(uint32_t minSpan_ms) const {
+        return size_ > 0 && getSpan_ms() >= minSpan_ms;
+    }
+
+    /**
+     * @brief Gets the median of the window by data (sorted index size/2), or DataPoint() if empty.
+     *
+     * Copies the window onto the stack, limited by CIRCULAR_MEDIAN_STACK_LIMIT.
+     * Use getMedian(scratch) for large windows.
+     */
+    DataPoint getMedian() const {
+        static_assert(Capacity * sizeof(DataPoint) <= CIRCULAR_MEDIAN_STACK_LIMIT,
+                      "Window too large to copy onto the stack, use getMedian(scratch)");
+        DataPoint scratch[Capacity];
+        return getMedian(scratch);
+    }
+
+    /**
+     * @brief getMedian() using a caller-supplied buffer of at least getSize() elements.
+     */
+    DataPoint getMedian(DataPoint* scratch) const {
+        if (size_ == 0) {
+            return DataPoint();
+        }
+        for (std::size_t i = 0; i < size_; i++) {
+            scratch[i] = array_[(oldest_ + i) % Capacity];
+        }
+        DataPoint* middle = scratch + size_ / 2;
+        std::nth_element(scratch, middle, scratch + size_);
+        return *middle;
+    }
+
+    uint32_t getWindow_ms() const { return window_ms_; }
+    void setWindow_ms(uint32_t window_ms) { window_ms_ = window_ms; }
+
+    index_type getSize() const { return size_; }
+    std::size_t getMaxSize() const { return Capacity; }
+    bool isEmpty() const { return size_ == 0; }
+
+    /** @brief Number of samples dropped early because Capacity was reached. */
+    uint32_t getOverflowCount() const { return overflowCount_; }
+
+    void clear() {
+        oldest_ = 0;
+        size_ = 0;
+    }
+
+private:
+    DataPoint array_[Capacity];
+    uint32_t window_ms_;
+    index_type oldest_;
+    index_type size_;
+    uint32_t overflowCount_;
+
+    const DataPoint& newest() const {
+        return array_[(static_cast<std::size_t>(oldest_) + size_ - 1) % Capacity];
+    }
+
+    void dropOldest() {
+        oldest_ = static_cast<index_type>((oldest_ + 1U) % Capacity);
+        size_--;
+    }
+};
+
+#endif  // TIMEWINDOWEDARRAY_H
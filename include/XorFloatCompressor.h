@@ -0,0 +1,419 @@
+#ifndef XORFLOATCOMPRESSOR_H
+#define XORFLOATCOMPRESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "QuantizedRecord.h"
+
+/**
+ * @brief Bit-level helpers shared by XorFloatCompressor and XorFloatBlockReader.
+ */
+namespace xor_float {
+
+/**
+ * @brief Fixed part of a block header: {blockName, entry count (uint16), payload bytes (uint16), sensor count}.
+ *
+ * The sensor count is followed by that many name bytes.
+ */
+static const std::size_t HEADER_SIZE = 6;
+
+/** @brief Largest entry: slot, two control bits, leading zeros, length, 32 meaningful bits. */
+static const std::size_t MAX_ENTRY_BITS = 8 + 2 + 5 + 5 + 32;
+
+/** @brief Bits needed to number count sensors (0 for a single sensor). */
+inline uint8_t slotBits(std::size_t count) {
+    uint8_t bits = 0;
+    while ((static_cast<std::size_t>(1) << bits) < count) {
+        bits++;
+    }
+    return bits;
+}
+
+inline uint32_t floatBits(float value) {
+    uint32_t bits;
+    static_assert(sizeof(bits) == sizeof(value), "float must be 32 bits");
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bitsFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// value must be non-zero. Loops rather than __builtin_clz, whose width follows int.
+inline uint8_t leadingZeros(uint32_t value) {
+    uint8_t n = 0;
+    while ((value & 0x80000000UL) == 0) {
+        value <<= 1;
+        n++;
+    }
+    return n;
+}
+
+inline uint8_t trailingZeros(uint32_t value) {
+    uint8_t n = 0;
+    while ((value & 1U) == 0) {
+        value >>= 1;
+        n++;
+    }
+    return n;
+}
+
+/** @brief Previous value and meaningful-bit window of one sensor within a block. */
+struct SensorState {
+    uint8_t name;
+    uint32_t previous;
+    uint8_t leading;
+    uint8_t trailing;
+    bool haveWindow;
+};
+
+}  // namespace xor_float
+
+/**
+ * @brief Compresses per-sensor float streams by XORing each value with the sensor's previous one.
+ *
+ * Consecutive readings of baro altitude, temperature or a resting gyro share
+ * their sign, exponent and top mantissa bits, so the XOR of two neighbours is
+ * mostly zeros. Each entry is the sensor's slot followed by the XOR, encoded
+ * as in Facebook's Gorilla:
+ *
+ *   0                                   same value as last time
+ *   1 0 <meaningful bits>               XOR fits the sensor's previous window
+ *   1 1 <5: leading> <5: length-1> <bits> new window
+ *
+ * The slot is the sensor's position in the block header's name list, in as
+ * few bits as the number of enabled sensors needs (3 bits for up to 8).
+ *
+ * Entries are packed into blocks of at most BlockBytes payload bytes. Every
+ * block starts with no sensor history, so a reader can start decoding at any
+ * block boundary. Finish a block at each flash flush point so a lost page
+ * loses only its own values.
+ *
+ * A finished block is {blockName, entry count, payload bytes, sensor count,
+ * names, payload}, with entry count and payload bytes as little-endian
+ * uint16. Only sensors passed to enableSensor() are compressed; the caller
+ * keeps writing Record_t for the others. Enable every sensor before the
+ * first add(): the slot width is fixed for the whole block.
+ *
+ * Example:
+ *     XorFloatCompressor<4> compressor;
+ *     compressor.enableSensor(ALTITUDE);
+ *     if (!compressor.add(ALTITUDE, altitude)) {      // block full
+ *         flash.write(block, compressor.finishBlock(block));
+ *         compressor.add(ALTITUDE, altitude);
+ *     }
+ *
+ * @tparam MaxSensors Number of sensors that can be enabled
+ * @tparam BlockBytes Payload bytes per block (at most 65535)
+ */
+template <std::size_t MaxSensors, std::size_t BlockBytes = 256>
+class XorFloatCompressor {
+    static_assert(MaxSensors > 0 && MaxSensors <= 255, "MaxSensors must be 1 to 255");
+    static_assert(BlockBytes * 8 >= xor_float::MAX_ENTRY_BITS && BlockBytes <= 0xFFFF,
+                  "BlockBytes must fit one entry and a uint16 length");
+
+public:
+    /** @brief Largest block finishBlock() can write. */
+    static const std::size_t MAX_BLOCK_SIZE = xor_float::HEADER_SIZE + MaxSensors + BlockBytes;
+
+    /**
+     * @param blockName Name byte that marks a compressed block in the log.
+     */
+    explicit XorFloatCompressor(uint8_t blockName = 0x7D)
+        : blockName_(blockName), sensorCount_(0), packer_(payload_, BlockBytes), entries_(0) {}
+
+    /**
+     * @brief Compresses name from now on.
+     * @return false when MaxSensors are already enabled, or the current block has entries.
+     */
+    bool enableSensor(uint8_t name) {
+        if (find(name) != nullptr) {
+            return true;
+        }
+        if (sensorCount_ == MaxSensors || entries_ > 0) {
+            return false;
+        }
+        sensors_[sensorCount_].name = name;
+        resetSensor(sensors_[sensorCount_]);
+        sensorCount_++;
+        return true;
+    }
+
+    bool isEnabled(uint8_t name) const { return find(name) != nullptr; }
+
+    /**
+     * @brief Appends a value to the current block.
+     * @return false if name is not enabled, or the block has no room (finish it and retry).
+     */
+    bool add(uint8_t name, float value) { return addBits(name, xor_float::floatBits(value)); }
+
+    /** @brief As add(), for any 32-bit pattern. */
+    bool addBits(uint8_t name, uint32_t bits) {
+        xor_float::SensorState* sensor = find(name);
+        if (sensor == nullptr || !hasRoom()) {
+            return false;
+        }
+        packer_.write(static_cast<uint32_t>(sensor - sensors_), xor_float::slotBits(sensorCount_));
+        const uint32_t x = bits ^ sensor->previous;
+        sensor->previous = bits;
+        entries_++;
+        if (x == 0) {
+            packer_.write(0, 1);
+            return true;
+        }
+        packer_.write(1, 1);
+        const uint8_t leading = xor_float::leadingZeros(x);
+        const uint8_t trailing = xor_float::trailingZeros(x);
+        if (sensor->haveWindow && leading >= sensor->leading && trailing >= sensor->trailing) {
+            packer_.write(0, 1);
+            packer_.write(x >> sensor->trailing, static_cast<uint8_t>(32 - sensor->leading - sensor->trailing));
+            return true;
+        }
+        const uint8_t length = static_cast<uint8_t>(32 - leading - trailing);
+        packer_.write(1, 1);
+        packer_.write(leading, 5);
+        packer_.write(length - 1U, 5);
+        packer_.write(x >> trailing, length);
+        sensor->leading = leading;
+        sensor->trailing = trailing;
+        sensor->haveWindow = true;
+        return true;
+    }
+
+    /**
+     * @brief Writes the current block into out (at least MAX_BLOCK_SIZE bytes) and starts a new one.
+     * @return Bytes written, 0 if the block was empty.
+     */
+    std::size_t finishBlock(uint8_t* out) {
+        if (entries_ == 0) {
+            return 0;
+        }
+        const std::size_t payloadBytes = packer_.getSize();
+        out[0] = blockName_;
+        out[1] = static_cast<uint8_t>(entries_);
+        out[2] = static_cast<uint8_t>(entries_ >> 8);
+        out[3] = static_cast<uint8_t>(payloadBytes);
+        out[4] = static_cast<uint8_t>(payloadBytes >> 8);
+        out[5] = static_cast<uint8_t>(sensorCount_);
+        for (std::size_t i = 0; i < sensorCount_; i++) {
+            out[xor_float::HEADER_SIZE + i] = sensors_[i].name;
+        }
+        const std::size_t headerSize = xor_float::HEADER_SIZE + sensorCount_;
+        std::memcpy(out + headerSize, payload_, payloadBytes);
+        startBlock();
+        return headerSize + payloadBytes;
+    }
+
+    /** @brief Drops the current block without writing it. */
+    void discardBlock() { startBlock(); }
+
+    /** @brief Values in the current block. */
+    std::size_t getEntryCount() const { return entries_; }
+
+    /** @brief Size the current block would have if finished now. */
+    std::size_t getBlockSize() const {
+        return entries_ == 0 ? 0 : xor_float::HEADER_SIZE + sensorCount_ + packer_.getSize();
+    }
+
+    uint8_t getBlockName() const { return blockName_; }
+
+private:
+    uint8_t blockName_;
+    xor_float::SensorState sensors_[MaxSensors];
+    std::size_t sensorCount_;
+    uint8_t payload_[BlockBytes];
+    BitPacker packer_;
+    uint16_t entries_;
+
+    xor_float::SensorState* find(uint8_t name) {
+        for (std::size_t i = 0; i < sensorCount_; i++) {
+            if (sensors_[i].name == name) {
+                return &sensors_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    const xor_float::SensorState* find(uint8_t name) const {
+        for (std::size_t i = 0; i < sensorCount_; i++) {
+            if (sensors_[i].name == name) {
+                return &sensors_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    bool hasRoom() const {
+        return entries_ < 0xFFFF && packer_.getSize() * 8 + xor_float::MAX_ENTRY_BITS <= BlockBytes * 8;
+    }
+
+    static void resetSensor(xor_float::SensorState& sensor) {
+        sensor.previous = 0;
+        sensor.leading = 0;
+        sensor.trailing = 0;
+        sensor.haveWindow = false;
+    }
+
+    void startBlock() {
+        for (std::size_t i = 0; i < sensorCount_; i++) {
+            resetSensor(sensors_[i]);
+        }
+        packer_ = BitPacker(payload_, BlockBytes);
+        entries_ = 0;
+    }
+};
+
+template <std::size_t MaxSensors, std::size_t BlockBytes>
+const std::size_t XorFloatCompressor<MaxSensors, BlockBytes>::MAX_BLOCK_SIZE;
+
+/**
+ * @brief Decodes one block written by XorFloatCompressor.
+ *
+ * MaxSensors must be at least the number of sensors the compressor had
+ * enabled; blocks naming more are reported as malformed.
+ *
+ * Example:
+ *     XorFloatBlockReader<4> reader(log + offset, length - offset);
+ *     uint8_t name;
+ *     float value;
+ *     while (reader.next(name, value)) { ... }
+ *     offset += reader.getBlockSize();
+ */
+template <std::size_t MaxSensors>
+class XorFloatBlockReader {
+public:
+    /**
+     * @param block     Start of the block (its name byte).
+     * @param available Bytes readable from block.
+     */
+    XorFloatBlockReader(const uint8_t* block, std::size_t available)
+        : unpacker_(block, 0), remaining_(0), blockSize_(0), sensorCount_(0), slotBits_(0), ok_(false)
+    {
+        if (available < xor_float::HEADER_SIZE) {
+            return;
+        }
+        const std::size_t entries = static_cast<std::size_t>(block[1] | (block[2] << 8));
+        const std::size_t payloadBytes = static_cast<std::size_t>(block[3] | (block[4] << 8));
+        sensorCount_ = block[5];
+        const std::size_t headerSize = xor_float::HEADER_SIZE + sensorCount_;
+        if (sensorCount_ == 0 || sensorCount_ > MaxSensors || available < headerSize ||
+            available - headerSize < payloadBytes) {
+            sensorCount_ = 0;
+            return;
+        }
+        for (std::size_t i = 0; i < sensorCount_; i++) {
+            sensors_[i].name = block[xor_float::HEADER_SIZE + i];
+            sensors_[i].previous = 0;
+            sensors_[i].leading = 0;
+            sensors_[i].trailing = 0;
+            sensors_[i].haveWindow = false;
+        }
+        slotBits_ = xor_float::slotBits(sensorCount_);
+        unpacker_ = BitUnpacker(block + headerSize, payloadBytes);
+        remaining_ = entries;
+        blockSize_ = headerSize + payloadBytes;
+        ok_ = true;
+    }
+
+    /**
+     * @brief Reads the next value.
+     * @return false at the end of the block, or if it is malformed (see ok()).
+     */
+    bool next(uint8_t& name, float& value) {
+        uint32_t bits = 0;
+        if (!nextBits(name, bits)) {
+            return false;
+        }
+        value = xor_float::bitsFloat(bits);
+        return true;
+    }
+
+    /** @brief As next(), returning the raw 32-bit pattern. */
+    bool nextBits(uint8_t& name, uint32_t& bits) {
+        if (!ok_ || remaining_ == 0) {
+            return false;
+        }
+        uint32_t code = 0;
+        if (!read(code, slotBits_)) {
+            return false;
+        }
+        if (code >= sensorCount_) {
+            return fail();
+        }
+        xor_float::SensorState* sensor = &sensors_[code];
+        name = sensor->name;
+        uint32_t x = 0;
+        if (!read(code, 1)) {
+            return false;
+        }
+        if (code == 1) {
+            if (!read(code, 1)) {
+                return false;
+            }
+            if (code == 0) {
+                if (!sensor->haveWindow) {
+                    return fail();
+                }
+                if (!read(x, static_cast<uint8_t>(32 - sensor->leading - sensor->trailing))) {
+                    return false;
+                }
+                x <<= sensor->trailing;
+            } else {
+                uint32_t leading = 0;
+                uint32_t length = 0;
+                if (!read(leading, 5) || !read(length, 5)) {
+                    return false;
+                }
+                length++;
+                if (leading + length > 32) {
+                    return fail();
+                }
+                if (!read(x, static_cast<uint8_t>(length))) {
+                    return false;
+                }
+                sensor->leading = static_cast<uint8_t>(leading);
+                sensor->trailing = static_cast<uint8_t>(32 - leading - length);
+                sensor->haveWindow = true;
+                x <<= sensor->trailing;
+            }
+        }
+        sensor->previous ^= x;
+        bits = sensor->previous;
+        remaining_--;
+        return true;
+    }
+
+    /** @brief Bytes the whole block occupies in the log (0 if the header didn't fit). */
+    std::size_t getBlockSize() const { return blockSize_; }
+
+    /** @brief Values not read yet. */
+    std::size_t getRemaining() const { return remaining_; }
+
+    /** @brief False if the block was truncated or malformed. */
+    bool ok() const { return ok_; }
+
+private:
+    BitUnpacker unpacker_;
+    std::size_t remaining_;
+    std::size_t blockSize_;
+    xor_float::SensorState sensors_[MaxSensors];
+    std::size_t sensorCount_;
+    uint8_t slotBits_;
+    bool ok_;
+
+    bool read(uint32_t& code, uint8_t bits) {
+        return unpacker_.read(code, bits) || fail();
+    }
+
+    bool fail() {
+        ok_ = false;
+        return false;
+    }
+};
+
+#endif  // XORFLOATCOMPRESSOR_H
@@ -0,0 +1,72 @@
+#ifndef DELTA_TIMESTAMP_DECODER_H
+#define DELTA_TIMESTAMP_DECODER_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "DeltaTimestampEncoder.h"
+
+// One data record with the absolute timestamp it was logged under
+struct DecodedRecord {
+    uint32_t timestamp_ms;
+    uint8_t name;
+    float data;
+};
+
+// Walks a log of timestamp records (absolute, short delta or varint delta, as
+// written by DeltaTimestampEncoder) interleaved with 5-byte Record_t data
+// records {name, float}, and rebuilds the absolute timeline.
+// Plain TimestampRecord_t logs decode too: they are all absolute records.
+// A 0xFF byte where a record should start is erased flash and ends the log.
+//
+// Returns false if the log ends in the middle of a record or a data record
+// appears before any timestamp. Whatever was decoded up to that point is kept.
+inline bool decodeDeltaTimestampLog(const uint8_t* log, size_t length, std::vector<DecodedRecord>& out,
+                                    uint8_t absoluteName = 0x7F, uint8_t deltaName = 0x7E) {
+    uint32_t timestamp = 0;
+    bool haveTimestamp = false;
+    size_t offset = 0;
+    while (offset < length) {
+        const uint8_t tag = log[offset];
+        if (tag == 0xFF) {
+            break;
+        }
+        if (tag & DeltaTimestampEncoder::SHORT_DELTA_FLAG) {
+            if (!haveTimestamp) {
+                return false;
+            }
+            timestamp += tag - DeltaTimestampEncoder::SHORT_DELTA_FLAG;
+            offset += 1;
+        } else if (tag == deltaName) {
+            uint32_t delta = 0;
+            const size_t n = varint::decode(log + offset + 1, length - offset - 1, delta);
+            if (n == 0 || !haveTimestamp) {
+                return false;
+            }
+            timestamp += delta;
+            offset += 1 + n;
+        } else if (tag == absoluteName) {
+            if (length - offset < 5) {
+                return false;
+            }
+            timestamp = static_cast<uint32_t>(log[offset + 1]) | (static_cast<uint32_t>(log[offset + 2]) << 8) |
+                        (static_cast<uint32_t>(log[offset + 3]) << 16) | (static_cast<uint32_t>(log[offset + 4]) << 24);
+            haveTimestamp = true;
+            offset += 5;
+        } else {
+            if (length - offset < 5 || !haveTimestamp) {
+                return false;
+            }
+            DecodedRecord record;
+            record.timestamp_ms = timestamp;
+            record.name = tag;
+            std::memcpy(&record.data, log + offset + 1, sizeof(float));
+            out.push_back(record);
+            offset += 5;
+        }
+    }
+    return true;
+}
+
+#endif // DELTA_TIMESTAMP_DECODER_H
@@ -0,0 +1,262 @@
+#ifndef FILE_BACKED_SPI_FLASH_H
+#define FILE_BACKED_SPI_FLASH_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Latency of each flash operation, in nanoseconds so SPI byte times stay exact.
+// The defaults are W25Q128 typical datasheet numbers on a 24 MHz SPI bus.
+struct FlashTiming {
+    uint64_t command_ns;          // Opcode, address and chip-select per call
+    uint64_t readByte_ns;         // SPI transfer per byte read
+    uint64_t writeByte_ns;        // SPI transfer per byte written
+    uint64_t pageProgram_ns;      // Busy time per page touched by a write
+    uint64_t sectorErase_ns;      // 4 KB
+    uint64_t blockErase_ns;       // 64 KB
+    uint64_t chipErase_ns;
+
+    FlashTiming()
+        : command_ns(2000), readByte_ns(333), writeByte_ns(333), pageProgram_ns(700000),
+          sectorErase_ns(45000000), blockErase_ns(150000000), chipErase_ns(40000000000ULL) {}
+
+    // Datasheet maximums, for worst-case runs
+    static FlashTiming worstCase() {
+        FlashTiming timing;
+        timing.pageProgram_ns = 3000000;
+        timing.sectorErase_ns = 400000000;
+        timing.blockErase_ns = 2000000000;
+        timing.chipErase_ns = 200000000000ULL;
+        return timing;
+    }
+
+    // No latency at all, for tests that only care about contents
+    static FlashTiming instant() {
+        FlashTiming timing;
+        timing.command_ns = timing.readByte_ns = timing.writeByte_ns = 0;
+        timing.pageProgram_ns = timing.sectorErase_ns = timing.blockErase_ns = timing.chipErase_ns = 0;
+        return timing;
+    }
+};
+
+// Adafruit_SPIFlash stand-in whose contents live in a memory-mapped file, so
+// they outlive the test and can be fed to data/decode_flight_log. Every call
+// blocks like the real driver does and advances a virtual clock by the
+// FlashTiming cost of the operation; the code under test can add its own
+// work with advance_us(). Writes behave like NOR flash: they only clear bits,
+// and bytes that end up different from what was written, because they weren't
+// erased first, are counted.
+//
+// A new file is created erased (0xFF). An existing one keeps its contents,
+// growing with erased bytes if it is smaller than the chip.
+//
+// Example:
+//     FileBackedSPIFlash flash("flight.bin", 16UL * 1024 * 1024);
+//     DoubleBufferedFlashWriter<FileBackedSPIFlash> writer(flash, 4096, flash.size());
+//     ... log the flight, calling flash.advance_us() for the rest of each loop ...
+//     std::cout << flash.getBusy_us() << " us in flash calls\n";
+//
+// On Windows the file is read into memory and written back by sync() and the
+// destructor instead of being mapped.
+class FileBackedSPIFlash {
+public:
+    static const uint32_t PAGE_SIZE = 256;
+    static const uint32_t SECTOR_SIZE = 4096;
+    static const uint32_t BLOCK_SIZE = 65536;
+
+    FileBackedSPIFlash(const std::string& path, uint32_t size, const FlashTiming& timing = FlashTiming())
+        : path_(path), size_(size), timing_(timing), memory_(nullptr), clock_ns_(0), busy_ns_(0), reads_(0),
+          bytesRead_(0), writes_(0), bytesWritten_(0), pagePrograms_(0), erases_(0), unerasedWrites_(0) {
+        open();
+    }
+
+    ~FileBackedSPIFlash() {
+        sync();
+#ifndef _WIN32
+        if (memory_) {
+            munmap(memory_, size_);
+        }
+#endif
+    }
+
+    // Adafruit_SPIFlash API
+
+    bool begin() { return memory_ != nullptr; }
+    uint32_t size() const { return size_; }
+    uint16_t pageSize() const { return PAGE_SIZE; }
+    uint32_t numPages() const { return size_ / PAGE_SIZE; }
+    void waitUntilReady() {}
+
+    uint32_t readBuffer(uint32_t address, uint8_t* buffer, uint32_t length) {
+        if (!inRange(address, length)) {
+            return 0;
+        }
+        spend(timing_.command_ns + length * timing_.readByte_ns);
+        std::memcpy(buffer, memory_ + address, length);
+        reads_++;
+        bytesRead_ += length;
+        return length;
+    }
+
+    // One program command per page touched, as the driver splits it
+    uint32_t writeBuffer(uint32_t address, const uint8_t* buffer, uint32_t length) {
+        if (!inRange(address, length)) {
+            return 0;
+        }
+        uint32_t done = 0;
+        while (done < length) {
+            const uint32_t at = address + done;
+            uint32_t chunk = PAGE_SIZE - at % PAGE_SIZE;
+            if (chunk > length - done) {
+                chunk = length - done;
+            }
+            spend(timing_.command_ns + chunk * timing_.writeByte_ns + timing_.pageProgram_ns);
+            for (uint32_t i = 0; i < chunk; i++) {
+                memory_[at + i] &= buffer[done + i];
+                if (memory_[at + i] != buffer[done + i]) {
+                    unerasedWrites_++;
+                }
+            }
+            pagePrograms_++;
+            done += chunk;
+        }
+        writes_++;
+        bytesWritten_ += length;
+        return length;
+    }
+
+    bool eraseSector(uint32_t sectorNumber) {
+        return erase(sectorNumber * SECTOR_SIZE, SECTOR_SIZE, timing_.sectorErase_ns);
+    }
+
+    bool eraseBlock(uint32_t blockNumber) { return erase(blockNumber * BLOCK_SIZE, BLOCK_SIZE, timing_.blockErase_ns); }
+
+    bool eraseChip() { return erase(0, size_, timing_.chipErase_ns); }
+
+    // Virtual clock
+
+    uint64_t now_us() const { return clock_ns_ / 1000; }
+
+    // Time the caller spends not talking to the flash
+    void advance_us(uint64_t us) { clock_ns_ += us * 1000; }
+
+    // Time spent inside flash calls
+    uint64_t getBusy_us() const { return busy_ns_ / 1000; }
+
+    const FlashTiming& getTiming() const { return timing_; }
+
+    // Counters
+
+    uint32_t getReads() const { return reads_; }
+    uint64_t getBytesRead() const { return bytesRead_; }
+    uint32_t getWrites() const { return writes_; }
+    uint64_t getBytesWritten() const { return bytesWritten_; }
+    uint32_t getPagePrograms() const { return pagePrograms_; }
+    uint32_t getErases() const { return erases_; }
+    uint32_t getUnerasedWrites() const { return unerasedWrites_; }
+
+    void resetStats() {
+        clock_ns_ = busy_ns_ = 0;
+        reads_ = writes_ = pagePrograms_ = erases_ = unerasedWrites_ = 0;
+        bytesRead_ = bytesWritten_ = 0;
+    }
+
+    // Direct access, free of charge, for checking contents
+    const uint8_t* data() const { return memory_; }
+
+    // Pushes the contents to the file
+    void sync() {
+#ifndef _WIN32
+        if (memory_) {
+            msync(memory_, size_, MS_SYNC);
+        }
+#else
+        std::FILE* file = std::fopen(path_.c_str(), "wb");
+        if (file) {
+            std::fwrite(memory_, 1, size_, file);
+            std::fclose(file);
+        }
+#endif
+    }
+
+private:
+    std::string path_;
+    uint32_t size_;
+    FlashTiming timing_;
+    uint8_t* memory_;
+#ifdef _WIN32
+    std::vector<uint8_t> buffer_;
+#endif
+    uint64_t clock_ns_;
+    uint64_t busy_ns_;
+    uint32_t reads_;
+    uint64_t bytesRead_;
+    uint32_t writes_;
+    uint64_t bytesWritten_;
+    uint32_t pagePrograms_;
+    uint32_t erases_;
+    uint32_t unerasedWrites_;
+
+    bool inRange(uint32_t address, uint32_t length) const {
+        return memory_ != nullptr && address <= size_ && length <= size_ - address;
+    }
+
+    void spend(uint64_t ns) {
+        clock_ns_ += ns;
+        busy_ns_ += ns;
+    }
+
+    bool erase(uint32_t address, uint32_t length, uint64_t cost_ns) {
+        if (length == 0 || !inRange(address, length)) {
+            return false;
+        }
+        spend(timing_.command_ns + cost_ns);
+        std::memset(memory_ + address, 0xFF, length);
+        erases_++;
+        return true;
+    }
+
+    void open() {
+#ifndef _WIN32
+        const int fd = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        const off_t existing = fstat(fd, &info) == 0 ? info.st_size : 0;
+        if (existing < static_cast<off_t>(size_) && ftruncate(fd, size_) != 0) {
+            close(fd);
+            return;
+        }
+        void* map = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            return;
+        }
+        memory_ = static_cast<uint8_t*>(map);
+        // ftruncate grows the file with zeros; flash grows erased
+        if (existing < static_cast<off_t>(size_)) {
+            std::memset(memory_ + existing, 0xFF, size_ - static_cast<uint32_t>(existing));
+        }
+#else
+        buffer_.assign(size_, 0xFF);
+        std::FILE* file = std::fopen(path_.c_str(), "rb");
+        if (file) {
+            std::fread(buffer_.data(), 1, size_, file);
+            std::fclose(file);
+        }
+        memory_ = buffer_.data();
+#endif
+    }
+};
+
+#endif  // FILE_BACKED_SPI_FLASH_H
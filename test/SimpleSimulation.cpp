@@ -9,6 +9,7 @@ SimpleSimulator::SimpleSimulator(uint32_t launchTime_ms, float motorAcceleration
       altitude_(0.0f),
       velocity_(0.0f),
       netAcceleration_(0.0f),
+      hasLanded_(false),
       apogeeAltitude_(0.0f),
       apogeeTimestamp_ms_(0)
 {
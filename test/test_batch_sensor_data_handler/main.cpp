@@ -0,0 +1,541 @@
+#include "unity.h"
+#include "BatchSensorDataHandler.h"
+#include "data_handling/SensorDataHandler.h"
+#include "data_handling/DataPoint.h"
+#include "data_handling/DataSaver.h"
+#include "ArduinoHAL.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+MockSerial Serial;
+
+void setUp(void) {
+    Serial.clear();
+}
+
+void tearDown(void) {
+    Serial.clear();
+}
+
+// ---------------------------------------------------------------------
+// Mock savers
+// ---------------------------------------------------------------------
+
+// Only implements the per-sample path, so batches go through the default loop
+class MockDataSaver : public IBatchDataSaver {
+public:
+    struct SavedRecord {
+        DataPoint data;
+        uint8_t sensorName;
+    };
+
+    std::vector<SavedRecord> savedRecords;
+    int status = 0;
+
+    virtual int saveDataPoint(const DataPoint& data, uint8_t sensorName) override {
+        SavedRecord record = { data, sensorName };
+        savedRecords.push_back(record);
+        return status;
+    }
+};
+
+// Records how the batch entry point was called
+class MockBatchDataSaver : public MockDataSaver {
+public:
+    std::vector<std::size_t> batchSizes;
+
+    virtual int saveDataPoints(const DataPoint* data, std::size_t count, uint8_t name) override {
+        batchSizes.push_back(count);
+        return IBatchDataSaver::saveDataPoints(data, count, name);
+    }
+};
+
+static std::vector<DataPoint> makeFifoStream(std::size_t count, uint32_t seed) {
+    std::vector<DataPoint> stream;
+    uint32_t t = 1000;
+    for (std::size_t i = 0; i < count; i++) {
+        seed = seed * 1103515245U + 12345U;
+        t += (seed >> 16) % 4;  // 0-3 ms steps, including repeated timestamps
+        stream.push_back(DataPoint(t, static_cast<float>(i)));
+    }
+    return stream;
+}
+
+// ---------------------------------------------------------------------
+// Test Cases
+// ---------------------------------------------------------------------
+
+void test_batch_keeps_the_same_samples_as_per_sample_path(void) {
+    const uint16_t intervals[] = {0, 1, 5, 50};
+    const std::size_t blockSizes[] = {1, 7, 32, 100};
+    std::vector<DataPoint> stream = makeFifoStream(2000, 7);
+
+    for (uint16_t interval : intervals) {
+        for (std::size_t block : blockSizes) {
+            MockDataSaver reference;
+            SensorDataHandler perSample(9, &reference);
+            perSample.restrictSaveSpeed(interval);
+
+            MockBatchDataSaver batched;
+            BatchSensorDataHandler handler(9, &batched);
+            handler.restrictSaveSpeed(interval);
+
+            for (std::size_t i = 0; i < stream.size(); i += block) {
+                const std::size_t n = i + block < stream.size() ? block : stream.size() - i;
+                for (std::size_t j = 0; j < n; j++) {
+                    perSample.addData(stream[i + j]);
+                }
+                handler.addData(&stream[i], n);
+            }
+
+            TEST_ASSERT_EQUAL(reference.savedRecords.size(), batched.savedRecords.size());
+            for (std::size_t i = 0; i < reference.savedRecords.size(); i++) {
+                TEST_ASSERT_EQUAL(reference.savedRecords[i].data.timestamp_ms, batched.savedRecords[i].data.timestamp_ms);
+                TEST_ASSERT_EQUAL_FLOAT(reference.savedRecords[i].data.data, batched.savedRecords[i].data.data);
+                TEST_ASSERT_EQUAL_UINT8(9, batched.savedRecords[i].sensorName);
+            }
+            for (std::size_t size : batched.batchSizes) {
+                TEST_ASSERT_TRUE(size > 0 && size <= BatchSensorDataHandler::BATCH_SIZE);
+            }
+        }
+    }
+}
+
+void test_survivors_are_forwarded_in_one_call(void) {
+    MockBatchDataSaver saver;
+    BatchSensorDataHandler handler(3, &saver);
+    handler.restrictSaveSpeed(10);
+
+    // 32 samples 5 ms apart: every other one survives the 10 ms interval
+    DataPoint fifo[32];
+    for (uint32_t i = 0; i < 32; i++) {
+        fifo[i] = DataPoint(1000 + i * 5, static_cast<float>(i));
+    }
+    handler.addData(fifo, 32);
+
+    TEST_ASSERT_EQUAL(1, saver.batchSizes.size());
+    TEST_ASSERT_EQUAL(11, saver.batchSizes[0]);
+
+    // 100 unrestricted samples are split into BATCH_SIZE chunks
+    handler.restrictSaveSpeed(0);
+    saver.batchSizes.clear();
+    DataPoint burst[100];
+    for (uint32_t i = 0; i < 100; i++) {
+        burst[i] = DataPoint(2000 + i, 0.0f);
+    }
+    handler.addData(burst, 100);
+    TEST_ASSERT_EQUAL(4, saver.batchSizes.size());
+    TEST_ASSERT_EQUAL(32, saver.batchSizes[0]);
+    TEST_ASSERT_EQUAL(4, saver.batchSizes[3]);
+
+    // Nothing survives, nothing is called
+    saver.batchSizes.clear();
+    for (uint32_t i = 0; i < 100; i++) {
+        burst[i] = DataPoint(2099, 0.0f);
+    }
+    handler.addData(burst, 100);
+    TEST_ASSERT_EQUAL(0, saver.batchSizes.size());
+    TEST_ASSERT_EQUAL(0, handler.addData(burst, 0));
+}
+
+void test_saver_error_is_returned(void) {
+    MockDataSaver saver;
+    BatchSensorDataHandler handler(1, &saver);
+    DataPoint fifo[4] = {DataPoint(10, 1.0f), DataPoint(20, 2.0f), DataPoint(30, 3.0f), DataPoint(40, 4.0f)};
+
+    TEST_ASSERT_EQUAL(0, handler.addData(fifo, 2));
+    saver.status = -1;
+    TEST_ASSERT_EQUAL(-1, handler.addData(fifo + 2, 2));
+    // Every survivor was still offered to the saver
+    TEST_ASSERT_EQUAL(4, saver.savedRecords.size());
+    TEST_ASSERT_EQUAL(-1, handler.addData(DataPoint(50, 5.0f)));
+}
+
+void test_average_mode_logs_mean_since_last_save(void) {
+    MockDataSaver saver;
+    BatchSensorDataHandler handler(2, &saver);
+    handler.restrictSaveSpeed(3);
+    handler.setDecimationMode(DECIMATE_AVERAGE);
+    TEST_ASSERT_EQUAL(DECIMATE_AVERAGE, handler.getDecimationMode());
+
+    // The first sample is saved on its own, then one save per 4 ms
+    for (uint32_t t = 100; t <= 108; t++) {
+        handler.addData(DataPoint(t, static_cast<float>(t - 100)));
+    }
+    TEST_ASSERT_EQUAL(3, saver.savedRecords.size());
+    TEST_ASSERT_EQUAL(100, saver.savedRecords[0].data.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, saver.savedRecords[0].data.data);
+    TEST_ASSERT_EQUAL(104, saver.savedRecords[1].data.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(2.5f, saver.savedRecords[1].data.data);  // mean of 1..4
+    TEST_ASSERT_EQUAL(108, saver.savedRecords[2].data.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(6.5f, saver.savedRecords[2].data.data);  // mean of 5..8
+
+    // Same result when the samples arrive as a FIFO block
+    MockDataSaver blockSaver;
+    BatchSensorDataHandler blockHandler(2, &blockSaver);
+    blockHandler.restrictSaveSpeed(3);
+    blockHandler.setDecimationMode(DECIMATE_AVERAGE);
+    DataPoint fifo[9];
+    for (uint32_t t = 100; t <= 108; t++) {
+        fifo[t - 100] = DataPoint(t, static_cast<float>(t - 100));
+    }
+    blockHandler.addData(fifo, 5);
+    blockHandler.addData(fifo + 5, 4);
+    TEST_ASSERT_EQUAL(3, blockSaver.savedRecords.size());
+    for (std::size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(saver.savedRecords[i].data.timestamp_ms, blockSaver.savedRecords[i].data.timestamp_ms);
+        TEST_ASSERT_EQUAL_FLOAT(saver.savedRecords[i].data.data, blockSaver.savedRecords[i].data.data);
+    }
+
+    // With no interval every sample is its own average
+    MockDataSaver unrestrictedSaver;
+    BatchSensorDataHandler unrestricted(2, &unrestrictedSaver);
+    unrestricted.setDecimationMode(DECIMATE_AVERAGE);
+    unrestricted.addData(fifo, 9);
+    TEST_ASSERT_EQUAL(9, unrestrictedSaver.savedRecords.size());
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, unrestrictedSaver.savedRecords[7].data.data);
+}
+
+void test_average_mode_holds_a_large_offset_over_long_intervals(void) {
+    // Barometer on the pad at 1 kHz, averaged over 1 s, 5 s and 60 s
+    const float pressure = 101325.3f;
+    const uint16_t intervals_ms[3] = {999, 4999, 59999};
+    for (int k = 0; k < 3; k++) {
+        MockDataSaver saver;
+        BatchSensorDataHandler handler(3, &saver);
+        handler.restrictSaveSpeed(intervals_ms[k]);
+        handler.setDecimationMode(DECIMATE_AVERAGE);
+        for (uint32_t t = 0; t <= 3u * (intervals_ms[k] + 1u); t++) {
+            handler.addData(DataPoint(1000 + t, pressure));
+        }
+        TEST_ASSERT_TRUE(saver.savedRecords.size() >= 3);
+        for (std::size_t i = 0; i < saver.savedRecords.size(); i++) {
+            TEST_ASSERT_FLOAT_WITHIN(0.01f, pressure, saver.savedRecords[i].data.data);
+        }
+    }
+}
+
+void test_average_mode_rejects_aliased_tone(void) {
+    // 3 g offset plus a 1 g, 475 Hz vibration sampled at 1 kHz and logged at 25 Hz.
+    // 475 Hz is an exact multiple of 25 Hz, so dropping samples aliases it to DC.
+    const float pi = 3.14159265f;
+    MockDataSaver dropSaver;
+    BatchSensorDataHandler drop(5, &dropSaver);
+    drop.restrictSaveSpeed(39);
+    MockDataSaver averageSaver;
+    BatchSensorDataHandler average(5, &averageSaver);
+    average.restrictSaveSpeed(39);
+    average.setDecimationMode(DECIMATE_AVERAGE);
+
+    DataPoint fifo[32];
+    uint32_t t = 1;
+    for (int block = 0; block < 125; block++) {  // 4 s
+        for (int i = 0; i < 32; i++, t++) {
+            const float phase = 2.0f * pi * 475.0f * static_cast<float>(t) / 1000.0f;
+            fifo[i] = DataPoint(t, 3.0f + std::sin(phase + pi / 2.0f));
+        }
+        drop.addData(fifo, 32);
+        average.addData(fifo, 32);
+    }
+
+    TEST_ASSERT_EQUAL(dropSaver.savedRecords.size(), averageSaver.savedRecords.size());
+    TEST_ASSERT_GREATER_THAN(95, averageSaver.savedRecords.size());
+    float worstDrop = 0.0f;
+    float worstAverage = 0.0f;
+    // Skip the first save, which is a single raw sample in both modes
+    for (std::size_t i = 1; i < averageSaver.savedRecords.size(); i++) {
+        worstDrop = std::max(worstDrop, std::fabs(dropSaver.savedRecords[i].data.data - 3.0f));
+        worstAverage = std::max(worstAverage, std::fabs(averageSaver.savedRecords[i].data.data - 3.0f));
+    }
+    std::cout << "475 Hz tone logged at 25 Hz: drop error " << worstDrop
+              << " g, average error " << worstAverage << " g\n";
+    TEST_ASSERT_GREATER_THAN(0.5f, worstDrop);
+    TEST_ASSERT_LESS_THAN(0.01f, worstAverage);
+}
+
+void test_deadband_saves_on_change_or_silence(void) {
+    MockDataSaver saver;
+    BatchSensorDataHandler handler(6, &saver);
+    handler.setDeadband(0.5f, 1000);
+
+    handler.addData(DataPoint(10, 100.0f));   // first value is always saved
+    handler.addData(DataPoint(20, 100.4f));   // within the deadband
+    handler.addData(DataPoint(30, 99.6f));    // within the deadband
+    TEST_ASSERT_EQUAL(1, saver.savedRecords.size());
+
+    handler.addData(DataPoint(40, 100.6f));   // moved 0.6
+    TEST_ASSERT_EQUAL(2, saver.savedRecords.size());
+    TEST_ASSERT_EQUAL_FLOAT(100.6f, saver.savedRecords[1].data.data);
+
+    // Slow drift is measured from the last saved value, not the last sample
+    handler.addData(DataPoint(50, 100.9f));
+    handler.addData(DataPoint(60, 101.2f));
+    TEST_ASSERT_EQUAL(3, saver.savedRecords.size());
+    TEST_ASSERT_EQUAL(60, saver.savedRecords[2].data.timestamp_ms);
+
+    // A flat channel is still saved once per maxSilence
+    handler.addData(DataPoint(1059, 101.2f));
+    TEST_ASSERT_EQUAL(3, saver.savedRecords.size());
+    handler.addData(DataPoint(1060, 101.2f));
+    TEST_ASSERT_EQUAL(4, saver.savedRecords.size());
+
+    handler.clearDeadband();
+    handler.addData(DataPoint(1061, 101.2f));
+    TEST_ASSERT_EQUAL(5, saver.savedRecords.size());
+}
+
+void test_deadband_combines_with_interval_and_average(void) {
+    MockDataSaver saver;
+    BatchSensorDataHandler handler(7, &saver);
+    handler.restrictSaveSpeed(9);
+    handler.setDecimationMode(DECIMATE_AVERAGE);
+    handler.setDeadband(1.0f, 60000);
+
+    handler.addData(DataPoint(99, 10.0f));
+    DataPoint fifo[40];
+    for (uint32_t i = 0; i < 40; i++) {
+        // Alternating +-3 averages to 10 over any even number of samples
+        fifo[i] = DataPoint(100 + i, 10.0f + ((i % 2) ? 3.0f : -3.0f));
+    }
+    handler.addData(fifo, 40);
+    // Only the first sample: every later average is within the deadband
+    TEST_ASSERT_EQUAL(1, saver.savedRecords.size());
+
+    for (uint32_t i = 0; i < 40; i++) {
+        fifo[i] = DataPoint(140 + i, 20.0f);
+    }
+    handler.addData(fifo, 40);
+    // Each interval held back by the deadband starts a fresh average, so the
+    // first interval at the new level is logged at that level
+    TEST_ASSERT_EQUAL(2, saver.savedRecords.size());
+    TEST_ASSERT_EQUAL(149, saver.savedRecords[1].data.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, saver.savedRecords[1].data.data);
+}
+
+void test_average_mode_logs_a_step_after_long_silence(void) {
+    // Baro at 100 Hz on the pad, 10 Pa deadband, up to 10 min of silence
+    MockDataSaver averageSaver;
+    MockDataSaver dropSaver;
+    BatchSensorDataHandler average(8, &averageSaver);
+    BatchSensorDataHandler drop(8, &dropSaver);
+    average.setDecimationMode(DECIMATE_AVERAGE);
+    average.restrictSaveSpeed(39);
+    drop.restrictSaveSpeed(39);
+    average.setDeadband(10.0f, 600000);
+    drop.setDeadband(10.0f, 600000);
+
+    // Five quiet minutes at a constant level, then a 50 Pa step
+    const uint32_t step_ms = 300000;
+    uint32_t t = 0;
+    for (; t < step_ms; t += 10) {
+        average.addData(DataPoint(t, 101325.3f));
+        drop.addData(DataPoint(t, 101325.3f));
+    }
+    TEST_ASSERT_EQUAL(1, averageSaver.savedRecords.size());
+    TEST_ASSERT_EQUAL(1, dropSaver.savedRecords.size());
+    for (; t < step_ms + 1000; t += 10) {
+        average.addData(DataPoint(t, 101375.3f));
+        drop.addData(DataPoint(t, 101375.3f));
+    }
+    TEST_ASSERT_EQUAL(2, dropSaver.savedRecords.size());
+    TEST_ASSERT_TRUE(averageSaver.savedRecords.size() >= 2);
+    // Logged within two averaging intervals, at the new level or on the way to it
+    const DataPoint logged = averageSaver.savedRecords[1].data;
+    TEST_ASSERT_TRUE(logged.timestamp_ms - step_ms <= 80);
+    TEST_ASSERT_TRUE(logged.data > 101335.3f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 101375.3f, averageSaver.savedRecords.back().data.data);
+}
+
+void test_deadband_over_two_hour_pad_hold(void) {
+    // Baro at 100 Hz with 2 Pa noise for two hours, then a 50 Pa step
+    MockDataSaver unrestrictedSaver;
+    BatchSensorDataHandler unrestricted(8, &unrestrictedSaver);
+    MockDataSaver deadbandSaver;
+    BatchSensorDataHandler deadband(8, &deadbandSaver);
+    deadband.setDeadband(10.0f, 10000);
+
+    std::default_random_engine rng(3);
+    std::normal_distribution<float> noise(0.0f, 2.0f);
+    DataPoint fifo[32];
+    uint32_t t = 10;
+    const uint32_t holdEnd = 2U * 60U * 60U * 1000U;
+    while (t < holdEnd) {
+        for (int i = 0; i < 32; i++, t += 10) {
+            fifo[i] = DataPoint(t, 101325.0f + noise(rng));
+        }
+        unrestricted.addData(fifo, 32);
+        deadband.addData(fifo, 32);
+    }
+    const std::size_t holdSaves = deadbandSaver.savedRecords.size();
+    deadband.addData(DataPoint(t, 101275.0f));
+
+    std::cout << "2 h pad hold at 100 Hz: " << unrestrictedSaver.savedRecords.size()
+              << " points saved without deadband, " << holdSaves << " with\n";
+    TEST_ASSERT_EQUAL(holdSaves + 1, deadbandSaver.savedRecords.size());
+    TEST_ASSERT_EQUAL(t, deadbandSaver.savedRecords.back().data.timestamp_ms);
+    TEST_ASSERT_TRUE(holdSaves * 100 < unrestrictedSaver.savedRecords.size());
+    // Never silent for longer than maxSilence
+    for (std::size_t i = 1; i < holdSaves; i++) {
+        TEST_ASSERT_TRUE(deadbandSaver.savedRecords[i].data.timestamp_ms -
+                         deadbandSaver.savedRecords[i - 1].data.timestamp_ms <= 10000);
+    }
+}
+
+void test_stats_count_where_samples_went(void) {
+    MockDataSaver saver;
+    BatchSensorDataHandler handler(10, &saver);
+    handler.restrictSaveSpeed(9);
+    handler.setDeadband(1.0f, 100000);
+
+    // 1 ms steps with one 25 ms dropout; value steps from 0 to 5 half way
+    DataPoint fifo[100];
+    uint32_t t = 1000;
+    for (uint32_t i = 0; i < 100; i++) {
+        t += (i == 60) ? 25 : 1;
+        fifo[i] = DataPoint(t, i < 50 ? 0.0f : 5.0f);
+    }
+    handler.addData(fifo, 60);
+    saver.status = -3;
+    handler.addData(fifo + 60, 40);
+
+    SensorHandlerStats stats = handler.getStats();
+    TEST_ASSERT_EQUAL(100, stats.received);
+    TEST_ASSERT_EQUAL(25, stats.maxGap_ms);
+    // Every sample is accounted for exactly once
+    TEST_ASSERT_EQUAL(stats.received,
+                      stats.saved + stats.rateLimited + stats.deadbanded + stats.saverErrors);
+    TEST_ASSERT_EQUAL(2, stats.saved);        // first sample, then the step to 5
+    TEST_ASSERT_EQUAL(stats.saved + stats.saverErrors, saver.savedRecords.size());
+    TEST_ASSERT_TRUE(stats.rateLimited >= 9);
+    TEST_ASSERT_TRUE(stats.deadbanded > 50);  // once past the interval, flat samples hit the deadband
+    TEST_ASSERT_EQUAL(0, stats.saverErrors);  // nothing changed after the error was armed
+
+    // Force a save into the failing saver
+    handler.clearDeadband();
+    handler.addData(DataPoint(t + 100, 5.0f));
+    stats = handler.getStats();
+    TEST_ASSERT_EQUAL(1, stats.saverErrors);
+    TEST_ASSERT_EQUAL(100, stats.maxGap_ms);
+
+    handler.resetStats();
+    stats = handler.getStats();
+    TEST_ASSERT_EQUAL(0, stats.received);
+    TEST_ASSERT_EQUAL(0, stats.maxGap_ms);
+    // Resetting the counters doesn't reset the save interval
+    handler.addData(DataPoint(t + 101, 5.0f));
+    TEST_ASSERT_EQUAL(1, handler.getStats().rateLimited);
+}
+
+void test_stats_snapshot_is_packet_ready(void) {
+    static_assert(sizeof(SensorHandlerStats) == 6 * sizeof(uint32_t),
+                  "SensorHandlerStats should have no padding");
+    static_assert(std::is_trivially_copyable<SensorHandlerStats>::value,
+                  "SensorHandlerStats should be memcpy-able into a packet");
+
+    MockDataSaver saver;
+    BatchSensorDataHandler handler(11, &saver);
+    for (uint32_t t = 1; t <= 5; t++) {
+        handler.addData(DataPoint(t * 10, 1.0f));
+    }
+    uint8_t packet[sizeof(SensorHandlerStats)];
+    SensorHandlerStats stats = handler.getStats();
+    std::memcpy(packet, &stats, sizeof(stats));
+    SensorHandlerStats decoded;
+    std::memcpy(&decoded, packet, sizeof(decoded));
+    TEST_ASSERT_EQUAL(5, decoded.received);
+    TEST_ASSERT_EQUAL(5, decoded.saved);
+    TEST_ASSERT_EQUAL(10, decoded.maxGap_ms);
+}
+
+// ---------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------
+
+// Stand-in for a flash buffer: the batch path does one bounds check per block
+class CountingDataSaver : public IBatchDataSaver {
+public:
+    uint32_t checksum = 0;
+    std::size_t saved = 0;
+
+    virtual int saveDataPoint(const DataPoint& data, uint8_t name) override {
+        checksum += data.timestamp_ms + name;
+        saved++;
+        return 0;
+    }
+
+    virtual int saveDataPoints(const DataPoint* data, std::size_t count, uint8_t name) override {
+        for (std::size_t i = 0; i < count; i++) {
+            checksum += data[i].timestamp_ms + name;
+        }
+        saved += count;
+        return 0;
+    }
+};
+
+void test_benchmark_batch_vs_per_sample(void) {
+    const std::size_t fifoDepth = 32;
+    const int blocks = 200000;
+    std::vector<DataPoint> fifo(fifoDepth);
+
+    for (uint16_t interval : {0, 2}) {
+        CountingDataSaver perSampleSaver;
+        SensorDataHandler perSample(1, &perSampleSaver);
+        perSample.restrictSaveSpeed(interval);
+        CountingDataSaver batchSaver;
+        BatchSensorDataHandler batch(1, &batchSaver);
+        batch.restrictSaveSpeed(interval);
+
+        uint32_t t = 1000;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int b = 0; b < blocks; b++) {
+            for (std::size_t i = 0; i < fifoDepth; i++) {
+                fifo[i] = DataPoint(t++, 1.0f);
+            }
+            for (std::size_t i = 0; i < fifoDepth; i++) {
+                perSample.addData(fifo[i]);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        t = 1000;
+        for (int b = 0; b < blocks; b++) {
+            for (std::size_t i = 0; i < fifoDepth; i++) {
+                fifo[i] = DataPoint(t++, 1.0f);
+            }
+            batch.addData(fifo.data(), fifoDepth);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        const auto elapsedPerSample = t1 - t0;
+        const auto elapsedBatch = t2 - t1;
+
+        std::cout << "32-sample FIFO, interval " << interval << " ms: per-sample "
+                  << std::chrono::duration<double, std::nano>(elapsedPerSample).count() / blocks << " ns, batch "
+                  << std::chrono::duration<double, std::nano>(elapsedBatch).count() / blocks << " ns per block\n";
+        TEST_ASSERT_EQUAL(perSampleSaver.saved, batchSaver.saved);
+        TEST_ASSERT_EQUAL(perSampleSaver.checksum, batchSaver.checksum);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_keeps_the_same_samples_as_per_sample_path);
+    RUN_TEST(test_survivors_are_forwarded_in_one_call);
+    RUN_TEST(test_saver_error_is_returned);
+    RUN_TEST(test_average_mode_logs_mean_since_last_save);
+    RUN_TEST(test_average_mode_holds_a_large_offset_over_long_intervals);
+    RUN_TEST(test_average_mode_rejects_aliased_tone);
+    RUN_TEST(test_deadband_saves_on_change_or_silence);
+    RUN_TEST(test_deadband_combines_with_interval_and_average);
+    RUN_TEST(test_average_mode_logs_a_step_after_long_silence);
+    RUN_TEST(test_deadband_over_two_hour_pad_hold);
+    RUN_TEST(test_stats_count_where_samples_went);
+    RUN_TEST(test_stats_snapshot_is_packet_ready);
+    RUN_TEST(test_benchmark_batch_vs_per_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,199 @@
+#include "unity.h"
+#include "SizedCircularArray.h"
+#include "RunningAggregates.h"
+#include "data_handling/DataPoint.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+// Checks that the view lists exactly the values getFromHead() reports, oldest first
+template <typename Array>
+void assertViewMatchesGetFromHead(const Array& circularArray) {
+    CircularView<int> view = circularArray.getView();
+    TEST_ASSERT_EQUAL(circularArray.getSize(), view.size());
+    for (std::size_t i = 0; i < view.size(); i++) {
+        TEST_ASSERT_EQUAL(circularArray.getFromHead(static_cast<uint8_t>(view.size() - 1 - i)), view[i]);
+    }
+}
+
+void test_view_before_and_after_wrap(void) {
+    SizedCircularArray<int, 5> circularArray(5);
+    TEST_ASSERT_TRUE(circularArray.getView().empty());
+
+    circularArray.push(1);
+    circularArray.push(2);
+    circularArray.push(3);
+    CircularView<int> view = circularArray.getView();
+    TEST_ASSERT_EQUAL(3, view.first.size);
+    TEST_ASSERT_EQUAL(0, view.second.size);
+    TEST_ASSERT_EQUAL(1, view.first[0]);
+
+    circularArray.push(4);
+    circularArray.push(5);
+    circularArray.push(6);
+    circularArray.push(7);
+    // Storage is [6, 7, 3, 4, 5]: oldest segment 3..5, then 6..7
+    view = circularArray.getView();
+    TEST_ASSERT_EQUAL(3, view.first.size);
+    TEST_ASSERT_EQUAL(2, view.second.size);
+    TEST_ASSERT_EQUAL(3, view.first[0]);
+    TEST_ASSERT_EQUAL(5, view.first[2]);
+    TEST_ASSERT_EQUAL(6, view.second[0]);
+    TEST_ASSERT_EQUAL(7, view.second[1]);
+
+    int linear[5];
+    view.copyTo(linear);
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(3 + i, linear[i]);
+    }
+    assertViewMatchesGetFromHead(circularArray);
+}
+
+void test_view_is_zero_copy(void) {
+    SizedCircularArray<int, 4> circularArray(4);
+    circularArray.push(10);
+    CircularView<int> before = circularArray.getView();
+    circularArray.push(20);
+    // The view points into the array's storage
+    TEST_ASSERT_TRUE(before.first.data == circularArray.getView().first.data);
+}
+
+void test_pushN_matches_push(void) {
+    for (std::size_t blockSize = 1; blockSize <= 13; blockSize++) {
+        SizedCircularArray<int, 8> bulk(6);
+        SizedCircularArray<int, 8> single(6);
+        std::vector<int> block(blockSize);
+        int next = 0;
+        for (int round = 0; round < 7; round++) {
+            for (std::size_t i = 0; i < blockSize; i++) {
+                block[i] = next++;
+                single.push(block[i]);
+            }
+            bulk.pushN(block.data(), blockSize);
+            TEST_ASSERT_EQUAL(single.getHead(), bulk.getHead());
+            TEST_ASSERT_EQUAL(single.getSize(), bulk.getSize());
+            for (uint8_t k = 0; k < single.getSize(); k++) {
+                TEST_ASSERT_EQUAL(single.getFromHead(k), bulk.getFromHead(k));
+            }
+            assertViewMatchesGetFromHead(bulk);
+        }
+    }
+}
+
+void test_pushN_zero_is_noop(void) {
+    SizedCircularArray<int, 4> circularArray(4);
+    circularArray.push(1);
+    circularArray.pushN(nullptr, 0);
+    TEST_ASSERT_EQUAL(1, circularArray.getSize());
+    TEST_ASSERT_EQUAL(1, circularArray.getFromHead(0));
+}
+
+void test_pushN_with_aggregates(void) {
+    AggregatingCircularArray<int, 4> window(4);
+    const int block[6] = {5, 1, 9, 2, 7, 3};
+    window.pushN(block, 6);
+    // Window is 9, 2, 7, 3
+    TEST_ASSERT_EQUAL(4, window.getCount());
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, window.getSum());
+    TEST_ASSERT_EQUAL(2, window.getMin());
+    TEST_ASSERT_EQUAL(9, window.getMax());
+}
+
+void test_datapoint_views_and_pushN(void) {
+    SizedCircularArray<DataPoint, 6> bulk(6);
+    SizedCircularArray<DataPoint, 6> split(6);
+    SizedCircularArray<DataPoint, 6> single(6);
+    DataPoint block[4];
+    uint32_t timestamps[4];
+    float data[4];
+    for (uint32_t round = 0; round < 5; round++) {
+        for (uint32_t i = 0; i < 4; i++) {
+            block[i] = DataPoint(round * 4 + i, static_cast<float>(round * 4 + i) * 2.0f);
+            timestamps[i] = block[i].timestamp_ms;
+            data[i] = block[i].data;
+            single.push(block[i]);
+        }
+        bulk.pushN(block, 4);
+        split.pushN(timestamps, data, 4);
+    }
+    // 20 samples pushed into 6 slots: window is timestamps 14..19
+    CircularView<uint32_t> times = bulk.getTimestampView();
+    CircularView<float> values = split.getDataView();
+    TEST_ASSERT_EQUAL(6, times.size());
+    TEST_ASSERT_EQUAL(6, values.size());
+    for (uint32_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT32(14 + i, times[i]);
+        TEST_ASSERT_EQUAL_FLOAT(static_cast<float>(14 + i) * 2.0f, values[i]);
+        TEST_ASSERT_EQUAL_UINT32(single.getFromHead(static_cast<uint8_t>(5 - i)).timestamp_ms, times[i]);
+    }
+    TEST_ASSERT_EQUAL(single.getHead(), bulk.getHead());
+    TEST_ASSERT_EQUAL(single.getHead(), split.getHead());
+}
+
+// -----------------------------------------------------------------------------
+// Benchmark: replaying a block and walking the window in time order
+// -----------------------------------------------------------------------------
+void test_benchmark_pushN_and_view(void) {
+    const int blocks = 20000;
+    const std::size_t blockSize = 32;
+    static float block[blockSize];
+    for (std::size_t i = 0; i < blockSize; i++) {
+        block[i] = static_cast<float>(i);
+    }
+    SizedCircularArray<float, 200> single(200);
+    SizedCircularArray<float, 200> bulk(200);
+    volatile float sink = 0.0f;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int b = 0; b < blocks; b++) {
+        for (std::size_t i = 0; i < blockSize; i++) {
+            single.push(block[i]);
+        }
+        float sum = 0.0f;
+        for (uint8_t k = 0; k < single.getSize(); k++) {
+            sum += single.getFromHead(k);
+        }
+        sink = sum;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int b = 0; b < blocks; b++) {
+        bulk.pushN(block, blockSize);
+        CircularView<float> view = bulk.getView();
+        float sum = 0.0f;
+        for (std::size_t k = 0; k < view.first.size; k++) {
+            sum += view.first[k];
+        }
+        for (std::size_t k = 0; k < view.second.size; k++) {
+            sum += view.second[k];
+        }
+        sink = sum;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    (void)sink;
+
+    TEST_ASSERT_EQUAL_FLOAT(single.getFromHead(0), bulk.getFromHead(0));
+    std::cout << "Block of " << blockSize << " + window walk: push/getFromHead "
+              << std::chrono::duration<double, std::nano>(t1 - t0).count() / blocks << " ns, pushN/getView "
+              << std::chrono::duration<double, std::nano>(t2 - t1).count() / blocks << " ns\n";
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_view_before_and_after_wrap);
+    RUN_TEST(test_view_is_zero_copy);
+    RUN_TEST(test_pushN_matches_push);
+    RUN_TEST(test_pushN_zero_is_noop);
+    RUN_TEST(test_pushN_with_aggregates);
+    RUN_TEST(test_datapoint_views_and_pushN);
+    RUN_TEST(test_benchmark_pushN_and_view);
+    return UNITY_END();
+}
@@ -0,0 +1,175 @@
+#include "unity.h"
+#include "SizedCircularArray.h"
+#include "RunningAggregates.h"
+#include "data_handling/CircularArray.h"
+#include "data_handling/DataPoint.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+void test_layout_is_structure_of_arrays(void) {
+    SizedCircularArray<DataPoint, 5> circularArray(5);
+    for (uint32_t i = 0; i < 3; i++) {
+        circularArray.push(DataPoint(100 + i, static_cast<float>(i) + 0.5f));
+    }
+    ArraySpan<float> data = circularArray.getDataSpan();
+    ArraySpan<uint32_t> timestamps = circularArray.getTimestampSpan();
+    TEST_ASSERT_EQUAL(3, data.size);
+    TEST_ASSERT_EQUAL(3, timestamps.size);
+    // Values sit next to each other with no timestamps in between
+    TEST_ASSERT_TRUE(&data[1] == &data[0] + 1);
+    TEST_ASSERT_TRUE(&timestamps[1] == &timestamps[0] + 1);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, data[1]);
+    TEST_ASSERT_EQUAL_UINT32(101, timestamps[1]);
+}
+
+void test_behaves_like_circular_array(void) {
+    SizedCircularArray<DataPoint, 5> circularArray(5);
+    TEST_ASSERT_EQUAL_FLOAT(0, circularArray.getMedian().data);
+
+    circularArray.push(DataPoint(1, 1.0));
+    TEST_ASSERT_EQUAL_FLOAT(1.0, circularArray.getMedian().data);
+    circularArray.push(DataPoint(2, 2.0));
+    circularArray.push(DataPoint(3, 3.0));
+    circularArray.push(DataPoint(4, 4.0));
+    circularArray.push(DataPoint(5, 5.0));
+    TEST_ASSERT_EQUAL_FLOAT(3.0, circularArray.getMedian().data);
+
+    // Median is based on data, and carries the matching timestamp
+    circularArray.push(DataPoint(6, 0.0));
+    TEST_ASSERT_EQUAL_FLOAT(3.0, circularArray.getMedian().data);
+    TEST_ASSERT_EQUAL_UINT32(3, circularArray.getMedian().timestamp_ms);
+    float scratch[5];
+    TEST_ASSERT_EQUAL_UINT32(3, circularArray.getMedian(scratch).timestamp_ms);
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0, circularArray.getFromHead(0).data);
+    TEST_ASSERT_EQUAL_UINT32(6, circularArray.getFromHead(0).timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(2.0, circularArray.getFromHead(4).data);
+    TEST_ASSERT_TRUE(circularArray.isFull());
+    TEST_ASSERT_EQUAL(5, circularArray.getDataSpan().size);
+
+    circularArray.clear();
+    TEST_ASSERT_FALSE(circularArray.isFull());
+    TEST_ASSERT_EQUAL(0, circularArray.getDataSpan().size);
+}
+
+void test_matches_circular_array(void) {
+    CircularArray<DataPoint, 64> reference(40);
+    SizedCircularArray<DataPoint, 64> soa(40);
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> dist(-20.0f, 20.0f);
+    for (uint32_t i = 0; i < 1000; i++) {
+        DataPoint dp(i, dist(gen));
+        reference.push(dp);
+        soa.push(dp);
+        TEST_ASSERT_EQUAL_FLOAT(reference.getMedian().data, soa.getMedian().data);
+        for (uint8_t k = 0; k < 3; k++) {
+            TEST_ASSERT_EQUAL_UINT32(reference.getFromHead(k).timestamp_ms, soa.getFromHead(k).timestamp_ms);
+            TEST_ASSERT_EQUAL_FLOAT(reference.getFromHead(k).data, soa.getFromHead(k).data);
+        }
+    }
+}
+
+void test_aggregates_still_apply(void) {
+    AggregatingCircularArray<DataPoint, 4> window(4);
+    for (uint32_t i = 1; i <= 6; i++) {
+        window.push(DataPoint(i, static_cast<float>(i)));
+    }
+    // Window is 3, 4, 5, 6
+    TEST_ASSERT_EQUAL_FLOAT(18.0f, window.getSum());
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, window.getMin());
+    TEST_ASSERT_EQUAL_FLOAT(6.0f, window.getMax());
+    TEST_ASSERT_EQUAL(4, window.getDataSpan().size);
+}
+
+// -----------------------------------------------------------------------------
+// Benchmark: value-only scans (threshold count + sum) over a full window
+// -----------------------------------------------------------------------------
+void test_benchmark_soa_vs_aos(void) {
+    const uint8_t windowSize = MAX_CIRCULAR_ARRAY_CAPACITY;
+    const int iterations = 20000;
+    const float threshold = 10.0f;
+
+    CircularArray<DataPoint, windowSize> aos(windowSize);
+    static DataPoint rawAos[windowSize];
+    SizedCircularArray<DataPoint, windowSize> soa(windowSize);
+    std::mt19937 gen(9);
+    std::normal_distribution<float> dist(9.81f, 2.0f);
+    for (uint8_t i = 0; i < windowSize; i++) {
+        DataPoint dp(i, dist(gen));
+        aos.push(dp);
+        rawAos[i] = dp;
+        soa.push(dp);
+    }
+
+    volatile float sink = 0.0f;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        float sum = 0.0f;
+        int above = 0;
+        for (uint8_t k = 0; k < windowSize; k++) {
+            float v = aos.getFromHead(k).data;
+            sum += v;
+            above += v > threshold ? 1 : 0;
+        }
+        sink = sum + static_cast<float>(above);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        float sum = 0.0f;
+        int above = 0;
+        for (uint8_t k = 0; k < windowSize; k++) {
+            float v = rawAos[k].data;
+            sum += v;
+            above += v > threshold ? 1 : 0;
+        }
+        sink = sum + static_cast<float>(above);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    float soaSum = 0.0f;
+    for (int it = 0; it < iterations; it++) {
+        ArraySpan<float> data = soa.getDataSpan();
+        float sum = 0.0f;
+        int above = 0;
+        for (std::size_t k = 0; k < data.size; k++) {
+            float v = data[k];
+            sum += v;
+            above += v > threshold ? 1 : 0;
+        }
+        soaSum = sum;
+        sink = sum + static_cast<float>(above);
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    (void)sink;
+
+    float aosSum = 0.0f;
+    for (uint8_t k = 0; k < windowSize; k++) {
+        aosSum += rawAos[k].data;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-2, aosSum, soaSum);
+
+    double perScan = 1.0 / iterations;
+    std::cout << "Value scan over " << static_cast<int>(windowSize) << " DataPoints: "
+              << "CircularArray getFromHead " << std::chrono::duration<double, std::nano>(t1 - t0).count() * perScan << " ns, "
+              << "raw AoS " << std::chrono::duration<double, std::nano>(t2 - t1).count() * perScan << " ns, "
+              << "SoA span " << std::chrono::duration<double, std::nano>(t3 - t2).count() * perScan << " ns\n";
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_layout_is_structure_of_arrays);
+    RUN_TEST(test_behaves_like_circular_array);
+    RUN_TEST(test_matches_circular_array);
+    RUN_TEST(test_aggregates_still_apply);
+    RUN_TEST(test_benchmark_soa_vs_aos);
+    return UNITY_END();
+}
@@ -0,0 +1,217 @@
+#include "unity.h"
+#include "DeltaTimestampEncoder.h"
+#include "data_handling/DataPoint.h"
+#include "../DeltaTimestampDecoder.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+// Writes data the way DataSaverSPI does: a timestamp record whenever more
+// than timestampInterval_ms passed since the last one, then a 5-byte Record_t.
+class LogWriter {
+public:
+    LogWriter(uint32_t timestampInterval_ms, bool deltaTimestamps)
+        : interval_ms_(timestampInterval_ms), delta_(deltaTimestamps), lastTimestamp_ms_(0),
+          haveTimestamp_(false), timestampBytes_(0) {}
+
+    void saveDataPoint(const DataPoint& dp, uint8_t name) {
+        if (!haveTimestamp_ || dp.timestamp_ms - lastTimestamp_ms_ > interval_ms_) {
+            uint8_t record[DeltaTimestampEncoder::MAX_RECORD_SIZE];
+            std::size_t n;
+            if (delta_) {
+                n = encoder_.encodeTimestamp(dp.timestamp_ms, record);
+            } else {
+                // TimestampRecord_t
+                record[0] = encoder_.getAbsoluteName();
+                std::memcpy(record + 1, &dp.timestamp_ms, 4);
+                n = 5;
+            }
+            log.insert(log.end(), record, record + n);
+            timestampBytes_ += n;
+            lastTimestamp_ms_ = dp.timestamp_ms;
+            haveTimestamp_ = true;
+        }
+        // Record_t
+        uint8_t record[5];
+        record[0] = name;
+        std::memcpy(record + 1, &dp.data, 4);
+        log.insert(log.end(), record, record + 5);
+    }
+
+    std::vector<uint8_t> log;
+    DeltaTimestampEncoder encoder_;
+    std::size_t getTimestampBytes() const { return timestampBytes_; }
+    uint32_t getLastTimestamp() const { return lastTimestamp_ms_; }
+
+private:
+    uint32_t interval_ms_;
+    bool delta_;
+    uint32_t lastTimestamp_ms_;
+    bool haveTimestamp_;
+    std::size_t timestampBytes_;
+};
+
+void test_varint_round_trip(void) {
+    const uint32_t values[] = {0, 1, 127, 128, 300, 16383, 16384, 2097151, 2097152, 0xFFFFFFFFUL};
+    const std::size_t sizes[] = {1, 1, 1, 2, 2, 2, 3, 3, 4, 5};
+    for (std::size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint8_t buffer[varint::MAX_SIZE];
+        const std::size_t n = varint::encode(values[i], buffer);
+        TEST_ASSERT_EQUAL(sizes[i], n);
+        uint32_t decoded = 0;
+        TEST_ASSERT_EQUAL(n, varint::decode(buffer, n, decoded));
+        TEST_ASSERT_EQUAL_UINT32(values[i], decoded);
+        // Truncated
+        TEST_ASSERT_EQUAL(0, varint::decode(buffer, n - 1, decoded));
+    }
+    // More than five continuation bytes is malformed
+    const uint8_t tooLong[6] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+    uint32_t decoded = 0;
+    TEST_ASSERT_EQUAL(0, varint::decode(tooLong, 6, decoded));
+}
+
+void test_encoder_picks_smallest_record(void) {
+    DeltaTimestampEncoder encoder;
+    uint8_t out[DeltaTimestampEncoder::MAX_RECORD_SIZE];
+
+    TEST_ASSERT_EQUAL(5, encoder.encodeTimestamp(1000, out));  // first is absolute
+    TEST_ASSERT_EQUAL_UINT8(0x7F, out[0]);
+    TEST_ASSERT_EQUAL(1, encoder.encodeTimestamp(1010, out));
+    TEST_ASSERT_EQUAL_UINT8(0x80 | 10, out[0]);
+    TEST_ASSERT_EQUAL(1, encoder.encodeTimestamp(1010, out));  // zero delta
+    TEST_ASSERT_EQUAL_UINT8(0x80, out[0]);
+    TEST_ASSERT_EQUAL(1, encoder.encodeTimestamp(1136, out));  // 126
+    TEST_ASSERT_EQUAL_UINT8(0xFE, out[0]);
+    TEST_ASSERT_EQUAL(3, encoder.encodeTimestamp(1264, out));  // 128 -> varint
+    TEST_ASSERT_EQUAL_UINT8(0x7E, out[0]);
+    TEST_ASSERT_EQUAL(5, encoder.encodeTimestamp(1200, out));  // backwards -> absolute
+    encoder.resync();
+    TEST_ASSERT_EQUAL(5, encoder.encodeTimestamp(1201, out));
+    TEST_ASSERT_EQUAL_UINT32(1201, encoder.getLastTimestamp());
+
+    DeltaTimestampEncoder custom(0, 1);
+    TEST_ASSERT_EQUAL(5, custom.encodeTimestamp(5, out));
+    TEST_ASSERT_EQUAL_UINT8(0, out[0]);
+    TEST_ASSERT_EQUAL(3, custom.encodeTimestamp(500, out));  // 495 takes two varint bytes
+    TEST_ASSERT_EQUAL_UINT8(1, out[0]);
+}
+
+void test_delta_of_127_is_not_mistaken_for_erased_flash(void) {
+    DeltaTimestampEncoder encoder;
+    uint8_t log[32];
+    std::memset(log, 0xFF, sizeof(log));
+    std::size_t length = encoder.encodeTimestamp(1000, log);
+    const std::size_t delta = encoder.encodeTimestamp(1127, log + length);
+    TEST_ASSERT_EQUAL(2, delta);  // varint record, not 0x80 | 127 = 0xFF
+    TEST_ASSERT_EQUAL_UINT8(0x7E, log[length]);
+    length += delta;
+    const float value = 3.5f;
+    log[length] = 4;
+    std::memcpy(log + length + 1, &value, sizeof(value));
+    length += 5;
+
+    // Decoding the whole buffer stops at the erased tail
+    std::vector<DecodedRecord> decoded;
+    TEST_ASSERT_TRUE(decodeDeltaTimestampLog(log, sizeof(log), decoded));
+    TEST_ASSERT_EQUAL(1, decoded.size());
+    TEST_ASSERT_EQUAL_UINT32(1127, decoded[0].timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT8(4, decoded[0].name);
+    TEST_ASSERT_EQUAL_FLOAT(3.5f, decoded[0].data);
+}
+
+// Accel x/y/z at 100 Hz and altitude at ~20 Hz with jitter, for 60 s
+static void writeSampleMix(LogWriter& writer, std::vector<DecodedRecord>& expected) {
+    uint32_t nextBaro = 3;
+    uint32_t seed = 11;
+    for (uint32_t t = 1; t <= 60000; t++) {
+        if (t % 10 == 0) {
+            for (uint8_t axis = 0; axis < 3; axis++) {
+                const DataPoint dp(t, static_cast<float>(t) * 0.001f + axis);
+                writer.saveDataPoint(dp, axis + 1);
+                DecodedRecord record = {writer.getLastTimestamp(), static_cast<uint8_t>(axis + 1), dp.data};
+                expected.push_back(record);
+            }
+        }
+        if (t == nextBaro) {
+            const DataPoint dp(t, 100.0f + static_cast<float>(t) * 0.01f);
+            writer.saveDataPoint(dp, 9);
+            DecodedRecord record = {writer.getLastTimestamp(), 9, dp.data};
+            expected.push_back(record);
+            seed = seed * 1103515245U + 12345U;
+            nextBaro += 45 + (seed >> 16) % 11;
+        }
+    }
+}
+
+void test_decoder_rebuilds_timeline_and_overhead_drops(void) {
+    const uint32_t intervals[] = {0, 100};
+    for (uint32_t interval : intervals) {
+        LogWriter legacy(interval, false);
+        LogWriter delta(interval, true);
+        std::vector<DecodedRecord> expectedLegacy;
+        std::vector<DecodedRecord> expectedDelta;
+        writeSampleMix(legacy, expectedLegacy);
+        writeSampleMix(delta, expectedDelta);
+
+        std::vector<DecodedRecord> decodedLegacy;
+        std::vector<DecodedRecord> decodedDelta;
+        TEST_ASSERT_TRUE(decodeDeltaTimestampLog(legacy.log.data(), legacy.log.size(), decodedLegacy));
+        TEST_ASSERT_TRUE(decodeDeltaTimestampLog(delta.log.data(), delta.log.size(), decodedDelta));
+
+        // Both logs decode to the same timeline
+        TEST_ASSERT_EQUAL(expectedDelta.size(), decodedDelta.size());
+        TEST_ASSERT_EQUAL(decodedLegacy.size(), decodedDelta.size());
+        for (std::size_t i = 0; i < decodedDelta.size(); i++) {
+            TEST_ASSERT_EQUAL_UINT32(expectedDelta[i].timestamp_ms, decodedDelta[i].timestamp_ms);
+            TEST_ASSERT_EQUAL_UINT32(decodedLegacy[i].timestamp_ms, decodedDelta[i].timestamp_ms);
+            TEST_ASSERT_EQUAL_UINT8(expectedDelta[i].name, decodedDelta[i].name);
+            TEST_ASSERT_EQUAL_FLOAT(expectedDelta[i].data, decodedDelta[i].data);
+        }
+
+        const double saved = 1.0 - static_cast<double>(delta.getTimestampBytes()) / legacy.getTimestampBytes();
+        std::cout << "timestamp interval " << interval << " ms: timestamp bytes " << legacy.getTimestampBytes()
+                  << " -> " << delta.getTimestampBytes() << " (" << saved * 100.0 << "% less), log "
+                  << legacy.log.size() << " -> " << delta.log.size() << " B\n";
+        TEST_ASSERT_TRUE(saved > 0.75);
+    }
+}
+
+void test_decoder_rejects_truncated_logs(void) {
+    LogWriter writer(0, true);
+    writer.saveDataPoint(DataPoint(1000, 1.0f), 1);
+    writer.saveDataPoint(DataPoint(1300, 2.0f), 1);  // varint delta record
+    std::vector<DecodedRecord> decoded;
+    TEST_ASSERT_TRUE(decodeDeltaTimestampLog(writer.log.data(), writer.log.size(), decoded));
+    TEST_ASSERT_EQUAL(2, decoded.size());
+    TEST_ASSERT_EQUAL_UINT32(1300, decoded[1].timestamp_ms);
+
+    for (std::size_t cut = 1; cut < writer.log.size(); cut++) {
+        std::vector<DecodedRecord> partial;
+        const bool complete = decodeDeltaTimestampLog(writer.log.data(), cut, partial);
+        // Only cuts on a record boundary decode cleanly
+        TEST_ASSERT_EQUAL(cut == 5 || cut == 10 || cut == 13, complete);
+    }
+
+    // Data before any timestamp
+    const uint8_t orphan[5] = {1, 0, 0, 0, 0};
+    TEST_ASSERT_FALSE(decodeDeltaTimestampLog(orphan, 5, decoded));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_varint_round_trip);
+    RUN_TEST(test_encoder_picks_smallest_record);
+    RUN_TEST(test_delta_of_127_is_not_mistaken_for_erased_flash);
+    RUN_TEST(test_decoder_rebuilds_timeline_and_overhead_drops);
+    RUN_TEST(test_decoder_rejects_truncated_logs);
+    return UNITY_END();
+}
@@ -0,0 +1,369 @@
+#include "unity.h"
+#include "DoubleBufferedFlashWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+// ---------------------------------------------------------------------
+// Mock flash with a virtual clock
+// ---------------------------------------------------------------------
+
+// Each writeBuffer() costs a fixed command overhead, the SPI transfer, and a
+// page-program time for every 256-byte page it touches. A sector erase costs
+// 45 ms (W25Q128-style numbers). Programming an unerased byte is recorded.
+class TimedMockFlash {
+public:
+    static const uint32_t PAGE_SIZE = 256;
+    static const uint32_t COMMAND_US = 5;
+    static const uint32_t PAGE_PROGRAM_US = 700;
+    static const uint32_t SECTOR_ERASE_US = 45000;
+    static const uint32_t SIZE = 1 << 20;
+
+    uint64_t clock_us = 0;
+    std::vector<uint8_t> memory;
+    std::vector<bool> erased;
+    uint32_t failNextWrites = 0;
+    uint32_t failNextErases = 0;
+    uint32_t programs = 0;
+    uint32_t pagesProgrammed = 0;
+    uint32_t unerasedWrites = 0;
+
+    TimedMockFlash() : memory(SIZE, 0xFF), erased(SIZE, true) {}
+
+    uint16_t pageSize() { return PAGE_SIZE; }
+
+    bool eraseSector(uint32_t sectorNumber) {
+        clock_us += SECTOR_ERASE_US;
+        if (failNextErases > 0) {
+            failNextErases--;
+            return false;
+        }
+        for (uint32_t i = 0; i < 4096; i++) {
+            memory[sectorNumber * 4096 + i] = 0xFF;
+            erased[sectorNumber * 4096 + i] = true;
+        }
+        return true;
+    }
+
+    // Pretends the whole chip holds an old flight
+    void dirty() {
+        std::fill(memory.begin(), memory.end(), 0x00);
+        std::fill(erased.begin(), erased.end(), false);
+    }
+
+    uint32_t writeBuffer(uint32_t address, const uint8_t* data, uint32_t length) {
+        const uint32_t firstPage = address / PAGE_SIZE;
+        const uint32_t lastPage = (address + length - 1) / PAGE_SIZE;
+        clock_us += COMMAND_US + length / 2 + (lastPage - firstPage + 1) * PAGE_PROGRAM_US;
+        programs++;
+        pagesProgrammed += lastPage - firstPage + 1;
+        if (failNextWrites > 0) {
+            failNextWrites--;
+            return 0;
+        }
+        for (uint32_t i = 0; i < length; i++) {
+            if (!erased[address + i]) {
+                unerasedWrites++;
+            }
+            memory[address + i] &= data[i];  // NOR flash can only clear bits
+            erased[address + i] = false;
+        }
+        return length;
+    }
+};
+
+// Worst-case and bucketed per-call latency, in virtual microseconds
+struct LatencyHistogram {
+    static const int BUCKETS = 8;  // <100, <200, <400, <800, <1600, <3200, <6400, >=6400
+    uint32_t counts[BUCKETS] = {0};
+    uint64_t worst_us = 0;
+
+    void add(uint64_t us) {
+        int bucket = 0;
+        uint64_t limit = 100;
+        while (bucket < BUCKETS - 1 && us >= limit) {
+            bucket++;
+            limit *= 2;
+        }
+        counts[bucket]++;
+        if (us > worst_us) {
+            worst_us = us;
+        }
+    }
+
+    void print(const char* label) const {
+        std::cout << label << " worst " << worst_us << " us |";
+        const char* names[BUCKETS] = {"<100", "<200", "<400", "<800", "<1600", "<3200", "<6400", ">=6400"};
+        for (int i = 0; i < BUCKETS; i++) {
+            std::cout << " " << names[i] << ":" << counts[i];
+        }
+        std::cout << "\n";
+    }
+};
+
+static const uint32_t LOG_START = 4096;
+typedef DoubleBufferedFlashWriter<TimedMockFlash, 2048> Writer;
+
+// 5-byte records like Record_t: name + float
+static void makeRecord(uint32_t i, uint8_t* record) {
+    record[0] = static_cast<uint8_t>(1 + i % 7);
+    const float value = static_cast<float>(i);
+    std::memcpy(record + 1, &value, 4);
+}
+
+static void assertLogMatches(const TimedMockFlash& flash, uint32_t records) {
+    uint8_t expected[5];
+    for (uint32_t i = 0; i < records; i++) {
+        makeRecord(i, expected);
+        TEST_ASSERT_EQUAL_MEMORY(expected, &flash.memory[LOG_START + i * 5], 5);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Test Cases
+// ---------------------------------------------------------------------
+
+void test_chunked_drain_writes_the_same_bytes(void) {
+    const std::size_t chunkSizes[] = {2048, 256, 64, 8};
+    for (std::size_t chunk : chunkSizes) {
+        TimedMockFlash flash;
+        Writer writer(flash, LOG_START, TimedMockFlash::SIZE);
+        writer.setChunkSize(chunk);
+        const uint32_t records = 3000;
+        uint8_t record[5];
+        for (uint32_t i = 0; i < records; i++) {
+            makeRecord(i, record);
+            TEST_ASSERT_TRUE(writer.write(record, 5));
+        }
+        TEST_ASSERT_TRUE(writer.getPendingBytes() > 0);
+        writer.flush();
+        TEST_ASSERT_EQUAL(0, writer.getPendingBytes());
+        TEST_ASSERT_EQUAL(0, writer.getDroppedBytes());
+        TEST_ASSERT_EQUAL_UINT32(LOG_START + records * 5, writer.getNextWriteAddress());
+        assertLogMatches(flash, records);
+    }
+}
+
+void test_background_service_and_overrun(void) {
+    TimedMockFlash flash;
+    Writer writer(flash, LOG_START, TimedMockFlash::SIZE);
+    writer.setBackgroundService(true);
+    writer.setChunkSize(256);
+
+    uint8_t record[5];
+    // Nothing is serviced, so after two buffers' worth the writer has to drop
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        makeRecord(accepted, record);
+        if (writer.write(record, 5)) {
+            accepted++;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, flash.clock_us);  // write() never touched flash
+    TEST_ASSERT_TRUE(writer.isDraining());
+    TEST_ASSERT_EQUAL(2 * (2048 / 5), accepted);
+    TEST_ASSERT_EQUAL((1000 - accepted) * 5, writer.getDroppedBytes());
+
+    // The background task drains one chunk per call
+    TEST_ASSERT_EQUAL(256, writer.service());
+    while (writer.service() > 0) {
+    }
+    TEST_ASSERT_FALSE(writer.isDraining());
+    writer.flush();
+    assertLogMatches(flash, accepted);
+    TEST_ASSERT_EQUAL(2, writer.getBufferFlushes());
+}
+
+void test_log_region_full_and_write_errors(void) {
+    TimedMockFlash flash;
+    DoubleBufferedFlashWriter<TimedMockFlash, 16> writer(flash, 0, 32);
+    const uint8_t record[5] = {1, 2, 3, 4, 5};
+    flash.failNextWrites = 1;
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_TRUE(writer.write(record, 5));
+    }
+    // 30 of 32 bytes used
+    TEST_ASSERT_FALSE(writer.write(record, 5));
+    TEST_ASSERT_EQUAL(5, writer.getDroppedBytes());
+    uint8_t tooLong[17] = {0};
+    TEST_ASSERT_FALSE(writer.write(tooLong, 17));
+
+    writer.flush();
+    // The first buffer failed to write, but the writer moved on
+    TEST_ASSERT_EQUAL(1, writer.getWriteErrors());
+    TEST_ASSERT_EQUAL(2, writer.getBufferFlushes());
+    TEST_ASSERT_EQUAL(0, writer.getPendingBytes());
+
+    writer.reset();
+    TEST_ASSERT_EQUAL(0, writer.getNextWriteAddress());
+    TEST_ASSERT_EQUAL(0, writer.getDroppedBytes());
+    TEST_ASSERT_TRUE(writer.write(record, 5));
+}
+
+void test_latency_histogram_before_and_after(void) {
+    // 1 kHz logging loop writing two records per tick for 20 s
+    const std::size_t chunkSizes[] = {2048, 256};
+    uint64_t worst[2] = {0, 0};
+    for (int mode = 0; mode < 2; mode++) {
+        TimedMockFlash flash;
+        Writer writer(flash, LOG_START, TimedMockFlash::SIZE);
+        writer.setChunkSize(chunkSizes[mode]);
+        LatencyHistogram histogram;
+        uint8_t record[5];
+        uint32_t written = 0;
+        for (int tick = 0; tick < 20000; tick++) {
+            for (int r = 0; r < 2; r++) {
+                makeRecord(written++, record);
+                const uint64_t before = flash.clock_us;
+                TEST_ASSERT_TRUE(writer.write(record, 5));
+                histogram.add(flash.clock_us - before);
+            }
+        }
+        writer.flush();
+        assertLogMatches(flash, written);
+        TEST_ASSERT_EQUAL(0, writer.getDroppedBytes());
+        histogram.print(mode == 0 ? "blocking flush (one 2 KB burst):" : "double buffered, 256 B chunks: ");
+        worst[mode] = histogram.worst_us;
+    }
+    // A whole buffer is eight page programs; an aligned 256 B chunk is one
+    TEST_ASSERT_TRUE(worst[0] > 5000);
+    TEST_ASSERT_TRUE(worst[1] < 900);
+}
+
+void test_programs_never_straddle_a_page(void) {
+    const std::size_t chunkSizes[] = {2048, 256, 100};
+    for (std::size_t chunk : chunkSizes) {
+        TimedMockFlash flash;
+        Writer writer(flash, LOG_START + 10, TimedMockFlash::SIZE);  // unaligned start
+        writer.setChunkSize(chunk);
+        uint8_t record[5];
+        for (uint32_t i = 0; i < 5000; i++) {
+            makeRecord(i, record);
+            TEST_ASSERT_TRUE(writer.write(record, 5));
+        }
+        writer.flush();
+        // One page per program, so page programs == programs
+        TEST_ASSERT_EQUAL(flash.programs, flash.pagesProgrammed);
+        for (uint32_t i = 0; i < 5000; i++) {
+            makeRecord(i, record);
+            TEST_ASSERT_EQUAL_MEMORY(record, &flash.memory[LOG_START + 10 + i * 5], 5);
+        }
+    }
+}
+
+void test_erase_ahead_keeps_erases_out_of_writes(void) {
+    // A chip with an old flight on it, 25 KB/s of records, one idle() per tick
+    for (int withIdle = 0; withIdle < 2; withIdle++) {
+        TimedMockFlash flash;
+        flash.dirty();
+        Writer writer(flash, LOG_START, TimedMockFlash::SIZE);
+        writer.setChunkSize(256);
+        writer.setEraseAhead(2);
+        LatencyHistogram writeLatency;
+        uint8_t record[5];
+        uint32_t written = 0;
+        for (int tick = 0; tick < 10000; tick++) {
+            for (int r = 0; r < 5; r++) {
+                makeRecord(written++, record);
+                const uint64_t before = flash.clock_us;
+                TEST_ASSERT_TRUE(writer.write(record, 5));
+                writeLatency.add(flash.clock_us - before);
+            }
+            if (withIdle) {
+                writer.idle();
+            }
+        }
+        writer.flush();
+        assertLogMatches(flash, written);
+        TEST_ASSERT_EQUAL(0, flash.unerasedWrites);
+
+        std::cout << (withIdle ? "erase-ahead with idle():" : "erase-ahead, no idle():  ")
+                  << " background " << writer.getBackgroundErases() << ", inline "
+                  << writer.getInlineErases() << ", worst write " << writeLatency.worst_us << " us\n";
+        if (withIdle) {
+            TEST_ASSERT_EQUAL(0, writer.getInlineErases());
+            TEST_ASSERT_TRUE(writer.getBackgroundErases() >= written * 5 / 4096);
+            TEST_ASSERT_TRUE(writeLatency.worst_us < 900);
+            // Never more than two sectors ahead
+            TEST_ASSERT_TRUE(writer.getErasedUntil() <= writer.getNextWriteAddress() + 2 * 4096 + 4096);
+        } else {
+            TEST_ASSERT_EQUAL(0, writer.getBackgroundErases());
+            TEST_ASSERT_TRUE(writer.getInlineErases() > 0);
+            TEST_ASSERT_TRUE(writeLatency.worst_us > 45000);
+        }
+    }
+}
+
+void test_idle_stops_at_the_end_of_the_region(void) {
+    TimedMockFlash flash;
+    DoubleBufferedFlashWriter<TimedMockFlash, 256> writer(flash, 4096, 3 * 4096);
+    TEST_ASSERT_FALSE(writer.idle());  // erase-ahead off
+    writer.setEraseAhead(8);
+    TEST_ASSERT_TRUE(writer.idle());
+    TEST_ASSERT_TRUE(writer.idle());
+    TEST_ASSERT_FALSE(writer.idle());
+    TEST_ASSERT_EQUAL(2, writer.getBackgroundErases());
+    TEST_ASSERT_EQUAL_UINT32(3 * 4096, writer.getErasedUntil());
+}
+
+void test_failed_erase_is_not_programmed_over(void) {
+    TimedMockFlash flash;
+    flash.dirty();
+    DoubleBufferedFlashWriter<TimedMockFlash, 16> writer(flash, 0, 3 * 4096);
+    writer.setEraseAhead(1);
+    const uint8_t record[4] = {1, 2, 3, 4};
+
+    // The inline erase for the first chunk fails: the chunk is skipped, not ANDed into old data
+    flash.failNextErases = 1;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(writer.write(record, 4));
+    }
+    writer.flush();
+    TEST_ASSERT_EQUAL(1, writer.getEraseErrors());
+    TEST_ASSERT_EQUAL(1, writer.getWriteErrors());
+    TEST_ASSERT_EQUAL(0, writer.getInlineErases());
+    TEST_ASSERT_EQUAL_UINT32(0, writer.getErasedUntil());
+    TEST_ASSERT_EQUAL(0, flash.programs);
+
+    // The next chunk retries the erase
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(writer.write(record, 4));
+    }
+    writer.flush();
+    TEST_ASSERT_EQUAL(1, writer.getInlineErases());
+    TEST_ASSERT_EQUAL_UINT32(4096, writer.getErasedUntil());
+    TEST_ASSERT_EQUAL(0, flash.unerasedWrites);
+    TEST_ASSERT_EQUAL_UINT8(1, flash.memory[16]);
+
+    // A failed background erase leaves the window where it was
+    flash.failNextErases = 1;
+    TEST_ASSERT_FALSE(writer.idle());
+    TEST_ASSERT_EQUAL(0, writer.getBackgroundErases());
+    TEST_ASSERT_EQUAL(2, writer.getEraseErrors());
+    TEST_ASSERT_EQUAL_UINT32(4096, writer.getErasedUntil());
+    TEST_ASSERT_TRUE(writer.idle());
+    TEST_ASSERT_EQUAL_UINT32(2 * 4096, writer.getErasedUntil());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_chunked_drain_writes_the_same_bytes);
+    RUN_TEST(test_background_service_and_overrun);
+    RUN_TEST(test_log_region_full_and_write_errors);
+    RUN_TEST(test_latency_histogram_before_and_after);
+    RUN_TEST(test_programs_never_straddle_a_page);
+    RUN_TEST(test_erase_ahead_keeps_erases_out_of_writes);
+    RUN_TEST(test_idle_stops_at_the_end_of_the_region);
+    RUN_TEST(test_failed_erase_is_not_programmed_over);
+    return UNITY_END();
+}
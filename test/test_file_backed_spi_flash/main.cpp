@@ -0,0 +1,257 @@
+#include "unity.h"
+#include "../FileBackedSPIFlash.h"
+#include "DoubleBufferedFlashWriter.h"
+#include "FlightLogDecoder.h"
+#include "SimpleSimulation.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+static const char* const PATH = "test_file_backed_spi_flash.bin";
+static const uint32_t CHIP_SIZE = 1UL << 20;
+static const uint32_t LOG_START = 4096;
+
+void test_contents_outlive_the_mock(void) {
+    std::remove(PATH);
+    const uint8_t record[5] = {3, 0x00, 0x00, 0x80, 0x3F};
+    {
+        FileBackedSPIFlash flash(PATH, CHIP_SIZE);
+        TEST_ASSERT_TRUE(flash.begin());
+        TEST_ASSERT_EQUAL_UINT32(CHIP_SIZE, flash.size());
+        TEST_ASSERT_EQUAL_UINT8(0xFF, flash.data()[0]);
+        TEST_ASSERT_EQUAL_UINT8(0xFF, flash.data()[CHIP_SIZE - 1]);
+        TEST_ASSERT_EQUAL_UINT32(5, flash.writeBuffer(LOG_START, record, sizeof(record)));
+    }
+    {
+        FileBackedSPIFlash flash(PATH, CHIP_SIZE);
+        uint8_t read[5];
+        TEST_ASSERT_EQUAL_UINT32(5, flash.readBuffer(LOG_START, read, sizeof(read)));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(record, read, 5);
+        TEST_ASSERT_EQUAL_UINT8(0xFF, flash.data()[LOG_START + 5]);
+    }
+    {
+        // A bigger chip keeps the old contents and adds erased space
+        FileBackedSPIFlash flash(PATH, 2 * CHIP_SIZE);
+        TEST_ASSERT_EQUAL_UINT8(3, flash.data()[LOG_START]);
+        TEST_ASSERT_EQUAL_UINT8(0xFF, flash.data()[CHIP_SIZE]);
+        TEST_ASSERT_EQUAL_UINT8(0xFF, flash.data()[2 * CHIP_SIZE - 1]);
+    }
+    std::remove(PATH);
+}
+
+void test_writes_only_clear_bits(void) {
+    std::remove(PATH);
+    FileBackedSPIFlash flash(PATH, CHIP_SIZE, FlashTiming::instant());
+    const uint8_t first[2] = {0xF0, 0xFF};
+    const uint8_t second[2] = {0x0F, 0x3C};
+    flash.writeBuffer(100, first, 2);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.getUnerasedWrites());
+    // 0xFF over 0xF0 and 0x3C over 0xFF: only the first byte comes out wrong
+    const uint8_t third[2] = {0xFF, 0x3C};
+    flash.writeBuffer(100, third, 2);
+    TEST_ASSERT_EQUAL_UINT32(1, flash.getUnerasedWrites());
+    flash.writeBuffer(100, second, 2);
+    TEST_ASSERT_EQUAL_UINT8(0x00, flash.data()[100]);
+    TEST_ASSERT_EQUAL_UINT8(0x3C, flash.data()[101]);
+
+    TEST_ASSERT_TRUE(flash.eraseSector(0));
+    TEST_ASSERT_EQUAL_UINT8(0xFF, flash.data()[100]);
+    TEST_ASSERT_FALSE(flash.eraseSector(CHIP_SIZE / FileBackedSPIFlash::SECTOR_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(0, flash.writeBuffer(CHIP_SIZE - 1, first, 2));
+    TEST_ASSERT_EQUAL_UINT64(0, flash.now_us());
+    std::remove(PATH);
+}
+
+void test_latency_model(void) {
+    std::remove(PATH);
+    FileBackedSPIFlash flash(PATH, CHIP_SIZE);
+    const FlashTiming& timing = flash.getTiming();
+    uint8_t buffer[300];
+    std::memset(buffer, 0x55, sizeof(buffer));
+
+    flash.readBuffer(0, buffer, 100);
+    uint64_t expected_ns = timing.command_ns + 100 * timing.readByte_ns;
+    TEST_ASSERT_EQUAL_UINT64(expected_ns / 1000, flash.now_us());
+
+    // Ten bytes across a page boundary are two page programs
+    flash.writeBuffer(250, buffer, 10);
+    expected_ns += 2 * (timing.command_ns + timing.pageProgram_ns) + 10 * timing.writeByte_ns;
+    TEST_ASSERT_EQUAL_UINT64(expected_ns / 1000, flash.now_us());
+    TEST_ASSERT_EQUAL_UINT32(2, flash.getPagePrograms());
+
+    flash.eraseSector(1);
+    expected_ns += timing.command_ns + timing.sectorErase_ns;
+    TEST_ASSERT_EQUAL_UINT64(expected_ns / 1000, flash.now_us());
+
+    // Time outside flash calls moves the clock but isn't busy time
+    flash.advance_us(10000);
+    TEST_ASSERT_EQUAL_UINT64(expected_ns / 1000 + 10000, flash.now_us());
+    TEST_ASSERT_EQUAL_UINT64(expected_ns / 1000, flash.getBusy_us());
+
+    flash.resetStats();
+    FileBackedSPIFlash slow(PATH, CHIP_SIZE, FlashTiming::worstCase());
+    slow.writeBuffer(0, buffer, 256);
+    flash.writeBuffer(512, buffer, 256);
+    TEST_ASSERT_TRUE(slow.getBusy_us() > 3 * flash.getBusy_us());
+    std::remove(PATH);
+}
+
+// How a logging strategy did over one flight, on the virtual clock
+struct StrategyResult {
+    uint64_t busy_us;
+    uint64_t worstTick_us;
+    uint32_t pagePrograms;
+};
+
+// 100 Hz for a minute: a TimestampRecord_t and nine Record_t per tick, handed
+// to log() one record at a time, then log.endTick() for the rest of the loop.
+template <typename Log>
+static void logFlight(FileBackedSPIFlash& flash, Log& log, StrategyResult& result) {
+    SimpleSimulator sim(5000, 50.0f, 2500, 10);
+    result.worstTick_us = 0;
+    for (int tick = 0; tick < 6000; tick++) {
+        sim.tick();
+        const uint64_t before = flash.getBusy_us();
+        uint8_t record[5];
+        const uint32_t t = sim.getCurrentTime();
+        record[0] = 0x7F;
+        std::memcpy(record + 1, &t, 4);
+        log(record);
+        for (uint8_t name = 0; name < 9; name++) {
+            const float value = name == 2 ? sim.getIntertialVerticalAcl() : sim.getAltitude() + name;
+            record[0] = name;
+            std::memcpy(record + 1, &value, 4);
+            log(record);
+        }
+        log.endTick();
+        const uint64_t spent = flash.getBusy_us() - before;
+        if (spent > result.worstTick_us) {
+            result.worstTick_us = spent;
+        }
+        flash.advance_us(10000 - (spent < 10000 ? spent : 10000));
+    }
+    result.busy_us = flash.getBusy_us();
+    result.pagePrograms = flash.getPagePrograms();
+}
+
+// Every record straight to flash
+struct UnbufferedLog {
+    FileBackedSPIFlash& flash;
+    uint32_t address;
+
+    void operator()(const uint8_t* record) {
+        flash.writeBuffer(address, record, 5);
+        address += 5;
+    }
+
+    void endTick() {}
+};
+
+// DataSaverSPI's scheme: one buffer, written out in a single call when full
+struct SingleBufferLog {
+    FileBackedSPIFlash& flash;
+    uint32_t address;
+    uint8_t buffer[256];
+    std::size_t fill;
+
+    void operator()(const uint8_t* record) {
+        if (fill + 5 > sizeof(buffer)) {
+            flush();
+        }
+        std::memcpy(buffer + fill, record, 5);
+        fill += 5;
+    }
+
+    void endTick() {}
+
+    void flush() {
+        flash.writeBuffer(address, buffer, static_cast<uint32_t>(fill));
+        address += static_cast<uint32_t>(fill);
+        fill = 0;
+    }
+};
+
+// DoubleBufferedFlashWriter serviced once per loop, one chunk at a time
+struct DoubleBufferedLog {
+    DoubleBufferedFlashWriter<FileBackedSPIFlash, 256>& writer;
+
+    void operator()(const uint8_t* record) { writer.write(record, 5); }
+
+    void endTick() { writer.service(); }
+};
+
+void test_compares_buffering_strategies(void) {
+    const char* paths[3] = {"test_file_backed_spi_flash_unbuffered.bin", "test_file_backed_spi_flash_single.bin",
+                            "test_file_backed_spi_flash_double.bin"};
+    StrategyResult results[3];
+    uint32_t logEnd = 0;
+    // Start from erased chips, not whatever the last run left
+    for (int i = 0; i < 3; i++) {
+        std::remove(paths[i]);
+    }
+    {
+        FileBackedSPIFlash flash(paths[0], 4 * CHIP_SIZE);
+        UnbufferedLog log = {flash, LOG_START};
+        logFlight(flash, log, results[0]);
+        logEnd = log.address;
+    }
+    {
+        FileBackedSPIFlash flash(paths[1], 4 * CHIP_SIZE);
+        SingleBufferLog log = {flash, LOG_START, {0}, 0};
+        logFlight(flash, log, results[1]);
+        log.flush();
+    }
+    {
+        FileBackedSPIFlash flash(paths[2], 4 * CHIP_SIZE);
+        DoubleBufferedFlashWriter<FileBackedSPIFlash, 256> writer(flash, LOG_START, flash.size());
+        writer.setChunkSize(64);
+        writer.setBackgroundService(true);
+        DoubleBufferedLog log = {writer};
+        logFlight(flash, log, results[2]);
+        writer.flush();
+    }
+
+    const char* names[3] = {"unbuffered", "single 256 B buffer", "double buffer, 64 B chunks"};
+    for (int i = 0; i < 3; i++) {
+        std::cout << names[i] << ": " << results[i].busy_us / 1000 << " ms in flash calls, worst tick "
+                  << results[i].worstTick_us << " us, " << results[i].pagePrograms << " page programs\n";
+    }
+    // Batching cuts total flash time by an order of magnitude...
+    TEST_ASSERT_TRUE(results[1].busy_us * 10 < results[0].busy_us);
+    // ...and spreading each buffer over several ticks keeps any one tick short
+    TEST_ASSERT_TRUE(results[2].worstTick_us < results[1].worstTick_us);
+
+    // The dumps stay on disk and decode to the same flight
+    FileBackedSPIFlash reference(paths[0], 4 * CHIP_SIZE, FlashTiming::instant());
+    FlightLogDecoder decoded[3];
+    for (int i = 0; i < 3; i++) {
+        FileBackedSPIFlash dump(paths[i], 4 * CHIP_SIZE, FlashTiming::instant());
+        TEST_ASSERT_EQUAL(logEnd - LOG_START,
+                          decoded[i].decode(dump.data() + LOG_START, dump.size() - LOG_START));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(reference.data() + LOG_START, dump.data() + LOG_START, logEnd - LOG_START);
+    }
+    TEST_ASSERT_EQUAL_UINT32(6000, decoded[2].getTimestampRecordCount());
+    TEST_ASSERT_EQUAL_UINT32(6000 * 9, decoded[2].getDataRecordCount());
+    for (int i = 0; i < 3; i++) {
+        std::remove(paths[i]);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_contents_outlive_the_mock);
+    RUN_TEST(test_writes_only_clear_bits);
+    RUN_TEST(test_latency_model);
+    RUN_TEST(test_compares_buffering_strategies);
+    return UNITY_END();
+}
@@ -0,0 +1,269 @@
+#include "unity.h"
+#include "FlightLogDecoder.h"
+#include "SimpleSimulation.h"
+#include "../CSVMockData.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+static const uint8_t TIMESTAMP = 0x7F;
+
+// Writes data the way DataSaverSPI does: a TimestampRecord_t whenever more
+// than timestampInterval_ms passed since the last one, then a 5-byte Record_t.
+class LogWriter {
+public:
+    explicit LogWriter(uint32_t timestampInterval_ms)
+        : interval_ms_(timestampInterval_ms), lastTimestamp_ms_(0), haveTimestamp_(false) {}
+
+    // Returns the timestamp a decoder should give this point
+    uint32_t saveDataPoint(uint32_t timestamp_ms, float data, uint8_t name) {
+        if (!haveTimestamp_ || timestamp_ms - lastTimestamp_ms_ > interval_ms_) {
+            put(TIMESTAMP, &timestamp_ms);
+            lastTimestamp_ms_ = timestamp_ms;
+            haveTimestamp_ = true;
+        }
+        put(name, &data);
+        return lastTimestamp_ms_;
+    }
+
+    std::vector<uint8_t> log;
+
+private:
+    uint32_t interval_ms_;
+    uint32_t lastTimestamp_ms_;
+    bool haveTimestamp_;
+
+    void put(uint8_t name, const void* value) {
+        uint8_t record[5];
+        record[0] = name;
+        std::memcpy(record + 1, value, 4);
+        log.insert(log.end(), record, record + 5);
+    }
+};
+
+static uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+struct ExpectedPoint {
+    uint32_t timestamp_ms;
+    float value;
+};
+
+// A simulated flight at 100 Hz logging the twelve CSV columns as sensor names
+// 0..11: IMU every tick, magnetometer at 50 Hz, barometer at 20 Hz.
+static void logFlight(LogWriter& writer, std::vector<ExpectedPoint> expected[COLUMN_COUNT]) {
+    SimpleSimulator sim(1000, 50.0f, 2500, 10);
+    while (!sim.getHasLanded() && sim.getCurrentTime() < 120000) {
+        sim.tick();
+        const uint32_t t = sim.getCurrentTime();
+        const uint32_t tick = t / 10;
+        const float alt = sim.getAltitude();
+        float values[COLUMN_COUNT];
+        bool logged[COLUMN_COUNT];
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            logged[c] = c < COLUMN_MAG_X || (c < COLUMN_ALTITUDE ? tick % 2 == 0 : tick % 5 == 0);
+            values[c] = 0.01f * static_cast<float>(c) * static_cast<float>(tick % 97);
+        }
+        values[COLUMN_ACCEL_Z] = sim.getIntertialVerticalAcl();
+        values[COLUMN_ALTITUDE] = alt;
+        values[COLUMN_PRESSURE] = 1013.25f * std::pow(1.0f - alt / 44330.0f, 5.255f);
+        values[COLUMN_TEMP] = 20.0f - 0.0065f * alt;
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            if (logged[c]) {
+                ExpectedPoint point;
+                point.value = values[c];
+                point.timestamp_ms = writer.saveDataPoint(t, values[c], static_cast<uint8_t>(c));
+                expected[c].push_back(point);
+            }
+        }
+    }
+}
+
+void test_decodes_a_simulated_flight(void) {
+    // With a 25 ms interval most points carry an earlier timestamp record
+    LogWriter writer(25);
+    std::vector<ExpectedPoint> expected[COLUMN_COUNT];
+    logFlight(writer, expected);
+
+    FlightLogDecoder decoder;
+    TEST_ASSERT_EQUAL(writer.log.size(), decoder.decode(writer.log.data(), writer.log.size()));
+    TEST_ASSERT_FALSE(decoder.isTruncated());
+    uint32_t points = 0;
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        const SensorSeries& series = decoder.getSeries(static_cast<uint8_t>(c));
+        TEST_ASSERT_GREATER_THAN(100, series.size());
+        TEST_ASSERT_EQUAL(expected[c].size(), series.size());
+        TEST_ASSERT_EQUAL(series.value.size(), series.timestamp_ms.size());
+        for (std::size_t i = 0; i < series.size(); i++) {
+            TEST_ASSERT_EQUAL_UINT32(expected[c][i].timestamp_ms, series.timestamp_ms[i]);
+            TEST_ASSERT_EQUAL_HEX32(floatBits(expected[c][i].value),
+                                    floatBits(series.value[i]));
+        }
+        points += static_cast<uint32_t>(series.size());
+    }
+    TEST_ASSERT_EQUAL_UINT32(points, decoder.getDataRecordCount());
+    TEST_ASSERT_EQUAL_UINT32(writer.log.size() / 5 - points, decoder.getTimestampRecordCount());
+    TEST_ASSERT_EQUAL(0, decoder.getSeries(TIMESTAMP).size());
+}
+
+void test_stops_at_erased_flash_and_partial_records(void) {
+    LogWriter writer(0);
+    for (uint32_t t = 10; t <= 100; t += 10) {
+        writer.saveDataPoint(t, static_cast<float>(t) * 0.5f, 3);
+    }
+    const std::size_t logged = writer.log.size();
+
+    // A dump reads the whole chip: the log, then erased flash
+    std::vector<uint8_t> dump(writer.log);
+    dump.resize(logged + 4096, 0xFF);
+    FlightLogDecoder decoder;
+    TEST_ASSERT_EQUAL(logged, decoder.decode(dump.data(), dump.size()));
+    TEST_ASSERT_FALSE(decoder.isTruncated());
+    TEST_ASSERT_EQUAL(10, decoder.getSeries(3).size());
+    TEST_ASSERT_EQUAL_UINT32(100, decoder.getSeries(3).timestamp_ms[9]);
+
+    // Power lost two bytes into the last Record_t
+    decoder.clear();
+    TEST_ASSERT_EQUAL(logged - 5, decoder.decode(writer.log.data(), logged - 3));
+    TEST_ASSERT_TRUE(decoder.isTruncated());
+    TEST_ASSERT_EQUAL(9, decoder.getSeries(3).size());
+    TEST_ASSERT_EQUAL_UINT32(10, decoder.getTimestampRecordCount());
+
+    // A dump read in two pieces decodes like one
+    decoder.clear();
+    const std::size_t split = 7 * 5;
+    decoder.decode(writer.log.data(), split);
+    decoder.decode(writer.log.data() + split, logged - split);
+    TEST_ASSERT_EQUAL(10, decoder.getSeries(3).size());
+    TEST_ASSERT_EQUAL_UINT32(40, decoder.getSeries(3).timestamp_ms[3]);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, decoder.getSeries(3).value[3]);
+}
+
+void test_csv_reads_back_with_csv_data_provider(void) {
+    LogWriter writer(0);
+    std::vector<ExpectedPoint> expected[COLUMN_COUNT];
+    logFlight(writer, expected);
+    FlightLogDecoder decoder;
+    decoder.decode(writer.log.data(), writer.log.size());
+
+    const char* path = "test_flight_log_decoder.csv";
+    std::FILE* out = std::fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(out);
+    const std::size_t rows = writeFlightLogCsv(decoder, FlightLogCsvMap(), out);
+    std::fclose(out);
+
+    // One row per tick, from the first one at which every sensor has logged
+    const std::vector<ExpectedPoint>& ticks = expected[COLUMN_ACCEL_X];
+    uint32_t firstRow_ms = 0;
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        firstRow_ms = std::max(firstRow_ms, expected[c].front().timestamp_ms);
+    }
+    std::size_t first = 0;
+    while (ticks[first].timestamp_ms < firstRow_ms) {
+        first++;
+    }
+    TEST_ASSERT_EQUAL(ticks.size() - first, rows);
+
+    CSVDataProvider provider(path);
+    const std::pair<long, long> range = provider.getTimeRange();
+    TEST_ASSERT_EQUAL(static_cast<long>(firstRow_ms), range.first);
+    TEST_ASSERT_EQUAL(static_cast<long>(ticks.back().timestamp_ms), range.second);
+
+    // Every row holds each column's latest value at its time
+    std::size_t next[COLUMN_COUNT] = {0};
+    for (std::size_t row = first; row < ticks.size(); row++) {
+        const uint32_t t = ticks[row].timestamp_ms;
+        const SensorData data = provider.getInterpolatedData(t);
+        const float columns[COLUMN_COUNT] = {data.accelx, data.accely, data.accelz, data.gyrox,
+                                             data.gyroy,  data.gyroz,  data.magx,   data.magy,
+                                             data.magz,   data.altitude, data.pressure, data.temp};
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            while (next[c] < expected[c].size() && expected[c][next[c]].timestamp_ms <= t) {
+                next[c]++;
+            }
+            const float want = expected[c][next[c] - 1].value;
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f * (1.0f + std::fabs(want)), want, columns[c]);
+        }
+    }
+    std::remove(path);
+}
+
+void test_unmapped_columns_are_zero(void) {
+    LogWriter writer(0);
+    writer.saveDataPoint(10, 1.5f, 20);
+    writer.saveDataPoint(20, 2.5f, 20);
+    FlightLogDecoder decoder;
+    decoder.decode(writer.log.data(), writer.log.size());
+
+    FlightLogCsvMap map;
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        map.map(static_cast<FlightLogColumn>(c), FlightLogCsvMap::UNMAPPED);
+    }
+    map.map(COLUMN_ALTITUDE, 20);
+    const char* path = "test_flight_log_decoder_map.csv";
+    std::FILE* out = std::fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_EQUAL(2, writeFlightLogCsv(decoder, map, out));
+    std::fclose(out);
+
+    CSVDataProvider provider(path);
+    const SensorData data = provider.getInterpolatedData(20);
+    TEST_ASSERT_EQUAL_FLOAT(2.5f, data.altitude);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, data.accelz);
+    std::remove(path);
+}
+
+void test_full_chip_dump_decodes_in_well_under_a_second(void) {
+    // A 16 MB chip filled the way DataSaverSPI fills it: a timestamp record
+    // per 10 ms tick followed by nine sensors
+    const std::size_t chip = 16UL * 1024 * 1024;
+    LogWriter writer(0);
+    writer.log.reserve(chip);
+    uint32_t t = 0;
+    while (writer.log.size() + 50 <= chip) {
+        t += 10;
+        for (uint8_t name = 0; name < 9; name++) {
+            writer.saveDataPoint(t, static_cast<float>(t) * 0.001f + name, name);
+        }
+    }
+    writer.log.resize(chip, 0xFF);
+
+    FlightLogDecoder decoder;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const std::size_t decoded = decoder.decode(writer.log.data(), writer.log.size());
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_ASSERT_EQUAL_UINT32(t / 10 * 9, decoder.getDataRecordCount());
+    TEST_ASSERT_EQUAL_UINT32(t, decoder.getSeries(8).timestamp_ms.back());
+    std::cout << "Decoded " << decoded << " bytes (" << decoder.getDataRecordCount()
+              << " data records) in " << seconds * 1000.0 << " ms, "
+              << static_cast<double>(decoded) / (1024.0 * 1024.0) / seconds << " MB/s\n";
+    TEST_ASSERT_TRUE(seconds < 1.0);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_decodes_a_simulated_flight);
+    RUN_TEST(test_stops_at_erased_flash_and_partial_records);
+    RUN_TEST(test_csv_reads_back_with_csv_data_provider);
+    RUN_TEST(test_unmapped_columns_are_zero);
+    RUN_TEST(test_full_chip_dump_decodes_in_well_under_a_second);
+    return UNITY_END();
+}
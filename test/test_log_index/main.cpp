@@ -0,0 +1,310 @@
+#include "unity.h"
+#include "LogIndex.h"
+#include "SimpleSimulation.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+// Flash image that counts what a ground tool reads from it
+class ReadCountingMockFlash {
+public:
+    std::vector<uint8_t> memory;
+    uint32_t reads = 0;
+    uint64_t bytesRead = 0;
+
+    explicit ReadCountingMockFlash(uint32_t size) : memory(size, 0xFF) {}
+
+    uint32_t writeBuffer(uint32_t address, const uint8_t* data, uint32_t length) {
+        for (uint32_t i = 0; i < length; i++) {
+            memory[address + i] &= data[i];
+        }
+        return length;
+    }
+
+    uint32_t readBuffer(uint32_t address, uint8_t* data, uint32_t length) {
+        reads++;
+        bytesRead += length;
+        std::memcpy(data, &memory[address], length);
+        return length;
+    }
+};
+
+typedef PageLogWriter<ReadCountingMockFlash, 256> Writer;
+typedef IndexedLogWriter<ReadCountingMockFlash, 256> Indexed;
+typedef LogIndexReader<ReadCountingMockFlash, 256> Reader;
+
+static const uint32_t FLASH_SIZE = 4UL * 1024 * 1024;
+static const uint32_t DATA_START_ADDRESS = 4096;
+static const uint32_t INDEX_EVERY = 4096;
+static const uint8_t TIMESTAMP = 0x7F;
+static const uint8_t ACCELEROMETER_Z = 2;
+static const uint8_t ALTITUDE = 5;
+static const uint8_t GPS_ALTITUDE = 9;
+
+struct LoggedPoint {
+    uint32_t timestamp_ms;
+    uint8_t name;
+    float value;
+};
+
+struct FlightLog {
+    ReadCountingMockFlash flash;
+    std::vector<LoggedPoint> points;
+    uint32_t apogee_ms;
+    uint32_t launch_ms;
+    uint32_t endAddress;
+
+    FlightLog() : flash(FLASH_SIZE), apogee_ms(0), launch_ms(0), endAddress(0) {}
+};
+
+// Ten minutes at 100 Hz: accel every tick, baro at 50 Hz, GPS at 10 Hz once
+// launched, and a TimestampRecord_t before each tick's records.
+static void logFlight(FlightLog& log) {
+    Writer writer(log.flash, DATA_START_ADDRESS, FLASH_SIZE);
+    writer.begin(0);
+    Indexed indexed(writer, DATA_START_ADDRESS, INDEX_EVERY);
+    SimpleSimulator sim(60000, 60.0f, 3000, 10);
+    log.launch_ms = 60000;
+    uint8_t record[5];
+    for (int tick = 0; tick < 60000; tick++) {
+        sim.tick();
+        const uint32_t t = sim.getCurrentTime();
+        record[0] = TIMESTAMP;
+        std::memcpy(record + 1, &t, 4);
+        TEST_ASSERT_TRUE(indexed.write(t, record, 5));
+
+        LoggedPoint sample[3];
+        int n = 0;
+        sample[n].name = ACCELEROMETER_Z;
+        sample[n++].value = sim.getIntertialVerticalAcl();
+        if (tick % 2 == 0) {
+            sample[n].name = ALTITUDE;
+            sample[n++].value = sim.getAltitude();
+        }
+        if (tick % 10 == 0 && t >= log.launch_ms) {
+            sample[n].name = GPS_ALTITUDE;
+            sample[n++].value = sim.getAltitude() + 0.5f;
+        }
+        for (int i = 0; i < n; i++) {
+            sample[i].timestamp_ms = t;
+            record[0] = sample[i].name;
+            std::memcpy(record + 1, &sample[i].value, 4);
+            TEST_ASSERT_TRUE(indexed.write(t, record, 5));
+            log.points.push_back(sample[i]);
+        }
+    }
+    writer.flush();
+    log.apogee_ms = sim.getApogeeTimestamp();
+    TEST_ASSERT_GREATER_THAN(0, indexed.getIndexRecordCount());
+
+    const PageLogRecovery recovery = recoverPageLog<256>(log.flash, DATA_START_ADDRESS, FLASH_SIZE);
+    log.endAddress = recovery.lastPageAddress + 256;
+}
+
+// What a ground tool does after seeking: decode pages from address until
+// past until_ms, keeping the points in [from_ms, until_ms]
+static void decodeWindow(ReadCountingMockFlash& flash, uint32_t address, uint32_t endAddress, uint32_t from_ms,
+                         uint32_t until_ms, std::vector<LoggedPoint>& out) {
+    uint32_t t = 0;
+    uint8_t page[256];
+    for (; address < endAddress; address += 256) {
+        flash.readBuffer(address, page, sizeof(page));
+        uint32_t sequence = 0;
+        if (!page_log::parseHeader(page, sequence)) {
+            continue;
+        }
+        std::size_t offset = page_log::HEADER_SIZE;
+        while (offset < sizeof(page) && page[offset] != 0xFF) {
+            if (page[offset] == log_index::DEFAULT_NAME) {
+                LogIndexEntry entry;
+                if (entry.decode(log_index::DEFAULT_NAME, page + offset)) {
+                    t = entry.timestamp_ms;
+                }
+                offset += log_index::RECORD_SIZE;
+                continue;
+            }
+            if (page[offset] == TIMESTAMP) {
+                t = static_cast<uint32_t>(page[offset + 1]) | (static_cast<uint32_t>(page[offset + 2]) << 8) |
+                    (static_cast<uint32_t>(page[offset + 3]) << 16) | (static_cast<uint32_t>(page[offset + 4]) << 24);
+            } else if (t >= from_ms && t <= until_ms) {
+                LoggedPoint point;
+                point.timestamp_ms = t;
+                point.name = page[offset];
+                std::memcpy(&point.value, page + offset + 1, 4);
+                out.push_back(point);
+            }
+            if (t > until_ms) {
+                return;
+            }
+            offset += 5;
+        }
+    }
+}
+
+static void expectWindow(const FlightLog& log, uint32_t from_ms, uint32_t until_ms,
+                         const std::vector<LoggedPoint>& decoded) {
+    std::vector<LoggedPoint> expected;
+    for (std::size_t i = 0; i < log.points.size(); i++) {
+        if (log.points[i].timestamp_ms >= from_ms && log.points[i].timestamp_ms <= until_ms) {
+            expected.push_back(log.points[i]);
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(0, expected.size());
+    TEST_ASSERT_EQUAL(expected.size(), decoded.size());
+    for (std::size_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(expected[i].timestamp_ms, decoded[i].timestamp_ms);
+        TEST_ASSERT_EQUAL_UINT8(expected[i].name, decoded[i].name);
+        TEST_ASSERT_EQUAL_FLOAT(expected[i].value, decoded[i].value);
+    }
+}
+
+static FlightLog& flight() {
+    static FlightLog log;
+    if (log.points.empty()) {
+        logFlight(log);
+    }
+    return log;
+}
+
+void test_seek_extracts_ten_seconds_around_apogee(void) {
+    FlightLog& log = flight();
+    Reader reader(log.flash, DATA_START_ADDRESS, log.endAddress, INDEX_EVERY);
+    const uint32_t from = log.apogee_ms - 5000;
+    const uint32_t until = log.apogee_ms + 5000;
+
+    log.flash.reads = 0;
+    log.flash.bytesRead = 0;
+    LogIndexEntry entry;
+    TEST_ASSERT_TRUE(reader.seek(from, entry));
+    TEST_ASSERT_TRUE(entry.timestamp_ms <= from);
+    const uint32_t seekReads = reader.getReadCount();
+    const uint32_t slots = reader.getSlotCount();
+    uint32_t log2Slots = 0;
+    while ((1UL << log2Slots) < slots) {
+        log2Slots++;
+    }
+    TEST_ASSERT_TRUE(seekReads <= log2Slots + 1);
+
+    std::vector<LoggedPoint> window;
+    decodeWindow(log.flash, DATA_START_ADDRESS + entry.offset, log.endAddress, from, until, window);
+    expectWindow(log, from, until, window);
+
+    const uint32_t logBytes = log.endAddress - DATA_START_ADDRESS;
+    std::cout << "Apogee window: seek " << seekReads << " reads over " << slots << " index slots, read "
+              << log.flash.bytesRead << " of " << logBytes << " log bytes\n";
+    // The window plus at most one index interval before it
+    TEST_ASSERT_TRUE(log.flash.bytesRead < logBytes / 10);
+}
+
+void test_seek_outside_the_log(void) {
+    FlightLog& log = flight();
+    Reader reader(log.flash, DATA_START_ADDRESS, log.endAddress, INDEX_EVERY);
+    LogIndexEntry entry;
+    TEST_ASSERT_TRUE(reader.seek(0, entry));
+    TEST_ASSERT_EQUAL_UINT32(0, entry.offset);
+
+    TEST_ASSERT_TRUE(reader.seek(0xFFFFFFFFUL, entry));
+    TEST_ASSERT_EQUAL_UINT32((reader.getSlotCount() - 1) * INDEX_EVERY, entry.offset);
+
+    ReadCountingMockFlash blank(64 * 1024);
+    Reader empty(blank, DATA_START_ADDRESS, 64 * 1024, INDEX_EVERY);
+    TEST_ASSERT_FALSE(empty.seek(1000, entry));
+}
+
+void test_sensor_mask_shows_when_gps_starts(void) {
+    FlightLog& log = flight();
+    Reader reader(log.flash, DATA_START_ADDRESS, log.endAddress, INDEX_EVERY);
+    const uint32_t always = (1UL << ACCELEROMETER_Z) | (1UL << ALTITUDE);
+    LogIndexEntry entry;
+    for (uint32_t slot = 1; slot < reader.getSlotCount(); slot++) {
+        TEST_ASSERT_TRUE(reader.readEntry(slot, entry));
+        TEST_ASSERT_EQUAL_HEX32(always, entry.sensorMask & always);
+        // The mask covers the interval before the index record
+        const bool gps = (entry.sensorMask >> GPS_ALTITUDE) & 1U;
+        LogIndexEntry previous;
+        reader.readEntry(slot - 1, previous);
+        if (entry.timestamp_ms < log.launch_ms) {
+            TEST_ASSERT_FALSE(gps);
+        } else if (previous.timestamp_ms > log.launch_ms) {
+            TEST_ASSERT_TRUE(gps);
+        }
+    }
+}
+
+void test_missing_index_slot_is_stepped_over(void) {
+    FlightLog& log = flight();
+    std::vector<uint8_t> saved = log.flash.memory;
+    Reader reader(log.flash, DATA_START_ADDRESS, log.endAddress, INDEX_EVERY);
+
+    // Tear the header of the index page holding apogee
+    LogIndexEntry apogee;
+    TEST_ASSERT_TRUE(reader.seek(log.apogee_ms, apogee));
+    const uint32_t slot = apogee.offset / INDEX_EVERY;
+    log.flash.memory[DATA_START_ADDRESS + apogee.offset + 2] = 0x00;
+
+    LogIndexEntry entry;
+    TEST_ASSERT_FALSE(reader.readEntry(slot, entry));
+    TEST_ASSERT_TRUE(reader.seek(log.apogee_ms, entry));
+    TEST_ASSERT_EQUAL_UINT32((slot - 1) * INDEX_EVERY, entry.offset);
+    // Times after the torn slot still find the next one
+    LogIndexEntry next;
+    TEST_ASSERT_TRUE(reader.readEntry(slot + 1, next));
+    TEST_ASSERT_TRUE(reader.seek(next.timestamp_ms, entry));
+    TEST_ASSERT_EQUAL_UINT32(next.offset, entry.offset);
+
+    log.flash.memory = saved;
+}
+
+void test_index_lands_on_its_page_with_mixed_record_lengths(void) {
+    // 5- and 20-byte records, so a page often has room for an index record but not the next record
+    const uint32_t end = DATA_START_ADDRESS + 64 * 1024;
+    const uint32_t every = 256;
+    ReadCountingMockFlash flash(end);
+    Writer writer(flash, DATA_START_ADDRESS, end);
+    writer.begin(0);
+    Indexed indexed(writer, DATA_START_ADDRESS, every);
+    uint8_t record[20];
+    std::memset(record, 0, sizeof(record));
+    record[0] = ALTITUDE;
+    uint32_t t = 0;
+    while (writer.getPageAddress() + 2 * every < end) {
+        const std::size_t length = t % 3 == 0 ? 20 : 5;
+        TEST_ASSERT_TRUE(indexed.write(t, record, length));
+        t++;
+    }
+    writer.flush();
+
+    Reader reader(flash, DATA_START_ADDRESS, writer.getPageAddress() + 256, every);
+    uint32_t readable = 0;
+    uint32_t previous = 0;
+    LogIndexEntry entry;
+    for (uint32_t slot = 0; slot < reader.getSlotCount(); slot++) {
+        if (reader.readEntry(slot, entry)) {
+            TEST_ASSERT_TRUE(entry.timestamp_ms >= previous);
+            previous = entry.timestamp_ms;
+            readable++;
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(100, indexed.getIndexRecordCount());
+    TEST_ASSERT_EQUAL_UINT32(indexed.getIndexRecordCount(), readable);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_seek_extracts_ten_seconds_around_apogee);
+    RUN_TEST(test_seek_outside_the_log);
+    RUN_TEST(test_sensor_mask_shows_when_gps_starts);
+    RUN_TEST(test_missing_index_slot_is_stepped_over);
+    RUN_TEST(test_index_lands_on_its_page_with_mixed_record_lengths);
+    return UNITY_END();
+}
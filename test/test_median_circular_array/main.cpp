@@ -0,0 +1,179 @@
+#include "unity.h"
+#include "MedianCircularArray.h"
+#include "data_handling/CircularArray.h"
+#include "data_handling/DataPoint.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+void test_push_and_get_from_head(void) {
+    MedianCircularArray<int, 5> medianArray(5);
+    TEST_ASSERT_EQUAL(5, medianArray.getMaxSize());
+    TEST_ASSERT_FALSE(medianArray.isFull());
+    for (int i = 0; i < 100; i++) {
+        medianArray.push(i);
+        TEST_ASSERT_EQUAL(i % medianArray.getMaxSize(), medianArray.getHead());
+    }
+    TEST_ASSERT_EQUAL(99, medianArray.getFromHead(0));
+    TEST_ASSERT_EQUAL(98, medianArray.getFromHead(1));
+    TEST_ASSERT_EQUAL(95, medianArray.getFromHead(4));
+    TEST_ASSERT_TRUE(medianArray.isFull());
+}
+
+void test_median_odd(void) {
+    MedianCircularArray<int, 5> medianArray(5);
+    TEST_ASSERT_EQUAL(0, medianArray.getMedian());
+    for (int i = 1; i <= 5; i++) {
+        medianArray.push(i);
+    }
+    TEST_ASSERT_EQUAL(3, medianArray.getMedian());
+    medianArray.push(6);
+    TEST_ASSERT_EQUAL(4, medianArray.getMedian());
+    medianArray.push(7);
+    TEST_ASSERT_EQUAL(5, medianArray.getMedian());
+    // Outliers replace the oldest values without dragging the median with them
+    medianArray.push(-100); // window is 4, 5, 6, 7, -100
+    TEST_ASSERT_EQUAL(5, medianArray.getMedian());
+    medianArray.push(-100); // window is 5, 6, 7, -100, -100
+    TEST_ASSERT_EQUAL(5, medianArray.getMedian());
+    medianArray.push(-100); // window is 6, 7, -100, -100, -100
+    TEST_ASSERT_EQUAL(-100, medianArray.getMedian());
+}
+
+void test_median_even(void) {
+    MedianCircularArray<int, 6> medianArray(6);
+    for (int i = 1; i <= 6; i++) {
+        medianArray.push(i);
+    }
+    TEST_ASSERT_EQUAL(4, medianArray.getMedian());
+    medianArray.push(7);
+    TEST_ASSERT_EQUAL(5, medianArray.getMedian());
+    medianArray.push(8);
+    TEST_ASSERT_EQUAL(6, medianArray.getMedian());
+}
+
+void test_median_datapoint_uses_data(void) {
+    MedianCircularArray<DataPoint, 5> medianArray(5);
+    TEST_ASSERT_EQUAL_FLOAT(0, medianArray.getMedian().data);
+
+    medianArray.push(DataPoint(1, 1.0));
+    TEST_ASSERT_EQUAL_FLOAT(1.0, medianArray.getMedian().data);
+
+    medianArray.push(DataPoint(2, 2.0));
+    medianArray.push(DataPoint(3, 3.0));
+    medianArray.push(DataPoint(4, 4.0));
+    medianArray.push(DataPoint(5, 5.0));
+    TEST_ASSERT_EQUAL_FLOAT(3.0, medianArray.getMedian().data);
+
+    // Data values are now 0, 2, 3, 4, 5
+    medianArray.push(DataPoint(6, 0.0));
+    TEST_ASSERT_EQUAL_FLOAT(3.0, medianArray.getMedian().data);
+    TEST_ASSERT_EQUAL_UINT32(3, medianArray.getMedian().timestamp_ms);
+}
+
+void test_clear(void) {
+    MedianCircularArray<int, 5> medianArray(5);
+    for (int i = 0; i < 5; i++) {
+        medianArray.push(i);
+    }
+    TEST_ASSERT_TRUE(medianArray.isFull());
+    medianArray.clear();
+    TEST_ASSERT_FALSE(medianArray.isFull());
+    TEST_ASSERT_EQUAL(0, medianArray.getHead());
+    TEST_ASSERT_EQUAL(0, medianArray.getMedian());
+    medianArray.push(42);
+    TEST_ASSERT_EQUAL(42, medianArray.getMedian());
+}
+
+// Random data (with plenty of duplicates) must give the same median as the
+// sort-based CircularArray at every step, for a few window sizes.
+template <std::size_t Capacity>
+void checkMatchesCircularArray(uint8_t maxSize, unsigned seed) {
+    CircularArray<float, Capacity> reference(maxSize);
+    MedianCircularArray<float, Capacity> medianArray(maxSize);
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(-50, 50);
+    for (int i = 0; i < 2000; i++) {
+        float value = static_cast<float>(dist(gen)) * 0.5f;
+        reference.push(value);
+        medianArray.push(value);
+        TEST_ASSERT_EQUAL_FLOAT(reference.getMedian(), medianArray.getMedian());
+        TEST_ASSERT_EQUAL_FLOAT(reference.getFromHead(0), medianArray.getFromHead(0));
+    }
+}
+
+void test_matches_circular_array_median(void) {
+    checkMatchesCircularArray<1>(1, 1);
+    checkMatchesCircularArray<2>(2, 2);
+    checkMatchesCircularArray<5>(5, 3);
+    checkMatchesCircularArray<64>(64, 4);
+    checkMatchesCircularArray<64>(17, 5);
+    checkMatchesCircularArray<MAX_CIRCULAR_ARRAY_CAPACITY>(MAX_CIRCULAR_ARRAY_CAPACITY, 6);
+}
+
+// -----------------------------------------------------------------------------
+// Benchmark: push + getMedian per tick, the way LaunchDetector::update uses it
+// -----------------------------------------------------------------------------
+template <typename Array>
+double nsPerTick(Array& array, const float* samples, int count) {
+    volatile float sink = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        array.push(samples[i]);
+        sink = array.getMedian();
+    }
+    auto end = std::chrono::steady_clock::now();
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+template <std::size_t Capacity>
+void benchmarkCapacity() {
+    const int count = 20000;
+    static float samples[count];
+    std::mt19937 gen(42);
+    std::normal_distribution<float> dist(9.81f, 0.5f);
+    for (int i = 0; i < count; i++) {
+        samples[i] = dist(gen);
+    }
+
+    CircularArray<float, Capacity> sortArray(Capacity);
+    MedianCircularArray<float, Capacity> medianArray(Capacity);
+    double sortNs = nsPerTick(sortArray, samples, count);
+    double heapNs = nsPerTick(medianArray, samples, count);
+
+    std::cout << "Median benchmark, capacity " << Capacity
+              << ": CircularArray " << sortNs << " ns/tick, "
+              << "MedianCircularArray " << heapNs << " ns/tick ("
+              << sortNs / heapNs << "x)\n";
+
+    // Both must have landed on the same answer
+    TEST_ASSERT_EQUAL_FLOAT(sortArray.getMedian(), medianArray.getMedian());
+}
+
+void test_benchmark_median(void) {
+    benchmarkCapacity<5>();
+    benchmarkCapacity<64>();
+    benchmarkCapacity<MAX_CIRCULAR_ARRAY_CAPACITY>();
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_and_get_from_head);
+    RUN_TEST(test_median_odd);
+    RUN_TEST(test_median_even);
+    RUN_TEST(test_median_datapoint_uses_data);
+    RUN_TEST(test_clear);
+    RUN_TEST(test_matches_circular_array_median);
+    RUN_TEST(test_benchmark_median);
+    return UNITY_END();
+}
@@ -0,0 +1,132 @@
+#include "unity.h"
+#include "MultiChannelCircularArray.h"
+#include "SizedCircularArray.h"
+#include "data_handling/DataPoint.h"
+
+#include <chrono>
+#include <iostream>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+void test_push_and_get_from_head(void) {
+    MultiChannelCircularArray<3, 4> imu(4);
+    TEST_ASSERT_EQUAL(0, imu.getSize());
+
+    for (uint32_t i = 0; i < 6; i++) {
+        const float values[3] = {static_cast<float>(i), 10.0f + i, 20.0f + i};
+        imu.push(i * 10, values);
+    }
+    TEST_ASSERT_TRUE(imu.isFull());
+    TEST_ASSERT_EQUAL(4, imu.getSize());
+
+    // Newest is sample 5, oldest kept is sample 2
+    TEST_ASSERT_EQUAL(50, imu.getTimestampFromHead(0));
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, imu.getFromHead(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(15.0f, imu.getFromHead(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, imu.getFromHead(0, 2));
+    TEST_ASSERT_EQUAL(20, imu.getTimestampFromHead(3));
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, imu.getFromHead(3, 2));
+
+    DataPoint y = imu.getChannelFromHead(1, 1);
+    TEST_ASSERT_EQUAL(40, y.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(14.0f, y.data);
+
+    ArraySpan<float> sample = imu.getSampleFromHead(2);
+    TEST_ASSERT_EQUAL(3, sample.size);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, sample[0]);
+    TEST_ASSERT_EQUAL_FLOAT(13.0f, sample[1]);
+    TEST_ASSERT_EQUAL_FLOAT(23.0f, sample[2]);
+
+    imu.clear();
+    TEST_ASSERT_EQUAL(0, imu.getSize());
+    TEST_ASSERT_FALSE(imu.isFull());
+}
+
+void test_triplet_push_and_magnitude(void) {
+    AccelerationCircularArray<8> imu(8);
+    imu.push(DataPoint(100, 3.0f), DataPoint(100, 4.0f), DataPoint(100, 12.0f));
+    imu.push(DataPoint(110, 0.0f), DataPoint(110, 0.0f), DataPoint(110, 9.81f));
+
+    TEST_ASSERT_EQUAL(2, imu.getSize());
+    TEST_ASSERT_EQUAL(110, imu.getTimestampFromHead(0));
+    TEST_ASSERT_EQUAL_FLOAT(169.0f, imu.getMagnitudeSquaredFromHead(1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 9.81f * 9.81f, imu.getMagnitudeSquaredFromHead(0));
+}
+
+void test_channel_median_matches_single_channel_ring(void) {
+    MultiChannelCircularArray<3, 50> imu(25);
+    SizedCircularArray<DataPoint, 50> zOnly(25);
+
+    uint32_t state = 12345;
+    for (uint32_t t = 0; t < 200; t++) {
+        state = state * 1103515245U + 12345U;
+        const float values[3] = {static_cast<float>(t), -static_cast<float>(t),
+                                 static_cast<float>((state >> 16) % 1000) / 10.0f};
+        imu.push(t, values);
+        zOnly.push(DataPoint(t, values[2]));
+
+        TEST_ASSERT_EQUAL_FLOAT(zOnly.getMedian().data, imu.getChannelMedian(2));
+    }
+    float scratch[50];
+    TEST_ASSERT_EQUAL_FLOAT(imu.getChannelMedian(2), imu.getChannelMedian(2, scratch));
+    MultiChannelCircularArray<2, 4> empty(4);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, empty.getChannelMedian(0));
+}
+
+void test_footprint_vs_three_rings(void) {
+    // One timestamp per slot instead of one per axis
+    typedef MultiChannelCircularArray<3, 100> Shared;
+    typedef SizedCircularArray<DataPoint, 100> PerAxis;
+    std::cout << "IMU history, 100 samples: shared " << sizeof(Shared)
+              << " B, three rings " << 3 * sizeof(PerAxis) << " B\n";
+    TEST_ASSERT_TRUE(sizeof(Shared) < 3 * sizeof(PerAxis));
+    TEST_ASSERT_EQUAL(100 * (sizeof(uint32_t) + 3 * sizeof(float)) + 4, sizeof(Shared));
+}
+
+void test_benchmark_shared_vs_three_rings(void) {
+    const int samples = 1000000;
+    static MultiChannelCircularArray<3, 100> shared(100);
+    static SizedCircularArray<DataPoint, 100> x(100), y(100), z(100);
+
+    volatile float sink = 0.0f;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; i++) {
+        const uint32_t t = static_cast<uint32_t>(i);
+        const float v = static_cast<float>(i & 63);
+        x.push(DataPoint(t, v));
+        y.push(DataPoint(t, -v));
+        z.push(DataPoint(t, v + 9.81f));
+        const DataPoint a = x.getFromHead(0), b = y.getFromHead(0), c = z.getFromHead(0);
+        sink = sink + a.data * a.data + b.data * b.data + c.data * c.data;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; i++) {
+        const float v = static_cast<float>(i & 63);
+        const float values[3] = {v, -v, v + 9.81f};
+        shared.push(static_cast<uint32_t>(i), values);
+        sink = sink + shared.getMagnitudeSquaredFromHead(0);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    std::cout << "push + |a|^2 per sample: three rings "
+              << std::chrono::duration<double, std::nano>(t1 - t0).count() / samples << " ns, shared "
+              << std::chrono::duration<double, std::nano>(t2 - t1).count() / samples << " ns\n";
+    TEST_ASSERT_EQUAL_FLOAT(x.getFromHead(0).data, shared.getFromHead(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(z.getFromHead(0).data, shared.getFromHead(0, 2));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_and_get_from_head);
+    RUN_TEST(test_triplet_push_and_magnitude);
+    RUN_TEST(test_channel_median_matches_single_channel_ring);
+    RUN_TEST(test_footprint_vs_three_rings);
+    RUN_TEST(test_benchmark_shared_vs_three_rings);
+    return UNITY_END();
+}
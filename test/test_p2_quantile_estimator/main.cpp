@@ -0,0 +1,127 @@
+#include "unity.h"
+#include "P2QuantileEstimator.h"
+#include "data_handling/DataPoint.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+static float exactQuantile(std::vector<float> values, float p) {
+    std::size_t rank = static_cast<std::size_t>(p * static_cast<float>(values.size() - 1) + 0.5f);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+void test_empty_and_first_samples_are_exact(void) {
+    P2QuantileEstimator median(0.5f);
+    TEST_ASSERT_EQUAL_UINT32(0, median.getCount());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, median.getQuantile());
+
+    median.push(DataPoint(1, 5.0f));
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, median.getQuantile());
+    median.push(DataPoint(2, 1.0f));
+    median.push(DataPoint(3, 3.0f));
+    // 1, 3, 5
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, median.getQuantile());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, median.getMin());
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, median.getMax());
+    median.push(4.0f);
+    median.push(2.0f);
+    // 1, 2, 3, 4, 5
+    TEST_ASSERT_EQUAL_UINT32(5, median.getCount());
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, median.getQuantile());
+}
+
+void test_constant_stream(void) {
+    P2QuantileEstimator p90(0.9f);
+    for (int i = 0; i < 10000; i++) {
+        p90.push(101325.0f);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(101325.0f, p90.getQuantile());
+}
+
+void test_tracks_min_and_max(void) {
+    P2QuantileEstimator median(0.5f);
+    for (int i = 0; i < 1000; i++) {
+        median.push(static_cast<float>(i % 100));
+    }
+    median.push(-7.0f);
+    median.push(500.0f);
+    TEST_ASSERT_EQUAL_FLOAT(-7.0f, median.getMin());
+    TEST_ASSERT_EQUAL_FLOAT(500.0f, median.getMax());
+}
+
+void test_reset(void) {
+    P2QuantileEstimator median(0.5f);
+    for (int i = 0; i < 100; i++) {
+        median.push(static_cast<float>(i));
+    }
+    median.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, median.getCount());
+    median.push(42.0f);
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, median.getQuantile());
+}
+
+// Pad-hold style accelerometer noise: the estimate must land close to the
+// exact quantile of the whole stream for several target quantiles.
+void test_converges_on_noisy_sensor(void) {
+    const float quantiles[] = {0.1f, 0.5f, 0.9f, 0.99f};
+    std::mt19937 gen(1);
+    std::normal_distribution<float> noise(9.81f, 0.15f);
+    std::vector<float> samples(200000);
+    for (std::size_t i = 0; i < samples.size(); i++) {
+        samples[i] = noise(gen);
+    }
+
+    for (std::size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+        P2QuantileEstimator estimator(quantiles[q]);
+        for (std::size_t i = 0; i < samples.size(); i++) {
+            estimator.push(DataPoint(static_cast<uint32_t>(i), samples[i]));
+        }
+        float exact = exactQuantile(samples, quantiles[q]);
+        std::cout << "P2 q=" << quantiles[q] << ": estimate " << estimator.getQuantile()
+                  << ", exact " << exact << "\n";
+        // Within 1% of the noise standard deviation
+        TEST_ASSERT_FLOAT_WITHIN(0.015f, exact, estimator.getQuantile());
+    }
+}
+
+void test_skewed_distribution(void) {
+    // Exponential data (e.g. gust-driven baro noise) is strongly skewed
+    std::mt19937 gen(2);
+    std::exponential_distribution<float> dist(2.0f);
+    std::vector<float> samples(100000);
+    P2QuantileEstimator p90(0.9f);
+    for (std::size_t i = 0; i < samples.size(); i++) {
+        samples[i] = dist(gen);
+        p90.push(samples[i]);
+    }
+    float exact = exactQuantile(samples, 0.9f);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f * exact, exact, p90.getQuantile());
+}
+
+void test_constant_memory(void) {
+    // Memory does not depend on how long the stream is
+    TEST_ASSERT_LESS_OR_EQUAL(200, sizeof(P2QuantileEstimator));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_and_first_samples_are_exact);
+    RUN_TEST(test_constant_stream);
+    RUN_TEST(test_tracks_min_and_max);
+    RUN_TEST(test_reset);
+    RUN_TEST(test_converges_on_noisy_sensor);
+    RUN_TEST(test_skewed_distribution);
+    RUN_TEST(test_constant_memory);
+    return UNITY_END();
+}
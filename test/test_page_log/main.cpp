@@ -0,0 +1,413 @@
+#include "unity.h"
+#include "PageLog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+// NOR flash image that records every program operation, so a power loss can
+// be replayed at any byte of the program stream. A read costs a command plus
+// the transfer at ~16 Mbit/s.
+class RecordingMockFlash {
+public:
+    static const uint32_t COMMAND_US = 5;
+
+    struct Program {
+        uint32_t address;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<uint8_t> memory;
+    std::vector<bool> erased;
+    std::vector<Program> programs;
+    bool recording = true;
+    uint32_t unerasedWrites = 0;
+    uint32_t reads = 0;
+    uint64_t readTime_us = 0;
+
+    explicit RecordingMockFlash(uint32_t size) : memory(size, 0xFF), erased(size, true) {}
+
+    uint32_t writeBuffer(uint32_t address, const uint8_t* data, uint32_t length) {
+        if (recording) {
+            Program program;
+            program.address = address;
+            program.data.assign(data, data + length);
+            programs.push_back(program);
+        }
+        apply(address, data, length);
+        return length;
+    }
+
+    uint32_t readBuffer(uint32_t address, uint8_t* data, uint32_t length) {
+        reads++;
+        readTime_us += COMMAND_US + length / 2;
+        std::memcpy(data, &memory[address], length);
+        return length;
+    }
+
+    void eraseRange(uint32_t address, uint32_t length) {
+        for (uint32_t i = 0; i < length; i++) {
+            memory[address + i] = 0xFF;
+            erased[address + i] = true;
+        }
+    }
+
+    // The image as it was when power was lost after programmedBytes bytes
+    void truncateTo(const std::vector<Program>& history, std::size_t programmedBytes) {
+        std::fill(memory.begin(), memory.end(), 0xFF);
+        std::fill(erased.begin(), erased.end(), true);
+        for (std::size_t i = 0; i < history.size() && programmedBytes > 0; i++) {
+            const std::size_t n = std::min(programmedBytes, history[i].data.size());
+            apply(history[i].address, &history[i].data[0], static_cast<uint32_t>(n));
+            programmedBytes -= n;
+        }
+        programs.clear();
+        unerasedWrites = 0;
+        reads = 0;
+        readTime_us = 0;
+    }
+
+private:
+    void apply(uint32_t address, const uint8_t* data, uint32_t length) {
+        for (uint32_t i = 0; i < length; i++) {
+            // Programming 0xFF over a byte changes nothing, e.g. the commit byte in a header
+            if (!erased[address + i] && data[i] != 0xFF) {
+                unerasedWrites++;
+            }
+            memory[address + i] &= data[i];  // NOR flash can only clear bits
+            if (data[i] != 0xFF) {
+                erased[address + i] = false;
+            }
+        }
+    }
+};
+
+typedef PageLogWriter<RecordingMockFlash, 256> Writer;
+
+static const uint32_t RECORD_SIZE = 5;
+
+// A Record_t {name, float}; names stay below 0x80 so a record never starts with 0xFF
+static void makeRecord(uint32_t i, uint8_t* record) {
+    record[0] = static_cast<uint8_t>(i % 7);
+    const float value = std::sin(i * 0.01f) * 100.0f;
+    std::memcpy(record + 1, &value, 4);
+}
+
+static std::size_t totalBytes(const std::vector<RecordingMockFlash::Program>& history) {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < history.size(); i++) {
+        total += history[i].data.size();
+    }
+    return total;
+}
+
+// Every record in the log's pages, in order, skipping torn pages
+static void decodeLog(const RecordingMockFlash& flash, const PageLogRecovery& recovery,
+                      std::vector<std::vector<uint8_t> >& records) {
+    if (!recovery.found) {
+        return;
+    }
+    for (uint32_t page = recovery.firstPageAddress; page <= recovery.lastPageAddress; page += 256) {
+        uint32_t sequence = 0;
+        if (!page_log::parseHeader(&flash.memory[page], sequence)) {
+            continue;
+        }
+        for (uint32_t offset = page_log::HEADER_SIZE; offset + RECORD_SIZE <= 256; offset += RECORD_SIZE) {
+            if (flash.memory[page + offset] == 0xFF) {
+                break;
+            }
+            records.push_back(std::vector<uint8_t>(&flash.memory[page + offset],
+                                                   &flash.memory[page + offset] + RECORD_SIZE));
+        }
+    }
+}
+
+void test_header_round_trip_and_torn_header(void) {
+    uint8_t header[page_log::HEADER_SIZE];
+    page_log::encodeHeader(0x12345678UL, header);
+    uint32_t sequence = 0;
+    TEST_ASSERT_TRUE(page_log::parseHeader(header, sequence));
+    TEST_ASSERT_EQUAL_UINT32(0x12345678UL, sequence);
+    TEST_ASSERT_FALSE(page_log::isCommitted(header));
+    header[page_log::COMMIT_OFFSET] = page_log::COMMITTED;
+    TEST_ASSERT_TRUE(page_log::isCommitted(header));
+
+    // Any single torn byte fails the CRC or marker
+    for (int i = 0; i < 6; i++) {
+        uint8_t torn[page_log::HEADER_SIZE];
+        std::memcpy(torn, header, sizeof(torn));
+        torn[i] = 0xFF;
+        TEST_ASSERT_FALSE(page_log::parseHeader(torn, sequence));
+    }
+    uint8_t blank[page_log::HEADER_SIZE];
+    std::memset(blank, 0xFF, sizeof(blank));
+    TEST_ASSERT_FALSE(page_log::parseHeader(blank, sequence));
+}
+
+void test_empty_chip(void) {
+    RecordingMockFlash flash(64 * 1024);
+    const PageLogRecovery recovery = recoverPageLog<256>(flash, 4096, 64 * 1024);
+    TEST_ASSERT_FALSE(recovery.found);
+    TEST_ASSERT_EQUAL_UINT32(4096, recovery.nextWriteAddress);
+    TEST_ASSERT_EQUAL_UINT32(0, recovery.nextSequence);
+    TEST_ASSERT_EQUAL(1, flash.reads);
+}
+
+// Number of page headers DataSaverSPI-style recovery reads: every one up to the first blank page
+static uint32_t linearScanReads(RecordingMockFlash& flash, uint32_t start, uint32_t end) {
+    uint32_t reads = 0;
+    uint8_t header[page_log::HEADER_SIZE];
+    for (uint32_t page = start; page < end; page += 256) {
+        flash.readBuffer(page, header, sizeof(header));
+        reads++;
+        uint32_t sequence = 0;
+        if (!page_log::parseHeader(header, sequence)) {
+            break;
+        }
+    }
+    return reads;
+}
+
+void test_recovery_on_a_16_MB_chip_is_logarithmic(void) {
+    const uint32_t size = 16UL * 1024 * 1024;
+    static RecordingMockFlash flash(size);
+    flash.recording = false;
+    Writer writer(flash, 0, size);
+    writer.begin(0);
+
+    // Three quarters of the chip, with the last page left open
+    const uint32_t records = size / 4 * 3 / RECORD_SIZE;
+    uint8_t record[RECORD_SIZE];
+    for (uint32_t i = 0; i < records; i++) {
+        makeRecord(i, record);
+        TEST_ASSERT_TRUE(writer.write(record, RECORD_SIZE));
+    }
+    writer.flush();
+    TEST_ASSERT_EQUAL(0, flash.unerasedWrites);
+
+    flash.reads = 0;
+    flash.readTime_us = 0;
+    const PageLogRecovery recovery = recoverPageLog<256>(flash, 0, size);
+    const uint64_t binary_us = flash.readTime_us;
+    TEST_ASSERT_TRUE(recovery.found);
+    TEST_ASSERT_EQUAL_UINT32(writer.getPageAddress(), recovery.lastPageAddress);
+    TEST_ASSERT_FALSE(recovery.lastPageCommitted);
+    TEST_ASSERT_EQUAL_UINT32(writer.getPageAddress() + 256, recovery.nextWriteAddress);
+    TEST_ASSERT_EQUAL_UINT32(writer.getSequence() + 1, recovery.nextSequence);
+    TEST_ASSERT_EQUAL(0, recovery.tornPagesSkipped);
+    // log2(65536) header probes, the last page, and the page after it
+    TEST_ASSERT_TRUE(recovery.flashReads <= 16 + 4);
+    TEST_ASSERT_EQUAL(recovery.flashReads, flash.reads);
+
+    flash.readTime_us = 0;
+    const uint32_t linearReads = linearScanReads(flash, 0, size);
+    std::cout << "16 MB chip, " << linearReads << " pages used: binary search " << recovery.flashReads
+              << " reads / " << binary_us << " us, linear scan " << linearReads << " reads / "
+              << flash.readTime_us / 1000 << " ms\n";
+    TEST_ASSERT_TRUE(binary_us < 1000);
+    TEST_ASSERT_TRUE(flash.readTime_us > 100 * binary_us);
+}
+
+// Writes count records starting at record first, flushing every flushEvery records
+static void writeSession(Writer& writer, uint32_t first, uint32_t count, uint32_t flushEvery) {
+    uint8_t record[RECORD_SIZE];
+    for (uint32_t i = first; i < first + count; i++) {
+        makeRecord(i, record);
+        TEST_ASSERT_TRUE(writer.write(record, RECORD_SIZE));
+        if ((i + 1) % flushEvery == 0) {
+            writer.flush();
+        }
+    }
+    writer.flush();
+}
+
+static bool sameRecord(const std::vector<uint8_t>& decoded, uint32_t i) {
+    uint8_t record[RECORD_SIZE];
+    makeRecord(i, record);
+    return std::memcmp(&decoded[0], record, RECORD_SIZE) == 0;
+}
+
+void test_power_loss_at_any_byte(void) {
+    const uint32_t start = 4096;
+    const uint32_t end = 64 * 1024;
+    const uint32_t firstSession = 6000;
+    const uint32_t secondSession = 1000;
+
+    RecordingMockFlash flash(end);
+    Writer writer(flash, start, end);
+    writer.begin(0);
+    writeSession(writer, 0, firstSession, 7);
+    const std::vector<RecordingMockFlash::Program> history = flash.programs;
+    const std::size_t total = totalBytes(history);
+
+    std::vector<std::size_t> cuts;
+    for (std::size_t cut = 0; cut < 600; cut++) {
+        cuts.push_back(cut);  // inside the very first page and its header
+    }
+    std::default_random_engine rng(1);
+    std::uniform_int_distribution<std::size_t> anyByte(0, total);
+    for (int i = 0; i < 400; i++) {
+        cuts.push_back(anyByte(rng));
+    }
+    cuts.push_back(total);
+
+    uint32_t tornHeaders = 0;
+    uint32_t openPages = 0;
+    for (std::size_t c = 0; c < cuts.size(); c++) {
+        flash.truncateTo(history, cuts[c]);
+        const PageLogRecovery recovery = recoverPageLog<256>(flash, start, end);
+        tornHeaders += recovery.tornPagesSkipped > 0 ? 1 : 0;
+        openPages += recovery.found && !recovery.lastPageCommitted ? 1 : 0;
+
+        // Records before the first one that differs from what was written
+        std::vector<std::vector<uint8_t> > decoded;
+        decodeLog(flash, recovery, decoded);
+        uint32_t intact = 0;
+        while (intact < decoded.size() && sameRecord(decoded[intact], intact)) {
+            intact++;
+        }
+        // Only the record being programmed when power was lost may be damaged
+        TEST_ASSERT_TRUE(intact + 1 >= decoded.size());
+        TEST_ASSERT_TRUE(decoded.size() <= firstSession);
+        if (cuts[c] == total) {
+            TEST_ASSERT_EQUAL(firstSession, intact);
+        }
+
+        // The log resumes on erased flash and a second boot finds both sessions
+        TEST_ASSERT_TRUE(recovery.nextWriteAddress % 256 == 0);
+        Writer resumed(flash, start, end);
+        resumed.resume(recovery);
+        writeSession(resumed, firstSession, secondSession, 11);
+        TEST_ASSERT_EQUAL(0, flash.unerasedWrites);
+
+        const PageLogRecovery second = recoverPageLog<256>(flash, start, end);
+        TEST_ASSERT_TRUE(second.found);
+        TEST_ASSERT_EQUAL_UINT32(resumed.getPageAddress(), second.lastPageAddress);
+        std::vector<std::vector<uint8_t> > both;
+        decodeLog(flash, second, both);
+        TEST_ASSERT_EQUAL(decoded.size() + secondSession, both.size());
+        for (uint32_t i = 0; i < secondSession; i++) {
+            TEST_ASSERT_TRUE(sameRecord(both[decoded.size() + i], firstSession + i));
+        }
+    }
+    // The cuts hit headers being programmed and pages left open
+    TEST_ASSERT_GREATER_THAN(0, tornHeaders);
+    TEST_ASSERT_GREATER_THAN(0, openPages);
+}
+
+void test_old_log_beyond_the_end_is_ignored(void) {
+    const uint32_t end = 256 * 1024;
+    RecordingMockFlash flash(end);
+    Writer writer(flash, 0, end);
+    writer.begin(0);
+    writeSession(writer, 0, 30000, 50);
+    const PageLogRecovery old = recoverPageLog<256>(flash, 0, end);
+
+    // Next flight: erase just enough for a shorter log, restart at the region start
+    flash.eraseRange(0, 32 * 1024);
+    writer.begin(old.nextSequence);
+    writeSession(writer, 0, 3000, 50);
+    TEST_ASSERT_EQUAL(0, flash.unerasedWrites);
+
+    const PageLogRecovery recovery = recoverPageLog<256>(flash, 0, end);
+    TEST_ASSERT_TRUE(recovery.found);
+    TEST_ASSERT_EQUAL_UINT32(old.nextSequence, recovery.firstSequence);
+    TEST_ASSERT_EQUAL_UINT32(writer.getPageAddress(), recovery.lastPageAddress);
+    std::vector<std::vector<uint8_t> > decoded;
+    decodeLog(flash, recovery, decoded);
+    TEST_ASSERT_EQUAL(3000, decoded.size());
+}
+
+void test_torn_header_that_passes_its_crc_is_skipped(void) {
+    const uint32_t end = 64 * 1024;
+    RecordingMockFlash flash(end);
+    Writer writer(flash, 0, end);
+    writer.begin(0);
+    writeSession(writer, 0, 500, 50);
+    const uint32_t planted = writer.getPageAddress() + 256;
+
+    // Marker and sequence programmed, CRC byte still erased, and the CRC
+    // happens to be 0xFF for a sequence that doesn't follow the log
+    uint8_t header[page_log::HEADER_SIZE];
+    uint32_t sequence = writer.getSequence() + 2;
+    do {
+        page_log::encodeHeader(++sequence, header);
+    } while (header[5] != 0xFF);
+    flash.writeBuffer(planted, header, 5);
+    uint32_t parsed = 0;
+    TEST_ASSERT_TRUE(page_log::parseHeader(&flash.memory[planted], parsed));
+
+    const PageLogRecovery recovery = recoverPageLog<256>(flash, 0, end);
+    TEST_ASSERT_EQUAL_UINT32(writer.getPageAddress(), recovery.lastPageAddress);
+    TEST_ASSERT_EQUAL_UINT32(planted + 256, recovery.nextWriteAddress);
+    TEST_ASSERT_EQUAL(1, recovery.tornPagesSkipped);
+
+    Writer resumed(flash, 0, end);
+    resumed.resume(recovery);
+    writeSession(resumed, 500, 500, 50);
+    TEST_ASSERT_EQUAL(0, flash.unerasedWrites);
+}
+
+void test_full_region_drops_records(void) {
+    RecordingMockFlash flash(4096);
+    Writer writer(flash, 0, 1024);  // four pages
+    writer.begin(0);
+    uint8_t record[RECORD_SIZE];
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        makeRecord(i, record);
+        if (writer.write(record, RECORD_SIZE)) {
+            accepted++;
+        }
+    }
+    TEST_ASSERT_EQUAL(4 * (Writer::PAYLOAD_SIZE / RECORD_SIZE), accepted);
+    TEST_ASSERT_EQUAL((1000 - accepted) * RECORD_SIZE, writer.getDroppedBytes());
+
+    uint8_t tooLong[Writer::PAYLOAD_SIZE + 1] = {0};
+    TEST_ASSERT_FALSE(writer.write(tooLong, sizeof(tooLong)));
+}
+
+void test_writer_needs_an_explicit_start(void) {
+    RecordingMockFlash flash(4096);
+    Writer writer(flash, 0, 4096);
+    uint8_t record[RECORD_SIZE];
+    makeRecord(1, record);
+    TEST_ASSERT_FALSE(writer.write(record, RECORD_SIZE));
+    writer.flush();
+    TEST_ASSERT_EQUAL(0, flash.programs.size());
+    TEST_ASSERT_EQUAL(RECORD_SIZE, writer.getDroppedBytes());
+
+    writer.begin(0);
+    TEST_ASSERT_TRUE(writer.write(record, RECORD_SIZE));
+    // A record ending in 0xFF (a NaN float) can't be told from the erased tail
+    const uint8_t nan[RECORD_SIZE] = {1, 0xFF, 0xFF, 0xFF, 0xFF};
+    TEST_ASSERT_TRUE(writer.write(nan, RECORD_SIZE));
+    writer.flush();
+    const PageLogRecovery recovery = recoverPageLog<256>(flash, 0, 4096);
+    TEST_ASSERT_TRUE(recovery.found);
+    TEST_ASSERT_EQUAL_UINT32(page_log::HEADER_SIZE + RECORD_SIZE + 1, recovery.lastPageUsedBytes);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_header_round_trip_and_torn_header);
+    RUN_TEST(test_empty_chip);
+    RUN_TEST(test_recovery_on_a_16_MB_chip_is_logarithmic);
+    RUN_TEST(test_power_loss_at_any_byte);
+    RUN_TEST(test_old_log_beyond_the_end_is_ignored);
+    RUN_TEST(test_torn_header_that_passes_its_crc_is_skipped);
+    RUN_TEST(test_full_region_drops_records);
+    RUN_TEST(test_writer_needs_an_explicit_start);
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+#include "unity.h"
+#include "QuantizedRecord.h"
+#include "SimpleSimulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+static const uint8_t ACCELEROMETER_Z = 2;
+static const uint8_t ALTITUDE = 5;
+static const uint8_t TEMPERATURE = 8;
+
+void test_descriptor_round_trip_error_is_half_a_step(void) {
+    const QuantizationDescriptor accel = QuantizationDescriptor::forRange(-160.0f, 160.0f, 12);
+    TEST_ASSERT_EQUAL(4094, accel.maxCode());
+    TEST_ASSERT_EQUAL(4095, accel.nanCode());
+
+    float worst = 0.0f;
+    for (float v = -160.0f; v <= 160.0f; v += 0.013f) {
+        const uint16_t code = accel.encode(v);
+        TEST_ASSERT_TRUE(code <= accel.maxCode());
+        worst = std::max(worst, std::fabs(accel.decode(code) - v));
+    }
+    TEST_ASSERT_TRUE(worst <= accel.scale * 0.5f + 1e-4f);
+
+    TEST_ASSERT_EQUAL_FLOAT(-160.0f, accel.decode(accel.encode(-160.0f)));
+    TEST_ASSERT_EQUAL_FLOAT(160.0f, accel.decode(accel.encode(160.0f)));
+}
+
+void test_out_of_range_clamps_and_nan_survives(void) {
+    const QuantizationDescriptor volts = QuantizationDescriptor::forRange(6.0f, 8.4f, 8);
+    TEST_ASSERT_EQUAL(0, volts.encode(-100.0f));
+    TEST_ASSERT_EQUAL(volts.maxCode(), volts.encode(100.0f));
+    TEST_ASSERT_EQUAL(volts.maxCode(), volts.encode(INFINITY));
+    TEST_ASSERT_EQUAL(0, volts.encode(-INFINITY));
+    TEST_ASSERT_EQUAL(volts.nanCode(), volts.encode(NAN));
+    TEST_ASSERT_TRUE(std::isnan(volts.decode(volts.encode(NAN))));
+}
+
+void test_records_fall_back_to_full_precision(void) {
+    QuantizationTable<4> table;
+    TEST_ASSERT_TRUE(table.set(ACCELEROMETER_Z, QuantizationDescriptor::forRange(-160.0f, 160.0f, 16)));
+    TEST_ASSERT_EQUAL(1, table.getSize());
+    TEST_ASSERT_TRUE(table.find(ALTITUDE) == nullptr);
+
+    uint8_t buffer[2 * quantized_record::MAX_SIZE];
+    std::size_t used = quantized_record::encode(table, ACCELEROMETER_Z, 9.81f, buffer);
+    TEST_ASSERT_EQUAL(quantized_record::QUANTIZED_SIZE, used);
+    used += quantized_record::encode(table, ALTITUDE, 1234.567f, buffer + used);
+    TEST_ASSERT_EQUAL(quantized_record::QUANTIZED_SIZE + quantized_record::FULL_SIZE, used);
+
+    uint8_t name = 0;
+    float value = 0.0f;
+    std::size_t offset = quantized_record::decode(table, buffer, used, name, value);
+    TEST_ASSERT_EQUAL(3, offset);
+    TEST_ASSERT_EQUAL_UINT8(ACCELEROMETER_Z, name);
+    TEST_ASSERT_FLOAT_WITHIN(0.003f, 9.81f, value);
+    TEST_ASSERT_EQUAL(5, quantized_record::decode(table, buffer + offset, used - offset, name, value));
+    TEST_ASSERT_EQUAL_UINT8(ALTITUDE, name);
+    TEST_ASSERT_EQUAL_FLOAT(1234.567f, value);
+
+    // Truncated input
+    TEST_ASSERT_EQUAL(0, quantized_record::decode(table, buffer, 2, name, value));
+    TEST_ASSERT_EQUAL(0, quantized_record::decode(table, buffer + offset, 4, name, value));
+
+    // Replacing a descriptor doesn't use a new slot
+    TEST_ASSERT_TRUE(table.set(ACCELEROMETER_Z, QuantizationDescriptor::forRange(-80.0f, 80.0f, 12)));
+    TEST_ASSERT_EQUAL(1, table.getSize());
+    QuantizationTable<1> full;
+    TEST_ASSERT_TRUE(full.set(1, QuantizationDescriptor::forRange(0.0f, 1.0f, 8)));
+    TEST_ASSERT_FALSE(full.set(2, QuantizationDescriptor::forRange(0.0f, 1.0f, 8)));
+}
+
+void test_bit_packed_telemetry_frame(void) {
+    const QuantizationDescriptor accel = QuantizationDescriptor::forRange(-160.0f, 160.0f, 12);
+    const QuantizationDescriptor temperature = QuantizationDescriptor::forRange(-40.0f, 85.0f, 8);
+
+    uint8_t frame[6];
+    BitPacker packer(frame, sizeof(frame));
+    TEST_ASSERT_TRUE(packer.write(accel, 1.5f));
+    TEST_ASSERT_TRUE(packer.write(accel, -9.81f));
+    TEST_ASSERT_TRUE(packer.write(accel, 42.0f));
+    TEST_ASSERT_TRUE(packer.write(temperature, 21.5f));
+    TEST_ASSERT_EQUAL(6, packer.getSize());
+    TEST_ASSERT_FALSE(packer.write(temperature, 0.0f));
+    TEST_ASSERT_FALSE(packer.ok());
+
+    BitUnpacker unpacker(frame, sizeof(frame));
+    float x, y, z, t;
+    TEST_ASSERT_TRUE(unpacker.read(accel, x));
+    TEST_ASSERT_TRUE(unpacker.read(accel, y));
+    TEST_ASSERT_TRUE(unpacker.read(accel, z));
+    TEST_ASSERT_TRUE(unpacker.read(temperature, t));
+    TEST_ASSERT_FLOAT_WITHIN(accel.scale, 1.5f, x);
+    TEST_ASSERT_FLOAT_WITHIN(accel.scale, -9.81f, y);
+    TEST_ASSERT_FLOAT_WITHIN(accel.scale, 42.0f, z);
+    TEST_ASSERT_FLOAT_WITHIN(temperature.scale, 21.5f, t);
+    uint32_t code;
+    TEST_ASSERT_TRUE(unpacker.read(code, 4));   // padding up to the byte boundary
+    TEST_ASSERT_FALSE(unpacker.read(code, 1));
+}
+
+void test_simulated_flight_log_size_and_error(void) {
+    QuantizationTable<4> table;
+    const QuantizationDescriptor accel = QuantizationDescriptor::forRange(-160.0f, 160.0f, 16);
+    const QuantizationDescriptor altitude = QuantizationDescriptor::forRange(-500.0f, 12000.0f, 16);
+    table.set(ACCELEROMETER_Z, accel);
+    table.set(ALTITUDE, altitude);
+
+    SimpleSimulator sim(5000, 60.0f, 3000, 10);
+    std::default_random_engine rng(5);
+    std::normal_distribution<float> noise(0.0f, 0.5f);
+    std::vector<uint8_t> log;
+    std::vector<float> truth;
+    uint8_t record[quantized_record::MAX_SIZE];
+    std::size_t records = 0;
+    while (!sim.getHasLanded() && sim.getCurrentTime() < 200000) {
+        sim.tick();
+        const float values[2] = {sim.getIntertialVerticalAcl() + 9.81f + noise(rng), sim.getAltitude() + noise(rng)};
+        const uint8_t names[2] = {ACCELEROMETER_Z, ALTITUDE};
+        for (int i = 0; i < 2; i++) {
+            const std::size_t n = quantized_record::encode(table, names[i], values[i], record);
+            log.insert(log.end(), record, record + n);
+            truth.push_back(values[i]);
+            records++;
+        }
+    }
+
+    float worstAccel = 0.0f;
+    float worstAltitude = 0.0f;
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < records; i++) {
+        uint8_t name;
+        float value;
+        const std::size_t n = quantized_record::decode(table, log.data() + offset, log.size() - offset, name, value);
+        TEST_ASSERT_EQUAL(quantized_record::QUANTIZED_SIZE, n);
+        offset += n;
+        const float error = std::fabs(value - truth[i]);
+        if (name == ACCELEROMETER_Z) {
+            worstAccel = std::max(worstAccel, error);
+        } else {
+            worstAltitude = std::max(worstAltitude, error);
+        }
+    }
+    std::cout << records << " records: " << log.size() << " B quantized vs "
+              << records * quantized_record::FULL_SIZE << " B as Record_t; worst error accel "
+              << worstAccel << " m/s^2, altitude " << worstAltitude << " m\n";
+    TEST_ASSERT_EQUAL(log.size(), offset);
+    TEST_ASSERT_TRUE(worstAccel <= accel.scale * 0.5f + 1e-3f);
+    TEST_ASSERT_TRUE(worstAltitude <= altitude.scale * 0.5f + 1e-2f);
+    TEST_ASSERT_EQUAL(records * 3, log.size());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_descriptor_round_trip_error_is_half_a_step);
+    RUN_TEST(test_out_of_range_clamps_and_nan_survives);
+    RUN_TEST(test_records_fall_back_to_full_precision);
+    RUN_TEST(test_bit_packed_telemetry_frame);
+    RUN_TEST(test_simulated_flight_log_size_and_error);
+    return UNITY_END();
+}
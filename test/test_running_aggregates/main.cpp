@@ -0,0 +1,211 @@
+#include "unity.h"
+#include "RunningAggregates.h"
+#include "SizedCircularArray.h"
+#include "data_handling/DataPoint.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+void test_empty_window(void) {
+    AggregatingCircularArray<float, 5> window(5);
+    TEST_ASSERT_EQUAL(0, window.getCount());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.getSum());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.getMean());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.getVariance());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.getMin());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.getMax());
+}
+
+void test_no_aggregates_costs_nothing(void) {
+    // The default policy is an empty base and does not grow the array
+    TEST_ASSERT_EQUAL(8, sizeof(SizedCircularArray<uint8_t, 5>));
+}
+
+void test_sliding_window_values(void) {
+    AggregatingCircularArray<int, 3> window(3);
+    window.push(4);
+    window.push(8);
+    TEST_ASSERT_EQUAL(2, window.getCount());
+    TEST_ASSERT_EQUAL_FLOAT(12.0f, window.getSum());
+    TEST_ASSERT_EQUAL_FLOAT(6.0f, window.getMean());
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, window.getVariance());
+    TEST_ASSERT_EQUAL(4, window.getMin());
+    TEST_ASSERT_EQUAL(8, window.getMax());
+
+    window.push(6);  // 4, 8, 6
+    window.push(1);  // 8, 6, 1 - the old min fell out but a new one came in
+    TEST_ASSERT_EQUAL(3, window.getCount());
+    TEST_ASSERT_EQUAL_FLOAT(15.0f, window.getSum());
+    TEST_ASSERT_EQUAL(1, window.getMin());
+    TEST_ASSERT_EQUAL(8, window.getMax());
+
+    window.push(2);  // 6, 1, 2 - the max fell out
+    TEST_ASSERT_EQUAL(6, window.getMax());
+    window.push(3);  // 1, 2, 3
+    TEST_ASSERT_EQUAL(3, window.getMax());
+    TEST_ASSERT_EQUAL(1, window.getMin());
+    window.push(3);  // 2, 3, 3
+    TEST_ASSERT_EQUAL(2, window.getMin());
+    TEST_ASSERT_EQUAL_FLOAT(8.0f / 3.0f, window.getMean());
+}
+
+void test_clear_resets_aggregates(void) {
+    AggregatingCircularArray<float, 4> window(4);
+    for (int i = 0; i < 10; i++) {
+        window.push(static_cast<float>(i));
+    }
+    window.clear();
+    TEST_ASSERT_EQUAL(0, window.getCount());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.getSum());
+    window.push(-2.0f);
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, window.getMin());
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, window.getMax());
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, window.getMean());
+}
+
+// Compare against a brute-force scan of the window at every step
+void test_matches_full_scan_for_datapoints(void) {
+    const uint8_t windowSize = 50;
+    AggregatingCircularArray<DataPoint, 64> window(windowSize);
+    std::mt19937 gen(11);
+    std::normal_distribution<float> dist(250.0f, 3.0f);
+    for (uint32_t i = 0; i < 3000; i++) {
+        window.push(DataPoint(i * 10, dist(gen)));
+
+        std::size_t n = std::min<std::size_t>(i + 1, windowSize);
+        double sum = 0.0;
+        float lo = window.getFromHead(0).data;
+        float hi = lo;
+        for (std::size_t k = 0; k < n; k++) {
+            float v = window.getFromHead(static_cast<uint8_t>(k)).data;
+            sum += v;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        double mean = sum / n;
+        double sq = 0.0;
+        for (std::size_t k = 0; k < n; k++) {
+            double d = window.getFromHead(static_cast<uint8_t>(k)).data - mean;
+            sq += d * d;
+        }
+
+        TEST_ASSERT_EQUAL(n, window.getCount());
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, mean, window.getMean());
+        TEST_ASSERT_FLOAT_WITHIN(1e-2, sq / n, window.getVariance());
+        TEST_ASSERT_EQUAL_FLOAT(lo, window.getMin());
+        TEST_ASSERT_EQUAL_FLOAT(hi, window.getMax());
+    }
+}
+
+void test_non_finite_sample_leaves_with_the_window(void) {
+    AggregatingCircularArray<float, 4> window(3);
+    window.push(1.0f);
+    window.push(NAN);
+    window.push(2.0f);
+    TEST_ASSERT_TRUE(std::isnan(window.getMean()));
+    window.push(3.0f);
+    window.push(4.0f);  // 2, 3, 4 - the NaN is gone and so is its effect
+    TEST_ASSERT_EQUAL_FLOAT(9.0f, window.getSum());
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, window.getMean());
+    TEST_ASSERT_EQUAL_FLOAT(2.0f / 3.0f, window.getVariance());
+
+    window.push(INFINITY);
+    TEST_ASSERT_TRUE(std::isinf(window.getMean()));
+    window.push(5.0f);
+    window.push(6.0f);
+    window.push(7.0f);
+    TEST_ASSERT_EQUAL_FLOAT(6.0f, window.getMean());
+    TEST_ASSERT_EQUAL_FLOAT(2.0f / 3.0f, window.getVariance());
+}
+
+// Barometer-sized offset with a small spread, over a long run
+void test_large_offset_variance_stays_accurate(void) {
+    const uint16_t windowSize = 500;
+    static AggregatingCircularArray<float, windowSize> window(windowSize);
+    std::mt19937 gen(5);
+    std::normal_distribution<float> dist(101325.0f, 0.5f);
+    for (int i = 0; i < 200000; i++) {
+        window.push(dist(gen));
+    }
+    double sum = 0.0;
+    for (uint16_t k = 0; k < windowSize; k++) {
+        sum += window.getFromHead(k);
+    }
+    const double mean = sum / windowSize;
+    double sq = 0.0;
+    for (uint16_t k = 0; k < windowSize; k++) {
+        const double d = window.getFromHead(k) - mean;
+        sq += d * d;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, window.getMean() - mean);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, window.getVariance() - sq / windowSize);
+}
+
+// -----------------------------------------------------------------------------
+// Benchmark: mean + min + max per tick, scanned vs. running
+// -----------------------------------------------------------------------------
+void test_benchmark_aggregates(void) {
+    const int count = 20000;
+    const uint8_t windowSize = 200;
+    static float samples[count];
+    std::mt19937 gen(3);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    for (int i = 0; i < count; i++) {
+        samples[i] = dist(gen);
+    }
+
+    SizedCircularArray<float, windowSize> plain(windowSize);
+    volatile float sink = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        plain.push(samples[i]);
+        float sum = 0.0f;
+        float lo = plain.getFromHead(0);
+        float hi = lo;
+        for (uint8_t k = 0; k < plain.getSize(); k++) {
+            float v = plain.getFromHead(k);
+            sum += v;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        sink = sum / plain.getSize() + lo + hi;
+    }
+    auto mid = std::chrono::steady_clock::now();
+
+    AggregatingCircularArray<float, windowSize> running(windowSize);
+    for (int i = 0; i < count; i++) {
+        running.push(samples[i]);
+        sink = static_cast<float>(running.getMean()) + running.getMin() + running.getMax();
+    }
+    auto end = std::chrono::steady_clock::now();
+    (void)sink;
+
+    double scanNs = std::chrono::duration<double, std::nano>(mid - start).count() / count;
+    double runningNs = std::chrono::duration<double, std::nano>(end - mid).count() / count;
+    std::cout << "Aggregate benchmark, window " << static_cast<int>(windowSize)
+              << ": scan " << scanNs << " ns/tick, running " << runningNs << " ns/tick\n";
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_window);
+    RUN_TEST(test_no_aggregates_costs_nothing);
+    RUN_TEST(test_sliding_window_values);
+    RUN_TEST(test_clear_resets_aggregates);
+    RUN_TEST(test_matches_full_scan_for_datapoints);
+    RUN_TEST(test_non_finite_sample_leaves_with_the_window);
+    RUN_TEST(test_large_offset_variance_stays_accurate);
+    RUN_TEST(test_benchmark_aggregates);
+    return UNITY_END();
+}
@@ -0,0 +1,205 @@
+#include "unity.h"
+#include "SensorDataHandlerT.h"
+#include "BatchSensorDataHandler.h"
+#include "data_handling/SensorDataHandler.h"
+#include "data_handling/DataPoint.h"
+#include "data_handling/DataSaver.h"
+#include "ArduinoHAL.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLE_COUNTER 1
+#endif
+
+MockSerial Serial;
+
+void setUp(void) {
+    Serial.clear();
+}
+
+void tearDown(void) {
+    Serial.clear();
+}
+
+// ---------------------------------------------------------------------
+// Mock savers
+// ---------------------------------------------------------------------
+
+class MockDataSaver : public IDataSaver {
+public:
+    struct SavedRecord {
+        DataPoint data;
+        uint8_t sensorName;
+    };
+
+    std::vector<SavedRecord> savedRecords;
+    int status = 0;
+
+    virtual int saveDataPoint(const DataPoint& data, uint8_t sensorName) override {
+        SavedRecord record = { data, sensorName };
+        savedRecords.push_back(record);
+        return status;
+    }
+};
+
+// Not an IDataSaver at all: the template only needs saveDataPoint()
+struct PlainSaver {
+    uint32_t checksum = 0;
+    uint32_t saved = 0;
+
+    int saveDataPoint(const DataPoint& data, uint8_t name) {
+        checksum += data.timestamp_ms ^ name;
+        saved++;
+        return 0;
+    }
+};
+
+// The same work behind a virtual call, for the runtime handler
+class VirtualSaver : public IBatchDataSaver {
+public:
+    uint32_t checksum = 0;
+    uint32_t saved = 0;
+
+    virtual int saveDataPoint(const DataPoint& data, uint8_t name) override {
+        checksum += data.timestamp_ms ^ name;
+        saved++;
+        return 0;
+    }
+};
+
+// ---------------------------------------------------------------------
+// Test Cases
+// ---------------------------------------------------------------------
+
+void test_same_samples_as_runtime_handler(void) {
+    const uint16_t intervals[] = {0, 1, 20, 50};
+    for (uint16_t interval : intervals) {
+        MockDataSaver reference;
+        SensorDataHandler runtime(4, &reference);
+        runtime.restrictSaveSpeed(interval);
+
+        MockDataSaver saver;
+        SensorDataHandlerT<MockDataSaver, 4> handler(saver);
+        handler.restrictSaveSpeed(interval);
+
+        uint32_t t = 1000;
+        uint32_t seed = 99;
+        for (int i = 0; i < 3000; i++) {
+            seed = seed * 1103515245U + 12345U;
+            t += (seed >> 16) % 5;
+            const DataPoint dp(t, static_cast<float>(i));
+            runtime.addData(dp);
+            handler.addData(dp);
+        }
+
+        TEST_ASSERT_EQUAL(reference.savedRecords.size(), saver.savedRecords.size());
+        for (std::size_t i = 0; i < saver.savedRecords.size(); i++) {
+            TEST_ASSERT_EQUAL(reference.savedRecords[i].data.timestamp_ms, saver.savedRecords[i].data.timestamp_ms);
+            TEST_ASSERT_EQUAL_UINT8(4, saver.savedRecords[i].sensorName);
+        }
+    }
+}
+
+void test_block_add_and_policy_options(void) {
+    MockDataSaver saver;
+    SensorDataHandlerT<MockDataSaver, 12> handler(saver);
+    TEST_ASSERT_EQUAL_UINT8(12, handler.getName());
+    handler.restrictSaveSpeed(3);
+    handler.setDecimationMode(DECIMATE_AVERAGE);
+
+    DataPoint fifo[9];
+    for (uint32_t t = 100; t <= 108; t++) {
+        fifo[t - 100] = DataPoint(t, static_cast<float>(t - 100));
+    }
+    TEST_ASSERT_EQUAL(0, handler.addData(fifo, 9));
+    TEST_ASSERT_EQUAL(3, saver.savedRecords.size());
+    TEST_ASSERT_EQUAL_FLOAT(2.5f, saver.savedRecords[1].data.data);
+    TEST_ASSERT_EQUAL_FLOAT(6.5f, saver.savedRecords[2].data.data);
+
+    handler.setDecimationMode(DECIMATE_DROP);
+    handler.setDeadband(1.0f, 1000);
+    saver.status = -2;
+    TEST_ASSERT_EQUAL(0, handler.addData(DataPoint(120, 7.0f)));   // inside the deadband of 6.5
+    TEST_ASSERT_EQUAL(-2, handler.addData(DataPoint(130, 9.0f)));
+    TEST_ASSERT_EQUAL(4, saver.savedRecords.size());
+}
+
+void test_plain_saver_without_interface(void) {
+    PlainSaver saver;
+    SensorDataHandlerT<PlainSaver, 1> handler(saver);
+    for (uint32_t t = 1; t <= 10; t++) {
+        handler.addData(DataPoint(t, 0.0f));
+    }
+    TEST_ASSERT_EQUAL(10, saver.saved);
+    // The name is a template constant, so it takes no storage
+    TEST_ASSERT_TRUE(sizeof(handler) <= sizeof(BatchSensorDataHandler));
+}
+
+// ---------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------
+
+static uint64_t readCounter() {
+#ifdef HAVE_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+template <typename Handler>
+static uint64_t timeAddData(Handler& handler, int samples) {
+    const uint64_t start = readCounter();
+    for (int i = 0; i < samples; i++) {
+        handler.addData(DataPoint(static_cast<uint32_t>(i + 1), 1.0f));
+    }
+    return readCounter() - start;
+}
+
+void test_benchmark_static_vs_virtual_dispatch(void) {
+    const int samples = 2000000;
+
+    // Hide the dynamic type, as a separately compiled handler would see it
+    VirtualSaver virtualSaver;
+    IDataSaver* volatile opaque = &virtualSaver;
+    SensorDataHandler runtime(1, opaque);
+
+    VirtualSaver batchSaver;
+    IBatchDataSaver* volatile opaqueBatch = &batchSaver;
+    BatchSensorDataHandler batch(1, opaqueBatch);
+
+    PlainSaver plainSaver;
+    SensorDataHandlerT<PlainSaver, 1> compileTime(plainSaver);
+
+    const uint64_t runtimeTicks = timeAddData(runtime, samples);
+    const uint64_t batchTicks = timeAddData(batch, samples);
+    const uint64_t staticTicks = timeAddData(compileTime, samples);
+
+#ifdef HAVE_CYCLE_COUNTER
+    const char* unit = " TSC cycles";
+#else
+    const char* unit = " ns";
+#endif
+    std::cout << "addData per sample: SensorDataHandler "
+              << static_cast<double>(runtimeTicks) / samples << unit << ", BatchSensorDataHandler "
+              << static_cast<double>(batchTicks) / samples << unit << ", SensorDataHandlerT "
+              << static_cast<double>(staticTicks) / samples << unit << "\n";
+
+    TEST_ASSERT_EQUAL(virtualSaver.saved, plainSaver.saved);
+    TEST_ASSERT_EQUAL(virtualSaver.checksum, plainSaver.checksum);
+    TEST_ASSERT_EQUAL(batchSaver.checksum, plainSaver.checksum);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_samples_as_runtime_handler);
+    RUN_TEST(test_block_add_and_policy_options);
+    RUN_TEST(test_plain_saver_without_interface);
+    RUN_TEST(test_benchmark_static_vs_virtual_dispatch);
+    return UNITY_END();
+}
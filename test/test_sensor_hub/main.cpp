@@ -0,0 +1,172 @@
+#include "unity.h"
+#include "SensorHub.h"
+#include "BatchSensorDataHandler.h"
+#include "data_handling/DataPoint.h"
+
+#include <cmath>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+static const uint8_t ACCEL_Z = 3;
+static const uint8_t ALTITUDE = 7;
+
+void test_hold_channel_uses_latest_sample(void) {
+    SensorHub<2> hub;
+    hub.setAlignMode(1, ALIGN_HOLD);
+    SensorFrame<2> frame;
+    TEST_ASSERT_FALSE(hub.getFrame(frame));
+
+    hub.addSample(1, DataPoint(95, 100.0f));
+    hub.addSample(0, DataPoint(100, 9.8f));
+    hub.addSample(0, DataPoint(110, 9.9f));
+    hub.addSample(1, DataPoint(115, 120.0f));
+    hub.addSample(0, DataPoint(120, 10.0f));
+
+    TEST_ASSERT_TRUE(hub.getFrame(frame));
+    TEST_ASSERT_EQUAL(100, frame.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(9.8f, frame.values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, frame.values[1]);
+    TEST_ASSERT_EQUAL(5, frame.staleness_ms[1]);
+    TEST_ASSERT_EQUAL(3, frame.validMask);
+
+    TEST_ASSERT_TRUE(hub.getFrame(frame));
+    TEST_ASSERT_EQUAL(110, frame.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, frame.values[1]);
+    TEST_ASSERT_EQUAL(15, frame.staleness_ms[1]);
+
+    TEST_ASSERT_TRUE(hub.getFrame(frame));
+    TEST_ASSERT_EQUAL(120, frame.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(120.0f, frame.values[1]);
+    TEST_ASSERT_EQUAL(5, frame.staleness_ms[1]);
+    TEST_ASSERT_FALSE(hub.getFrame(frame));
+}
+
+void test_interpolated_channel_waits_for_next_sample(void) {
+    SensorHub<2> hub;
+    hub.setAlignMode(1, ALIGN_INTERPOLATE);
+    SensorFrame<2> frame;
+
+    hub.addSample(1, DataPoint(100, 0.0f));
+    hub.addSample(0, DataPoint(105, 1.0f));
+    hub.addSample(0, DataPoint(110, 1.0f));
+    // No baro sample after 105 yet
+    TEST_ASSERT_FALSE(hub.getFrame(frame));
+    TEST_ASSERT_EQUAL(2, hub.getPendingFrames());
+
+    hub.addSample(1, DataPoint(120, 40.0f));
+    TEST_ASSERT_TRUE(hub.getFrame(frame));
+    TEST_ASSERT_EQUAL(105, frame.timestamp_ms);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, frame.values[1]);
+    TEST_ASSERT_EQUAL(0, frame.staleness_ms[1]);
+    TEST_ASSERT_TRUE(hub.getFrame(frame));
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, frame.values[1]);
+    TEST_ASSERT_FALSE(hub.getFrame(frame));
+}
+
+void test_missing_channel_and_stalled_channel(void) {
+    SensorHub<3, 4> hub;
+    hub.setAlignMode(1, ALIGN_INTERPOLATE);
+    SensorFrame<3> frame;
+
+    // Channel 1 stalls after one sample and channel 2 never reports
+    hub.addSample(1, DataPoint(0, 5.0f));
+    for (uint32_t t = 10; t <= 40; t += 10) {
+        hub.addSample(0, DataPoint(t, 1.0f));
+    }
+    // The queue is full, so the oldest frame is released with a hold
+    TEST_ASSERT_TRUE(hub.getFrame(frame));
+    TEST_ASSERT_EQUAL(10, frame.timestamp_ms);
+    TEST_ASSERT_TRUE(frame.isValid(0));
+    TEST_ASSERT_TRUE(frame.isValid(1));
+    TEST_ASSERT_FALSE(frame.isValid(2));
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, frame.values[1]);
+    TEST_ASSERT_EQUAL(10, frame.staleness_ms[1]);
+    TEST_ASSERT_FALSE(hub.getFrame(frame));
+
+    // Not draining loses frames, and says so
+    for (uint32_t t = 50; t <= 100; t += 10) {
+        hub.addSample(0, DataPoint(t, 1.0f));
+    }
+    TEST_ASSERT_EQUAL(4, hub.getPendingFrames());
+    TEST_ASSERT_EQUAL(5, hub.getOverrunCount());
+
+    // Out-of-order samples are rejected
+    TEST_ASSERT_FALSE(hub.addSample(0, DataPoint(90, 1.0f)));
+    TEST_ASSERT_FALSE(hub.addSample(3, DataPoint(200, 1.0f)));
+}
+
+void test_channel_newer_than_frame_is_not_valid(void) {
+    SensorHub<3, 64, 2> hub;
+    hub.setAlignMode(2, ALIGN_INTERPOLATE);
+    SensorFrame<3> frame;
+
+    // Channel 1 only starts reporting after the frame
+    hub.addSample(2, DataPoint(95, 0.0f));
+    hub.addSample(0, DataPoint(100, 1.0f));
+    hub.addSample(1, DataPoint(105, 50.0f));
+    // Channel 1 runs fast enough while the frame waits to push 105 out of its history
+    hub.addSample(1, DataPoint(106, 51.0f));
+    hub.addSample(1, DataPoint(107, 52.0f));
+    hub.addSample(2, DataPoint(105, 10.0f));
+
+    TEST_ASSERT_TRUE(hub.getFrame(frame));
+    TEST_ASSERT_EQUAL(100, frame.timestamp_ms);
+    TEST_ASSERT_TRUE(frame.isValid(0));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, frame.values[0]);
+    TEST_ASSERT_FALSE(frame.isValid(1));
+    TEST_ASSERT_TRUE(frame.isValid(2));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 5.0f, frame.values[2]);
+}
+
+void test_handlers_feed_the_hub_at_imu_rate(void) {
+    // IMU at 1 kHz, baro at ~40 Hz with jitter, altitude climbing at 100 m/s
+    SensorHub<2> hub;
+    hub.bindSensor(0, ACCEL_Z, ALIGN_HOLD);
+    hub.bindSensor(1, ALTITUDE, ALIGN_INTERPOLATE);
+    BatchSensorDataHandler imuHandler(ACCEL_Z, &hub);
+    BatchSensorDataHandler baroHandler(ALTITUDE, &hub);
+    TEST_ASSERT_EQUAL(-1, hub.saveDataPoint(DataPoint(0, 0.0f), 99));
+
+    std::vector<SensorFrame<2> > frames;
+    SensorFrame<2> frame;
+    uint32_t nextBaro = 1;
+    uint32_t seed = 1;
+    for (uint32_t t = 1; t <= 2000; t++) {
+        imuHandler.addData(DataPoint(t, 30.0f));
+        if (t == nextBaro) {
+            baroHandler.addData(DataPoint(t, 0.1f * static_cast<float>(t)));
+            seed = seed * 1103515245U + 12345U;
+            nextBaro += 20 + (seed >> 16) % 11;  // 20-30 ms
+        }
+        while (hub.getFrame(frame)) {
+            frames.push_back(frame);
+        }
+    }
+
+    // One frame per IMU sample, except the ones still waiting for the next baro sample
+    TEST_ASSERT_TRUE(frames.size() > 1960);
+    TEST_ASSERT_EQUAL(0, hub.getOverrunCount());
+    for (std::size_t i = 0; i < frames.size(); i++) {
+        TEST_ASSERT_EQUAL(i + 1, frames[i].timestamp_ms);
+        TEST_ASSERT_EQUAL_FLOAT(30.0f, frames[i].values[0]);
+        // Linear altitude is recovered exactly at every IMU tick
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.1f * static_cast<float>(frames[i].timestamp_ms), frames[i].values[1]);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hold_channel_uses_latest_sample);
+    RUN_TEST(test_interpolated_channel_waits_for_next_sample);
+    RUN_TEST(test_missing_channel_and_stalled_channel);
+    RUN_TEST(test_channel_newer_than_frame_is_not_valid);
+    RUN_TEST(test_handlers_feed_the_hub_at_imu_rate);
+    return UNITY_END();
+}
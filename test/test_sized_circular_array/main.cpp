@@ -0,0 +1,140 @@
+#include "unity.h"
+#include "SizedCircularArray.h"
+#include "MedianCircularArray.h"
+#include "CircularIndex.h"
+#include "data_handling/CircularArray.h"
+#include "data_handling/DataPoint.h"
+
+#include <random>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+void test_index_type_follows_capacity(void) {
+    TEST_ASSERT_EQUAL(1, sizeof(CircularIndex<5>::type));
+    TEST_ASSERT_EQUAL(1, sizeof(CircularIndex<MAX_CIRCULAR_ARRAY_CAPACITY>::type));
+    TEST_ASSERT_EQUAL(2, sizeof(CircularIndex<256>::type));
+    TEST_ASSERT_EQUAL(2, sizeof(CircularIndex<65535>::type));
+    TEST_ASSERT_EQUAL(4, sizeof(CircularIndex<65536>::type));
+
+    TEST_ASSERT_EQUAL(1, sizeof(SizedCircularArray<int, 10>::index_type));
+    TEST_ASSERT_EQUAL(2, sizeof(SizedCircularArray<int, 1000>::index_type));
+    TEST_ASSERT_EQUAL(4, sizeof(SizedCircularArray<int, 100000>::index_type));
+}
+
+void test_small_windows_keep_their_footprint(void) {
+    // A byte window is 5 bytes of data + 3 one-byte indices, like CircularArray
+    TEST_ASSERT_EQUAL(8, sizeof(SizedCircularArray<uint8_t, 5>));
+    // DataPoint windows only add the 3 index bytes, rounded up to DataPoint's alignment
+    const std::size_t indexBytes = (3 + alignof(DataPoint) - 1) / alignof(DataPoint) * alignof(DataPoint);
+    TEST_ASSERT_EQUAL(5 * sizeof(DataPoint) + indexBytes,
+                      sizeof(SizedCircularArray<DataPoint, 5>));
+    TEST_ASSERT_EQUAL(MAX_CIRCULAR_ARRAY_CAPACITY * sizeof(DataPoint) + indexBytes,
+                      sizeof(SizedCircularArray<DataPoint, MAX_CIRCULAR_ARRAY_CAPACITY>));
+}
+
+void test_explicit_index_type(void) {
+    // Wider indices can still be requested explicitly
+    SizedCircularArray<int, 5, uint32_t> circularArray(5);
+    TEST_ASSERT_EQUAL(4, sizeof(circularArray.getHead()));
+    for (int i = 0; i < 12; i++) {
+        circularArray.push(i);
+    }
+    TEST_ASSERT_EQUAL(11, circularArray.getFromHead(0));
+    TEST_ASSERT_EQUAL(7, circularArray.getFromHead(4));
+}
+
+void test_behaves_like_circular_array(void) {
+    SizedCircularArray<int, 5> circularArray(5);
+    TEST_ASSERT_EQUAL(5, circularArray.getMaxSize());
+    TEST_ASSERT_FALSE(circularArray.isFull());
+    TEST_ASSERT_EQUAL(0, circularArray.getHead());
+    circularArray.push(1);
+    TEST_ASSERT_EQUAL(0, circularArray.getHead());
+    circularArray.push(2);
+    TEST_ASSERT_EQUAL(1, circularArray.getHead());
+    circularArray.push(3);
+    circularArray.push(4);
+    circularArray.push(5);
+    TEST_ASSERT_EQUAL(5, circularArray.getFromHead(0));
+    TEST_ASSERT_EQUAL(1, circularArray.getFromHead(4));
+    TEST_ASSERT_TRUE(circularArray.isFull());
+    TEST_ASSERT_EQUAL(3, circularArray.getMedian());
+    circularArray.push(6);
+    TEST_ASSERT_EQUAL(4, circularArray.getMedian());
+
+    circularArray.clear();
+    TEST_ASSERT_FALSE(circularArray.isFull());
+    TEST_ASSERT_EQUAL(0, circularArray.getHead());
+    TEST_ASSERT_EQUAL(0, circularArray.getMedian());
+}
+
+void test_beyond_255_elements(void) {
+    // 4 s of 1 kHz data, well past the old MAX_CIRCULAR_ARRAY_CAPACITY
+    const uint16_t windowSize = 4000;
+    static SizedCircularArray<DataPoint, windowSize> circularArray(windowSize);
+    TEST_ASSERT_EQUAL_UINT16(windowSize, circularArray.getMaxSize());
+    for (uint32_t i = 0; i < 10000; i++) {
+        circularArray.push(DataPoint(i, static_cast<float>(i)));
+        if (i + 1 < windowSize) {
+            TEST_ASSERT_FALSE(circularArray.isFull());
+        }
+    }
+    TEST_ASSERT_TRUE(circularArray.isFull());
+    TEST_ASSERT_EQUAL_UINT32(9999, circularArray.getFromHead(0).timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(6000, circularArray.getFromHead(windowSize - 1).timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT16(9999 % windowSize, circularArray.getHead());
+    // Window holds 6000..9999, median is at sorted index 2000
+    TEST_ASSERT_EQUAL_FLOAT(8000.0f, circularArray.getMedian().data);
+}
+
+void test_beyond_65535_elements(void) {
+    const uint32_t windowSize = 70000;
+    static SizedCircularArray<uint8_t, windowSize> circularArray(windowSize);
+    TEST_ASSERT_EQUAL(4, sizeof(circularArray.getMaxSize()));
+    for (uint32_t i = 0; i < windowSize + 10; i++) {
+        circularArray.push(static_cast<uint8_t>(i));
+    }
+    TEST_ASSERT_TRUE(circularArray.isFull());
+    TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(windowSize + 9), circularArray.getFromHead(0));
+    TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(10), circularArray.getFromHead(windowSize - 1));
+}
+
+void test_large_median_window(void) {
+    const uint16_t windowSize = 1000;
+    static MedianCircularArray<float, windowSize> medianArray(windowSize);
+    static SizedCircularArray<float, windowSize> reference(windowSize);
+    TEST_ASSERT_EQUAL(2, sizeof(medianArray.getHead()));
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, 400);
+    for (int i = 0; i < 5000; i++) {
+        float value = static_cast<float>(dist(gen));
+        medianArray.push(value);
+        reference.push(value);
+        if (i % 97 == 0) {
+            TEST_ASSERT_EQUAL_FLOAT(reference.getMedian(), medianArray.getMedian());
+        }
+    }
+    TEST_ASSERT_EQUAL_FLOAT(reference.getMedian(), medianArray.getMedian());
+
+    // The same selection in a caller-owned buffer, as flight code does for large windows
+    static float scratch[windowSize];
+    TEST_ASSERT_EQUAL_FLOAT(medianArray.getMedian(), reference.getMedian(scratch));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_index_type_follows_capacity);
+    RUN_TEST(test_small_windows_keep_their_footprint);
+    RUN_TEST(test_explicit_index_type);
+    RUN_TEST(test_behaves_like_circular_array);
+    RUN_TEST(test_beyond_255_elements);
+    RUN_TEST(test_beyond_65535_elements);
+    RUN_TEST(test_large_median_window);
+    return UNITY_END();
+}
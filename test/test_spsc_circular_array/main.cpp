@@ -0,0 +1,159 @@
+#include "unity.h"
+#include "SpscCircularArray.h"
+#include "data_handling/DataPoint.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+void test_push_pop_fifo_order(void) {
+    SpscCircularArray<int, 4> ring;
+    TEST_ASSERT_TRUE(ring.isEmpty());
+    TEST_ASSERT_EQUAL(4, ring.getMaxSize());
+
+    int out = -1;
+    TEST_ASSERT_FALSE(ring.pop(out));
+    TEST_ASSERT_EQUAL(-1, out);
+
+    TEST_ASSERT_TRUE(ring.push(1));
+    TEST_ASSERT_TRUE(ring.push(2));
+    TEST_ASSERT_TRUE(ring.push(3));
+    TEST_ASSERT_EQUAL(3, ring.getSize());
+
+    TEST_ASSERT_TRUE(ring.pop(out));
+    TEST_ASSERT_EQUAL(1, out);
+    TEST_ASSERT_TRUE(ring.pop(out));
+    TEST_ASSERT_EQUAL(2, out);
+    TEST_ASSERT_EQUAL(1, ring.getSize());
+}
+
+void test_full_ring_drops_instead_of_overwriting(void) {
+    SpscCircularArray<int, 4> ring;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(ring.push(i));
+    }
+    TEST_ASSERT_TRUE(ring.isFull());
+    TEST_ASSERT_FALSE(ring.push(99));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.getDroppedCount());
+
+    int out = -1;
+    TEST_ASSERT_TRUE(ring.pop(out));
+    TEST_ASSERT_EQUAL(0, out); // the oldest value survived
+    TEST_ASSERT_TRUE(ring.push(4));
+    TEST_ASSERT_EQUAL(4, ring.getFromHead(0));
+}
+
+void test_get_from_head(void) {
+    SpscCircularArray<DataPoint, 8> ring;
+    for (uint32_t i = 0; i < 20; i++) {
+        ring.push(DataPoint(i, static_cast<float>(i)));
+        DataPoint drained;
+        if (ring.getSize() > 5) {
+            ring.pop(drained);
+        }
+    }
+    TEST_ASSERT_EQUAL(5, ring.getSize());
+    TEST_ASSERT_EQUAL_UINT32(19, ring.getFromHead(0).timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(15, ring.getFromHead(4).timestamp_ms);
+    // Popped values are no longer visible
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getFromHead(5).timestamp_ms);
+
+    ring.clear();
+    TEST_ASSERT_TRUE(ring.isEmpty());
+}
+
+void test_counters_wrap(void) {
+    // Run enough traffic through a tiny ring to exercise slot reuse many times
+    SpscCircularArray<uint32_t, 2> ring;
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < 100000; i++) {
+        TEST_ASSERT_TRUE(ring.push(i));
+        TEST_ASSERT_TRUE(ring.pop(out));
+        TEST_ASSERT_EQUAL_UINT32(i, out);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Two threads: a "sensor" thread producing DataPoints and a "main loop" thread
+// draining them. Every sample must arrive exactly once and in order.
+// -----------------------------------------------------------------------------
+static const uint32_t kStressSamples = 2000000;
+
+template <std::size_t Capacity>
+double runProducerConsumer(uint32_t samples, uint32_t& errors, uint32_t& received) {
+    static SpscCircularArray<DataPoint, Capacity> ring;
+    ring.clear();
+    errors = 0;
+    received = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([samples]() {
+        for (uint32_t i = 0; i < samples; i++) {
+            DataPoint dp(i, static_cast<float>(i) * 0.5f);
+            while (!ring.push(dp)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::thread consumer([samples, &errors, &received]() {
+        uint32_t expected = 0;
+        DataPoint dp;
+        while (expected < samples) {
+            if (!ring.pop(dp)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (dp.timestamp_ms != expected || dp.data != static_cast<float>(expected) * 0.5f) {
+                errors++;
+            }
+            expected++;
+            received++;
+        }
+    });
+    producer.join();
+    consumer.join();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void test_two_thread_stress(void) {
+    uint32_t errors = 0;
+    uint32_t received = 0;
+    runProducerConsumer<64>(kStressSamples, errors, received);
+    TEST_ASSERT_EQUAL_UINT32(kStressSamples, received);
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+
+    // A very small ring forces the producer to hit "full" constantly
+    runProducerConsumer<2>(kStressSamples / 10, errors, received);
+    TEST_ASSERT_EQUAL_UINT32(kStressSamples / 10, received);
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+}
+
+void test_benchmark_throughput(void) {
+    uint32_t errors = 0;
+    uint32_t received = 0;
+    double seconds = runProducerConsumer<256>(kStressSamples, errors, received);
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    std::cout << "SPSC throughput (capacity 256): "
+              << (received / seconds) / 1e6 << " M DataPoints/s across two threads\n";
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_pop_fifo_order);
+    RUN_TEST(test_full_ring_drops_instead_of_overwriting);
+    RUN_TEST(test_get_from_head);
+    RUN_TEST(test_counters_wrap);
+    RUN_TEST(test_two_thread_stress);
+    RUN_TEST(test_benchmark_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,215 @@
+#include "unity.h"
+#include "StateSnapshot.h"
+#include "MedianCircularArray.h"
+#include "RunningAggregates.h"
+#include "TimeWindowedArray.h"
+#include "P2QuantileEstimator.h"
+#include "SimpleSimulation.h"
+#include "data_handling/DataPoint.h"
+#include "../CSVMockData.h"
+
+#include <fstream>
+#include <random>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+// -----------------------------------------------------------------------------
+// The windowed estimator state a warm restart needs to bring back
+// -----------------------------------------------------------------------------
+struct EstimatorState {
+    MedianCircularArray<float, 100> acl2Median;            // launch-detector style median of |a|^2
+    AggregatingCircularArray<DataPoint, 50> altitudeWindow; // mean/min/max altitude
+    TimeWindowedArray<64> recentAccel;                      // last 250 ms of vertical accel
+    P2QuantileEstimator groundLevel;                        // median altitude over the whole hold
+
+    EstimatorState()
+        : acl2Median(100), altitudeWindow(50), recentAccel(250), groundLevel(0.5f) {}
+
+    void update(uint32_t t, float accel, float altitude) {
+        acl2Median.push(accel * accel);
+        altitudeWindow.push(DataPoint(t, altitude));
+        recentAccel.push(DataPoint(t, accel));
+        groundLevel.push(DataPoint(t, altitude));
+    }
+
+    std::size_t snapshot(uint8_t* buffer, std::size_t capacity) const {
+        SnapshotWriter writer(buffer, capacity);
+        saveCircularArray(writer, acl2Median);
+        saveCircularArray(writer, altitudeWindow);
+        saveCircularArray(writer, recentAccel);
+        groundLevel.save(writer);
+        return writer.finish();
+    }
+
+    bool restore(const uint8_t* buffer, std::size_t length) {
+        SnapshotReader reader(buffer, length);
+        return restoreCircularArray(reader, acl2Median) &&
+               restoreCircularArray(reader, altitudeWindow) &&
+               restoreCircularArray(reader, recentAccel) &&
+               groundLevel.restore(reader) &&
+               reader.atEnd();
+    }
+};
+
+struct Sample {
+    uint32_t t;
+    float accel;
+    float altitude;
+};
+
+// Replays the flight CSV if it has been downloaded into data/, otherwise a
+// noisy simulated flight, at 100 Hz.
+static std::vector<Sample> loadFlight() {
+    std::vector<Sample> samples;
+    const char* dataset = "data/data_transformed.csv";
+    if (std::ifstream(dataset).good()) {
+        CSVDataProvider provider(dataset, 100.0f);
+        while (provider.hasNextDataPoint()) {
+            SensorData data = provider.getNextDataPoint();
+            Sample s = {static_cast<uint32_t>(data.time), data.accelx, data.altitude};
+            samples.push_back(s);
+        }
+        return samples;
+    }
+
+    SimpleSimulator sim(5000, 60.0f, 3000, 10);
+    std::default_random_engine rng(42);
+    std::normal_distribution<float> aclNoise(0.0f, 0.55f);
+    std::normal_distribution<float> altNoise(0.0f, 3.0f);
+    while (!sim.getHasLanded() && sim.getCurrentTime() < 120000) {
+        sim.tick();
+        Sample s = {sim.getCurrentTime(),
+                    sim.getIntertialVerticalAcl() + 9.81f + aclNoise(rng),
+                    sim.getAltitude() + 250.0f + altNoise(rng)};
+        samples.push_back(s);
+    }
+    return samples;
+}
+
+void test_restore_mid_flight_gives_identical_outputs(void) {
+    std::vector<Sample> flight = loadFlight();
+    TEST_ASSERT_GREATER_THAN(1000, flight.size());
+
+    static EstimatorState original;
+    const std::size_t brownoutAt = flight.size() / 2;
+    for (std::size_t i = 0; i < brownoutAt; i++) {
+        original.update(flight[i].t, flight[i].accel, flight[i].altitude);
+    }
+
+    // Snapshot into a flash-page sized buffer
+    static uint8_t flashImage[4096];
+    std::size_t written = original.snapshot(flashImage, sizeof(flashImage));
+    TEST_ASSERT_GREATER_THAN(0, written);
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(flashImage), written);
+
+    // "Reboot": a fresh set of estimators restored from flash
+    static EstimatorState restored;
+    TEST_ASSERT_TRUE(restored.restore(flashImage, written));
+    TEST_ASSERT_TRUE(restored.acl2Median.isFull());
+
+    for (std::size_t i = brownoutAt; i < flight.size(); i++) {
+        original.update(flight[i].t, flight[i].accel, flight[i].altitude);
+        restored.update(flight[i].t, flight[i].accel, flight[i].altitude);
+
+        TEST_ASSERT_EQUAL_FLOAT(original.acl2Median.getMedian(), restored.acl2Median.getMedian());
+        TEST_ASSERT_EQUAL_FLOAT(original.altitudeWindow.getMean(), restored.altitudeWindow.getMean());
+        TEST_ASSERT_EQUAL_FLOAT(original.altitudeWindow.getMax(), restored.altitudeWindow.getMax());
+        TEST_ASSERT_EQUAL_FLOAT(original.recentAccel.getMedian().data, restored.recentAccel.getMedian().data);
+        TEST_ASSERT_EQUAL(original.recentAccel.getSize(), restored.recentAccel.getSize());
+        TEST_ASSERT_EQUAL_FLOAT(original.groundLevel.getQuantile(), restored.groundLevel.getQuantile());
+    }
+}
+
+void test_corrupted_snapshot_is_rejected(void) {
+    EstimatorState state;
+    for (uint32_t t = 0; t < 200; t++) {
+        state.update(t * 10, 9.81f, 250.0f + static_cast<float>(t % 7));
+    }
+    uint8_t image[4096];
+    std::size_t written = state.snapshot(image, sizeof(image));
+    TEST_ASSERT_GREATER_THAN(0, written);
+
+    // Flip one payload bit
+    image[written / 2] ^= 0x10;
+    EstimatorState restored;
+    TEST_ASSERT_FALSE(restored.restore(image, written));
+
+    // Erased flash (all 0xFF) is not a snapshot either
+    uint8_t erased[64];
+    for (std::size_t i = 0; i < sizeof(erased); i++) {
+        erased[i] = 0xFF;
+    }
+    TEST_ASSERT_FALSE(restored.restore(erased, sizeof(erased)));
+
+    // Truncated read-back
+    image[written / 2] ^= 0x10;
+    TEST_ASSERT_FALSE(restored.restore(image, written - 1));
+    TEST_ASSERT_TRUE(restored.restore(image, written));
+}
+
+void test_mismatched_window_is_rejected(void) {
+    SizedCircularArray<int, 8> small(4);
+    for (int i = 0; i < 6; i++) {
+        small.push(i);
+    }
+    uint8_t image[256];
+    SnapshotWriter writer(image, sizeof(image));
+    TEST_ASSERT_TRUE(saveCircularArray(writer, small));
+    std::size_t written = writer.finish();
+
+    SizedCircularArray<int, 8> larger(8);
+    larger.push(99);
+    SnapshotReader reader(image, written);
+    TEST_ASSERT_FALSE(restoreCircularArray(reader, larger));
+    // The array is left untouched
+    TEST_ASSERT_EQUAL(1, larger.getSize());
+    TEST_ASSERT_EQUAL(99, larger.getFromHead(0));
+}
+
+void test_short_window_payload_leaves_the_array_untouched(void) {
+    // A valid snapshot whose window claims five values but holds two
+    uint8_t image[256];
+    SnapshotWriter writer(image, sizeof(image));
+    const uint32_t maxSize = 8;
+    const uint32_t size = 5;
+    TEST_ASSERT_TRUE(writer.write(maxSize) && writer.write(size) && writer.write(1) && writer.write(2));
+    std::size_t written = writer.finish();
+
+    SizedCircularArray<int, 8> window(8);
+    window.push(42);
+    window.push(43);
+    SnapshotReader reader(image, written);
+    TEST_ASSERT_TRUE(reader.ok());
+    TEST_ASSERT_FALSE(restoreCircularArray(reader, window));
+    TEST_ASSERT_EQUAL(2, window.getSize());
+    TEST_ASSERT_EQUAL(43, window.getFromHead(0));
+    TEST_ASSERT_EQUAL(42, window.getFromHead(1));
+}
+
+void test_writer_overflow_is_reported(void) {
+    SizedCircularArray<int, 64> window(64);
+    for (int i = 0; i < 64; i++) {
+        window.push(i);
+    }
+    uint8_t image[64];
+    SnapshotWriter writer(image, sizeof(image));
+    TEST_ASSERT_FALSE(saveCircularArray(writer, window));
+    TEST_ASSERT_EQUAL(0, writer.finish());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_restore_mid_flight_gives_identical_outputs);
+    RUN_TEST(test_corrupted_snapshot_is_rejected);
+    RUN_TEST(test_mismatched_window_is_rejected);
+    RUN_TEST(test_short_window_payload_leaves_the_array_untouched);
+    RUN_TEST(test_writer_overflow_is_reported);
+    return UNITY_END();
+}
@@ -0,0 +1,133 @@
+#include "unity.h"
+#include "TimeWindowedArray.h"
+#include "data_handling/DataPoint.h"
+
+#include <random>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+void test_empty_state(void) {
+    TimeWindowedArray<16> window(100);
+    TEST_ASSERT_TRUE(window.isEmpty());
+    TEST_ASSERT_EQUAL(0, window.getSize());
+    TEST_ASSERT_EQUAL_UINT32(0, window.getSpan_ms());
+    TEST_ASSERT_FALSE(window.coversWindow(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.getMedian().data);
+    TEST_ASSERT_EQUAL_UINT32(100, window.getWindow_ms());
+}
+
+void test_evicts_by_age(void) {
+    TimeWindowedArray<16> window(100);
+    for (uint32_t t = 1000; t <= 1200; t += 10) {
+        TEST_ASSERT_TRUE(window.push(DataPoint(t, static_cast<float>(t))));
+    }
+    // Only samples with newest - t < 100 remain: 1110..1200
+    TEST_ASSERT_EQUAL(10, window.getSize());
+    TEST_ASSERT_EQUAL_UINT32(1200, window.getFromHead(0).timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(1110, window.getOldest().timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(1110, window.getFromHead(9).timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(90, window.getSpan_ms());
+    TEST_ASSERT_TRUE(window.coversWindow(90));
+    TEST_ASSERT_FALSE(window.coversWindow(100));
+    TEST_ASSERT_EQUAL_UINT32(0, window.getOverflowCount());
+}
+
+void test_bursty_samples_are_kept(void) {
+    // A count-based window would reject these as "too fast"; here they are all kept
+    TimeWindowedArray<32> window(50);
+    window.push(DataPoint(1000, 1.0f));
+    window.push(DataPoint(1001, 2.0f));
+    window.push(DataPoint(1001, 3.0f)); // same timestamp is fine
+    window.push(DataPoint(1002, 4.0f));
+    TEST_ASSERT_EQUAL(4, window.getSize());
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, window.getMedian().data);
+    DataPoint scratch[8];
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, window.getMedian(scratch).data);
+}
+
+void test_gap_keeps_newest_sample(void) {
+    // A count-based window would be cleared as stale; here the gap just ages out the old data
+    TimeWindowedArray<32> window(50);
+    for (uint32_t t = 1000; t < 1040; t += 10) {
+        window.push(DataPoint(t, 1.0f));
+    }
+    TEST_ASSERT_EQUAL(4, window.getSize());
+    window.push(DataPoint(5000, 9.0f));
+    TEST_ASSERT_EQUAL(1, window.getSize());
+    TEST_ASSERT_EQUAL_FLOAT(9.0f, window.getFromHead(0).data);
+    window.push(DataPoint(5010, 8.0f));
+    TEST_ASSERT_EQUAL(2, window.getSize());
+    TEST_ASSERT_EQUAL_UINT32(10, window.getSpan_ms());
+}
+
+void test_rejects_older_timestamps(void) {
+    TimeWindowedArray<8> window(100);
+    TEST_ASSERT_TRUE(window.push(DataPoint(1000, 1.0f)));
+    TEST_ASSERT_FALSE(window.push(DataPoint(999, 2.0f)));
+    TEST_ASSERT_EQUAL(1, window.getSize());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, window.getFromHead(0).data);
+}
+
+void test_capacity_overflow_drops_oldest(void) {
+    TimeWindowedArray<4> window(1000);
+    for (uint32_t t = 0; t < 6; t++) {
+        window.push(DataPoint(t, static_cast<float>(t)));
+    }
+    TEST_ASSERT_EQUAL(4, window.getSize());
+    TEST_ASSERT_EQUAL_UINT32(2, window.getOverflowCount());
+    TEST_ASSERT_EQUAL_UINT32(2, window.getOldest().timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(5, window.getFromHead(0).timestamp_ms);
+}
+
+void test_clear(void) {
+    TimeWindowedArray<8> window(100);
+    window.push(DataPoint(1000, 1.0f));
+    window.push(DataPoint(1010, 2.0f));
+    window.clear();
+    TEST_ASSERT_TRUE(window.isEmpty());
+    // After a clear any timestamp is accepted again
+    TEST_ASSERT_TRUE(window.push(DataPoint(10, 3.0f)));
+}
+
+// Jittery 100 Hz data: the window must always hold exactly the samples
+// younger than window_ms, no matter how irregular the spacing is.
+void test_jittery_sensor_matches_brute_force(void) {
+    const uint32_t window_ms = 400;
+    TimeWindowedArray<128> window(window_ms);
+    std::mt19937 gen(21);
+    std::uniform_int_distribution<uint32_t> jitter(0, 20);
+    static DataPoint history[5000];
+    uint32_t t = 10000;
+    for (int i = 0; i < 5000; i++) {
+        t += jitter(gen);
+        history[i] = DataPoint(t, static_cast<float>(i));
+        window.push(history[i]);
+
+        int expected = 0;
+        for (int k = i; k >= 0 && t - history[k].timestamp_ms < window_ms; k--) {
+            expected++;
+        }
+        TEST_ASSERT_EQUAL(expected, window.getSize());
+        TEST_ASSERT_EQUAL_UINT32(history[i - expected + 1].timestamp_ms, window.getOldest().timestamp_ms);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, window.getOverflowCount());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_state);
+    RUN_TEST(test_evicts_by_age);
+    RUN_TEST(test_bursty_samples_are_kept);
+    RUN_TEST(test_gap_keeps_newest_sample);
+    RUN_TEST(test_rejects_older_timestamps);
+    RUN_TEST(test_capacity_overflow_drops_oldest);
+    RUN_TEST(test_clear);
+    RUN_TEST(test_jittery_sensor_matches_brute_force);
+    return UNITY_END();
+}
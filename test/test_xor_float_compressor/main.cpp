@@ -0,0 +1,345 @@
+#include "unity.h"
+#include "XorFloatCompressor.h"
+#include "SimpleSimulation.h"
+#include "../CSVMockData.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+    // Teardown code, called after each test if necessary
+}
+
+static const uint8_t ACCELEROMETER_X = 0;
+static const uint8_t ACCELEROMETER_Z = 2;
+static const uint8_t GYROSCOPE_X = 3;
+static const uint8_t ALTITUDE = 5;
+static const uint8_t PRESSURE = 6;
+static const uint8_t TEMPERATURE = 8;
+
+struct Entry {
+    uint8_t name;
+    float value;
+};
+
+typedef XorFloatCompressor<8> Compressor;
+
+// Compresses entries into back-to-back blocks, finishing one whenever it fills
+static void compress(Compressor& compressor, const std::vector<Entry>& entries, std::vector<uint8_t>& log) {
+    uint8_t block[Compressor::MAX_BLOCK_SIZE];
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (!compressor.add(entries[i].name, entries[i].value)) {
+            const std::size_t n = compressor.finishBlock(block);
+            log.insert(log.end(), block, block + n);
+            TEST_ASSERT_TRUE(compressor.add(entries[i].name, entries[i].value));
+        }
+    }
+    const std::size_t n = compressor.finishBlock(block);
+    log.insert(log.end(), block, block + n);
+}
+
+// Decodes every block from offset on; returns false if any block is malformed
+static bool decompress(const std::vector<uint8_t>& log, std::size_t offset, std::vector<Entry>& out) {
+    while (offset < log.size()) {
+        if (log[offset] != 0x7D) {
+            return false;
+        }
+        XorFloatBlockReader<8> reader(&log[offset], log.size() - offset);
+        Entry entry;
+        while (reader.next(entry.name, entry.value)) {
+            out.push_back(entry);
+        }
+        if (!reader.ok() || reader.getRemaining() != 0) {
+            return false;
+        }
+        offset += reader.getBlockSize();
+    }
+    return true;
+}
+
+static void assertSameBits(const Entry& expected, const Entry& actual) {
+    TEST_ASSERT_EQUAL_UINT8(expected.name, actual.name);
+    TEST_ASSERT_EQUAL_HEX32(xor_float::floatBits(expected.value), xor_float::floatBits(actual.value));
+}
+
+void test_round_trip_is_bit_exact(void) {
+    const float specials[] = {0.0f, -0.0f, 1.0f, -1.0f, std::numeric_limits<float>::quiet_NaN(),
+                              std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+                              std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::max(),
+                              std::numeric_limits<float>::lowest(), 1.0f, 1.0f, 1.0f};
+    std::vector<Entry> entries;
+    for (std::size_t i = 0; i < sizeof(specials) / sizeof(specials[0]); i++) {
+        Entry e = {ALTITUDE, specials[i]};
+        entries.push_back(e);
+    }
+    std::default_random_engine rng(7);
+    std::uniform_int_distribution<uint32_t> anyBits;
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    float altitude = 250.0f;
+    for (int i = 0; i < 5000; i++) {
+        altitude += noise(rng);
+        Entry a = {ALTITUDE, altitude};
+        Entry r = {TEMPERATURE, xor_float::bitsFloat(anyBits(rng))};
+        entries.push_back(a);
+        entries.push_back(r);
+    }
+
+    Compressor compressor;
+    compressor.enableSensor(ALTITUDE);
+    compressor.enableSensor(TEMPERATURE);
+    std::vector<uint8_t> log;
+    compress(compressor, entries, log);
+
+    std::vector<Entry> decoded;
+    TEST_ASSERT_TRUE(decompress(log, 0, decoded));
+    TEST_ASSERT_EQUAL(entries.size(), decoded.size());
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        assertSameBits(entries[i], decoded[i]);
+    }
+}
+
+void test_repeated_value_costs_one_bit(void) {
+    XorFloatCompressor<1, 512> compressor;
+    compressor.enableSensor(TEMPERATURE);
+    TEST_ASSERT_TRUE(compressor.add(TEMPERATURE, 21.5f));
+    const std::size_t first = compressor.getBlockSize();
+    for (int i = 0; i < 80; i++) {
+        TEST_ASSERT_TRUE(compressor.add(TEMPERATURE, 21.5f));
+    }
+    TEST_ASSERT_EQUAL(81, compressor.getEntryCount());
+    // A single sensor needs no slot bits: 80 * 1 bit = 10 bytes
+    TEST_ASSERT_EQUAL(first + 10, compressor.getBlockSize());
+
+    // With three sensors every entry carries a 2-bit slot
+    XorFloatCompressor<3, 512> three;
+    three.enableSensor(ALTITUDE);
+    three.enableSensor(PRESSURE);
+    three.enableSensor(TEMPERATURE);
+    TEST_ASSERT_TRUE(three.add(TEMPERATURE, 21.5f));
+    const std::size_t firstOfThree = three.getBlockSize();
+    for (int i = 0; i < 80; i++) {
+        TEST_ASSERT_TRUE(three.add(TEMPERATURE, 21.5f));
+    }
+    TEST_ASSERT_EQUAL(firstOfThree + 30, three.getBlockSize());
+}
+
+void test_only_enabled_sensors_are_accepted(void) {
+    XorFloatCompressor<2> compressor;
+    TEST_ASSERT_TRUE(compressor.enableSensor(ALTITUDE));
+    TEST_ASSERT_TRUE(compressor.enableSensor(ALTITUDE));
+    TEST_ASSERT_TRUE(compressor.enableSensor(PRESSURE));
+    TEST_ASSERT_FALSE(compressor.enableSensor(TEMPERATURE));
+    TEST_ASSERT_TRUE(compressor.isEnabled(PRESSURE));
+    TEST_ASSERT_FALSE(compressor.isEnabled(TEMPERATURE));
+
+    TEST_ASSERT_FALSE(compressor.add(TEMPERATURE, 20.0f));
+    TEST_ASSERT_EQUAL(0, compressor.getEntryCount());
+    uint8_t block[XorFloatCompressor<2>::MAX_BLOCK_SIZE];
+    TEST_ASSERT_EQUAL(0, compressor.finishBlock(block));
+
+    // The slot width can't change in the middle of a block
+    XorFloatCompressor<2> late;
+    late.enableSensor(ALTITUDE);
+    TEST_ASSERT_TRUE(late.add(ALTITUDE, 250.0f));
+    TEST_ASSERT_FALSE(late.enableSensor(PRESSURE));
+    late.finishBlock(block);
+    TEST_ASSERT_TRUE(late.enableSensor(PRESSURE));
+}
+
+void test_full_block_is_refused_until_finished(void) {
+    XorFloatCompressor<1, 16> compressor;
+    compressor.enableSensor(ALTITUDE);
+    std::default_random_engine rng(3);
+    std::uniform_int_distribution<uint32_t> anyBits;
+    int accepted = 0;
+    while (compressor.addBits(ALTITUDE, anyBits(rng))) {
+        accepted++;
+    }
+    TEST_ASSERT_GREATER_THAN(0, accepted);
+    const std::size_t maxBlockSize = XorFloatCompressor<1, 16>::MAX_BLOCK_SIZE;
+    TEST_ASSERT_TRUE(compressor.getBlockSize() <= maxBlockSize);
+    TEST_ASSERT_EQUAL(static_cast<std::size_t>(accepted), compressor.getEntryCount());
+
+    uint8_t block[XorFloatCompressor<1, 16>::MAX_BLOCK_SIZE];
+    TEST_ASSERT_TRUE(compressor.finishBlock(block) > 0);
+    TEST_ASSERT_TRUE(compressor.addBits(ALTITUDE, anyBits(rng)));
+}
+
+void test_decoding_starts_at_any_block(void) {
+    std::vector<Entry> entries;
+    for (int i = 0; i < 3000; i++) {
+        Entry e = {PRESSURE, 1013.25f - i * 0.01f};
+        entries.push_back(e);
+    }
+    XorFloatCompressor<8, 64> compressor;
+    compressor.enableSensor(PRESSURE);
+    std::vector<uint8_t> log;
+    std::vector<std::size_t> blockStarts;
+    std::vector<std::size_t> firstEntry;
+    uint8_t block[XorFloatCompressor<8, 64>::MAX_BLOCK_SIZE];
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (compressor.getEntryCount() == 0) {
+            blockStarts.push_back(log.size());
+            firstEntry.push_back(i);
+        }
+        if (!compressor.add(entries[i].name, entries[i].value)) {
+            const std::size_t n = compressor.finishBlock(block);
+            log.insert(log.end(), block, block + n);
+            blockStarts.push_back(log.size());
+            firstEntry.push_back(i);
+            compressor.add(entries[i].name, entries[i].value);
+        }
+    }
+    const std::size_t n = compressor.finishBlock(block);
+    log.insert(log.end(), block, block + n);
+    TEST_ASSERT_GREATER_THAN(10, blockStarts.size());
+
+    // Start in the middle of the log, as after losing the first pages
+    const std::size_t start = blockStarts.size() / 2;
+    std::vector<Entry> decoded;
+    TEST_ASSERT_TRUE(decompress(log, blockStarts[start], decoded));
+    TEST_ASSERT_EQUAL(entries.size() - firstEntry[start], decoded.size());
+    for (std::size_t i = 0; i < decoded.size(); i++) {
+        assertSameBits(entries[firstEntry[start] + i], decoded[i]);
+    }
+
+    // A corrupted block doesn't affect the next one
+    std::vector<uint8_t> damaged = log;
+    damaged[blockStarts[start + 1] - 1] ^= 0x5A;
+    XorFloatBlockReader<8> next(&damaged[blockStarts[start + 1]], damaged.size() - blockStarts[start + 1]);
+    Entry entry;
+    TEST_ASSERT_TRUE(next.next(entry.name, entry.value));
+    assertSameBits(entries[firstEntry[start + 1]], entry);
+}
+
+void test_truncated_block_is_reported(void) {
+    XorFloatCompressor<1> compressor;
+    compressor.enableSensor(ALTITUDE);
+    for (int i = 0; i < 20; i++) {
+        compressor.add(ALTITUDE, 100.0f + i * 0.37f);
+    }
+    uint8_t block[XorFloatCompressor<1>::MAX_BLOCK_SIZE];
+    const std::size_t n = compressor.finishBlock(block);
+
+    XorFloatBlockReader<1> header(block, 3);
+    TEST_ASSERT_FALSE(header.ok());
+    XorFloatBlockReader<1> payload(block, n - 1);
+    TEST_ASSERT_FALSE(payload.ok());
+    uint8_t name;
+    float value;
+    TEST_ASSERT_FALSE(payload.next(name, value));
+}
+
+// Sensor-like streams: readings are integer counts times a scale factor, as
+// the IMU and baro drivers produce them.
+static std::vector<Entry> simulatedFlight() {
+    std::vector<Entry> entries;
+    SimpleSimulator sim(5000, 60.0f, 3000, 10);
+    std::default_random_engine rng(42);
+    std::normal_distribution<float> counts(0.0f, 2.0f);
+    const float accelScale = 16.0f * 9.81f / 32768.0f;
+    const float gyroScale = 0.0175f * 3.14159265f / 180.0f;
+    float temperature = 24.0f;
+    while (!sim.getHasLanded() && sim.getCurrentTime() < 120000) {
+        sim.tick();
+        const float accel = sim.getIntertialVerticalAcl() + 9.81f;
+        const float ax = std::round(counts(rng)) * accelScale;
+        const float az = std::round(accel / accelScale + counts(rng)) * accelScale;
+        const float gx = std::round(counts(rng)) * gyroScale;
+        const float pressure = std::round((1013.25f - sim.getAltitude() * 0.12f) * 100.0f + counts(rng)) / 100.0f;
+        const float altitude = 44330.0f * (1.0f - std::pow(pressure / 1013.25f, 0.1903f));
+        temperature -= 0.00004f * sim.getVerticalVel();
+        const Entry sample[] = {{ACCELEROMETER_X, ax}, {ACCELEROMETER_Z, az}, {GYROSCOPE_X, gx},
+                                {PRESSURE, pressure}, {ALTITUDE, altitude},
+                                {TEMPERATURE, std::round(temperature * 100.0f) / 100.0f}};
+        entries.insert(entries.end(), sample, sample + 6);
+    }
+    return entries;
+}
+
+static std::vector<Entry> csvFlight(const char* dataset) {
+    std::vector<Entry> entries;
+    CSVDataProvider provider(dataset, 100.0f);
+    while (provider.hasNextDataPoint()) {
+        const SensorData data = provider.getNextDataPoint();
+        const Entry sample[] = {{ACCELEROMETER_X, data.accelx}, {ACCELEROMETER_Z, data.accelz},
+                                {GYROSCOPE_X, data.gyrox}, {PRESSURE, data.pressure},
+                                {ALTITUDE, data.altitude}, {TEMPERATURE, data.temp}};
+        entries.insert(entries.end(), sample, sample + 6);
+    }
+    return entries;
+}
+
+// Compressed size of each sensor on its own against 5-byte Record_ts
+static void reportRatios(const char* label, const std::vector<Entry>& entries, double& ratio) {
+    const uint8_t names[] = {ACCELEROMETER_X, ACCELEROMETER_Z, GYROSCOPE_X, PRESSURE, ALTITUDE, TEMPERATURE};
+    const char* labels[] = {"accel x", "accel z", "gyro x", "pressure", "altitude", "temperature"};
+    std::cout << label << ": " << entries.size() << " values\n";
+    for (std::size_t s = 0; s < sizeof(names) / sizeof(names[0]); s++) {
+        std::vector<Entry> channel;
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].name == names[s]) {
+                channel.push_back(entries[i]);
+            }
+        }
+        Compressor compressor;
+        compressor.enableSensor(names[s]);
+        std::vector<uint8_t> log;
+        compress(compressor, channel, log);
+        const std::size_t bytes = log.size();
+        std::cout << "  " << std::setw(12) << std::left << labels[s] << std::right << std::fixed
+                  << std::setprecision(2) << static_cast<double>(channel.size() * 5) / bytes << "x\n";
+    }
+
+    Compressor compressor;
+    for (std::size_t s = 0; s < sizeof(names) / sizeof(names[0]); s++) {
+        compressor.enableSensor(names[s]);
+    }
+    std::vector<uint8_t> log;
+    compress(compressor, entries, log);
+    std::vector<Entry> decoded;
+    TEST_ASSERT_TRUE(decompress(log, 0, decoded));
+    TEST_ASSERT_EQUAL(entries.size(), decoded.size());
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        assertSameBits(entries[i], decoded[i]);
+    }
+    ratio = static_cast<double>(entries.size() * 5) / log.size();
+    std::cout << "  all, interleaved: " << entries.size() * 5 << " -> " << log.size() << " bytes ("
+              << ratio << "x)\n";
+}
+
+void test_compression_ratio_on_flight_data(void) {
+    double simulated = 0.0;
+    reportRatios("simulated flight", simulatedFlight(), simulated);
+    TEST_ASSERT_TRUE(simulated > 1.3);
+
+    // The flight CSVs are not in the repo; see data/README.md
+    const char* dataset = "data/data_transformed.csv";
+    if (std::ifstream(dataset).good()) {
+        double recorded = 0.0;
+        reportRatios(dataset, csvFlight(dataset), recorded);
+        TEST_ASSERT_TRUE(recorded > 1.0);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_is_bit_exact);
+    RUN_TEST(test_repeated_value_costs_one_bit);
+    RUN_TEST(test_only_enabled_sensors_are_accepted);
+    RUN_TEST(test_full_block_is_refused_until_finished);
+    RUN_TEST(test_decoding_starts_at_any_block);
+    RUN_TEST(test_truncated_block_is_reported);
+    RUN_TEST(test_compression_ratio_on_flight_data);
+    return UNITY_END();
+}